@@ -880,9 +880,13 @@ class SkAAClip::Builder {
     struct Row {
         int fY;
         int fWidth;
-        SkTDArray<uint8_t>* fData;
+        int fOffset;    // start of this row's runs in fRunData
     };
     SkTDArray<Row>  fRows;
+    // The runs of every row, in row order. Only the last row is ever
+    // appended to, so they can share one buffer instead of each row
+    // allocating its own, and finish() copies them all at once.
+    SkTDArray<uint8_t> fRunData;
     Row* fCurrRow;
     int fPrevY;
     int fWidth;
@@ -896,15 +900,6 @@ public:
         fMinY = bounds.fTop;
     }
 
-    ~Builder() {
-        Row* row = fRows.begin();
-        Row* stop = fRows.end();
-        while (row < stop) {
-            delete row->fData;
-            row += 1;
-        }
-    }
-
     const SkIRect& getBounds() const { return fBounds; }
 
     void addRun(int x, int y, U8CPU alpha, int count) {
@@ -922,15 +917,15 @@ public:
             row = this->flushRow(true);
             row->fY = y;
             row->fWidth = 0;
-            SkASSERT(row->fData);
-            SkASSERT(0 == row->fData->count());
+            SkASSERT(row->fOffset == fRunData.count());
             fCurrRow = row;
         }
 
         SkASSERT(row->fWidth <= x);
         SkASSERT(row->fWidth < fBounds.width());
 
-        SkTDArray<uint8_t>& data = *row->fData;
+        SkASSERT(row == fRows.end() - 1);
+        SkTDArray<uint8_t>& data = fRunData;
 
         int gap = x - row->fWidth;
         if (gap) {
@@ -1003,15 +998,7 @@ public:
     bool finish(SkAAClip* target) {
         this->flushRow(false);
 
-        const Row* row = fRows.begin();
-        const Row* stop = fRows.end();
-
-        size_t dataSize = 0;
-        while (row < stop) {
-            dataSize += row->fData->count();
-            row += 1;
-        }
-
+        size_t dataSize = fRunData.count();
         if (0 == dataSize) {
             return target->setEmpty();
         }
@@ -1023,27 +1010,23 @@ public:
 
         RunHead* head = RunHead::Alloc(fRows.count(), dataSize);
         YOffset* yoffset = head->yoffsets();
-        uint8_t* data = head->data();
-        uint8_t* baseData = data;
+        memcpy(head->data(), fRunData.begin(), dataSize);
 
-        row = fRows.begin();
+        const Row* row = fRows.begin();
+        const Row* stop = fRows.end();
         SkDEBUGCODE(int prevY = row->fY - 1;)
-        while (row < stop) {
+        for (int i = 0; row < stop; ++i) {
             SkASSERT(prevY < row->fY);  // must be monotonic
             SkDEBUGCODE(prevY = row->fY);
 
             yoffset->fY = row->fY - adjustY;
-            yoffset->fOffset = SkToU32(data - baseData);
+            yoffset->fOffset = SkToU32(row->fOffset);
             yoffset += 1;
-
-            size_t n = row->fData->count();
-            memcpy(data, row->fData->begin(), n);
 #ifdef SK_DEBUG
-            size_t bytesNeeded = compute_row_length(data, fBounds.width());
-            SkASSERT(bytesNeeded == n);
+            size_t bytesNeeded = compute_row_length(head->data() + row->fOffset,
+                                                    fBounds.width());
+            SkASSERT(bytesNeeded == (size_t)this->rowDataCount(i));
 #endif
-            data += n;
-
             row += 1;
         }
 
@@ -1059,10 +1042,9 @@ public:
         for (y = 0; y < fRows.count(); ++y) {
             const Row& row = fRows[y];
             SkDebugf("Y:%3d W:%3d", row.fY, row.fWidth);
-            const SkTDArray<uint8_t>& data = *row.fData;
-            int count = data.count();
+            int count = this->rowDataCount(y);
             SkASSERT(!(count & 1));
-            const uint8_t* ptr = data.begin();
+            const uint8_t* ptr = fRunData.begin() + row.fOffset;
             for (int x = 0; x < count; x += 2) {
                 SkDebugf(" [%3d:%02X]", ptr[0], ptr[1]);
                 ptr += 2;
@@ -1081,8 +1063,8 @@ public:
             const Row& row = fRows[i];
             SkASSERT(prevY < row.fY);
             SkASSERT(fWidth == row.fWidth);
-            int count = row.fData->count();
-            const uint8_t* ptr = row.fData->begin();
+            int count = this->rowDataCount(i);
+            const uint8_t* ptr = fRunData.begin() + row.fOffset;
             SkASSERT(!(count & 1));
             int w = 0;
             for (int x = 0; x < count; x += 2) {
@@ -1104,10 +1086,17 @@ public:
     }
 
 private:
+    // Number of run bytes in row i.
+    int rowDataCount(int i) const {
+        int stop = (i + 1 < fRows.count()) ? fRows[i + 1].fOffset : fRunData.count();
+        return stop - fRows[i].fOffset;
+    }
+
     void flushRowH(Row* row) {
         // flush current row if needed
         if (row->fWidth < fWidth) {
-            AppendRun(*row->fData, 0, fWidth - row->fWidth);
+            SkASSERT(row == fRows.end() - 1);
+            AppendRun(fRunData, 0, fWidth - row->fWidth);
             row->fWidth = fWidth;
         }
     }
@@ -1124,25 +1113,27 @@ private:
             Row* curr = &fRows[count - 1];
             SkASSERT(prev->fWidth == fWidth);
             SkASSERT(curr->fWidth == fWidth);
-            if (*prev->fData == *curr->fData) {
+            int prevCount = this->rowDataCount(count - 2);
+            if (prevCount == this->rowDataCount(count - 1) &&
+                !memcmp(fRunData.begin() + prev->fOffset,
+                        fRunData.begin() + curr->fOffset, prevCount)) {
                 prev->fY = curr->fY;
+                fRunData.setCount(curr->fOffset);
                 if (readyForAnother) {
-                    curr->fData->rewind();
                     next = curr;
                 } else {
-                    delete curr->fData;
                     fRows.removeShuffle(count - 1);
                 }
             } else {
                 if (readyForAnother) {
                     next = fRows.append();
-                    next->fData = new SkTDArray<uint8_t>;
+                    next->fOffset = fRunData.count();
                 }
             }
         } else {
             if (readyForAnother) {
                 next = fRows.append();
-                next->fData = new SkTDArray<uint8_t>;
+                next->fOffset = fRunData.count();
             }
         }
         return next;
@@ -1753,6 +1744,14 @@ bool SkAAClip::translate(int dx, int dy, SkAAClip* dst) const {
     return true;
 }
 
+size_t SkAAClip::getRunBytes() const {
+    if (this->isEmpty()) {
+        return 0;
+    }
+    return sizeof(RunHead) + fRunHead->fRowCount * sizeof(YOffset) +
+           fRunHead->fDataSize;
+}
+
 static void expand_row_to_mask(uint8_t* SK_RESTRICT mask,
                                const uint8_t* SK_RESTRICT row,
                                int width) {
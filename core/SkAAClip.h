@@ -54,6 +54,11 @@ public:
      */
     void copyToMask(SkMask*) const;
 
+    /**
+     *  Returns the size of the run data, which copies of this aaclip share.
+     */
+    size_t getRunBytes() const;
+
     // called internally
 
     bool quickContains(int left, int top, int right, int bottom) const;
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkAAClipCache.h"
+#include "SkAAClip.h"
+#include "SkChecksum.h"
+#include "SkFloatBits.h"
+#include "SkPath.h"
+#include "SkTDArray.h"
+#include "SkTDynamicHash.h"
+#include "SkTInternalLList.h"
+#include "SkThread.h"
+
+// Masks are kept unclipped, so paths much larger than any device are not
+// worth building in full.
+static const int kMaxCachedDimension = 4096;
+
+// Nor are paths that are much larger than the clip they are drawn into.
+static const int kMaxPathToClipAreaRatio = 2;
+
+namespace {
+
+struct ClipKey {
+    const int32_t*  fWords;
+    int             fCount;
+    uint32_t        fHash;
+
+    ClipKey(const int32_t words[], int count)
+        : fWords(words)
+        , fCount(count)
+        , fHash(SkChecksum::Compute(reinterpret_cast<const uint32_t*>(words),
+                                    count * sizeof(int32_t))) {}
+
+    bool operator==(const ClipKey& other) const {
+        return fHash == other.fHash && fCount == other.fCount &&
+               !memcmp(fWords, other.fWords, fCount * sizeof(int32_t));
+    }
+};
+
+struct Rec {
+    SK_DECLARE_INTERNAL_LLIST_INTERFACE(Rec);
+
+    Rec(const ClipKey& key, const SkAAClip& mask)
+        : fKey(key)
+        , fMask(mask)
+        , fBytes(mask.getRunBytes() + key.fCount * sizeof(int32_t)) {
+        // key points at the caller's words, so keep a copy
+        int32_t* words = (int32_t*)sk_malloc_throw(key.fCount * sizeof(int32_t));
+        memcpy(words, key.fWords, key.fCount * sizeof(int32_t));
+        fKey.fWords = words;
+    }
+
+    ~Rec() {
+        sk_free(const_cast<int32_t*>(fKey.fWords));
+    }
+
+    static const ClipKey& GetKey(const Rec& rec) { return rec.fKey; }
+    static uint32_t Hash(const ClipKey& key) { return key.fHash; }
+    static bool Equal(const Rec& rec, const ClipKey& key) { return rec.fKey == key; }
+
+    ClipKey     fKey;
+    SkAAClip    fMask;
+    size_t      fBytes;
+};
+
+typedef SkTDynamicHash<Rec, ClipKey, Rec::GetKey, Rec::Hash, Rec::Equal> RecHash;
+
+// The hashes of the last few keys added, the oldest being replaced first. A
+// hash collision only costs a cache miss, or building a mask that is not kept.
+class RecentKeys {
+public:
+    RecentKeys() : fCount(0), fNext(0) {}
+
+    bool contains(const ClipKey& key) const {
+        for (int i = 0; i < fCount; ++i) {
+            if (fHashes[i] == key.fHash) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void add(const ClipKey& key) {
+        fHashes[fNext] = key.fHash;
+        fNext = (fNext + 1) % kCount;
+        fCount = SkTMin(fCount + 1, (int)kCount);
+    }
+
+private:
+    enum { kCount = 32 };
+    uint32_t    fHashes[kCount];
+    int         fCount;
+    int         fNext;
+};
+
+// Most recently used at the head.
+struct ClipCache {
+    RecHash                 fHash;
+    SkTInternalLList<Rec>   fLRU;
+    size_t                  fBytesUsed;
+    size_t                  fByteLimit;
+    // Keys that missed once. A mask is only built in full and added on its
+    // key's second miss, so that paths that keep moving by fractions of a
+    // pixel (and so never hit) do not churn the cache.
+    RecentKeys              fMissed;
+    // Keys whose masks were too large to add, so that they are not built in
+    // full again.
+    RecentKeys              fRejected;
+
+    ClipCache() : fBytesUsed(0), fByteLimit(SK_DEFAULT_AACLIP_CACHE_LIMIT) {}
+
+    void purgeAsNeeded() {
+        while (fBytesUsed > fByteLimit) {
+            Rec* rec = fLRU.tail();
+            if (NULL == rec) {
+                break;
+            }
+            fLRU.remove(rec);
+            fHash.remove(rec->fKey);
+            fBytesUsed -= rec->fBytes;
+            SkDELETE(rec);
+        }
+    }
+};
+
+}  // namespace
+
+SK_DECLARE_STATIC_MUTEX(gMutex);
+static ClipCache* gCache;
+
+// Must be called with gMutex held.
+static ClipCache* get_cache() {
+    if (NULL == gCache) {
+        gCache = SkNEW(ClipCache);
+    }
+    return gCache;
+}
+
+enum FindResult {
+    kFound_FindResult,
+    // Missed before: worth building in full and adding.
+    kBuild_FindResult,
+    // Not worth building in full, the caller should clip it as it builds it.
+    kSkip_FindResult,
+};
+
+static FindResult find_mask(const ClipKey& key, SkAAClip* mask) {
+    SkAutoMutexAcquire ama(gMutex);
+    ClipCache* cache = get_cache();
+
+    Rec* rec = cache->fHash.find(key);
+    if (NULL == rec) {
+        if (cache->fRejected.contains(key)) {
+            return kSkip_FindResult;
+        }
+        if (cache->fMissed.contains(key)) {
+            return kBuild_FindResult;
+        }
+        cache->fMissed.add(key);
+        return kSkip_FindResult;
+    }
+    cache->fLRU.remove(rec);
+    cache->fLRU.addToHead(rec);
+    *mask = rec->fMask;
+    return kFound_FindResult;
+}
+
+static void add_mask(const ClipKey& key, const SkAAClip& mask) {
+    SkAutoMutexAcquire ama(gMutex);
+    ClipCache* cache = get_cache();
+
+    if (NULL != cache->fHash.find(key)) {
+        return;
+    }
+    Rec* rec = SkNEW_ARGS(Rec, (key, mask));
+    if (rec->fBytes > cache->fByteLimit) {
+        // it would only push everything else out, and then itself
+        SkDELETE(rec);
+        cache->fRejected.add(key);
+        return;
+    }
+    cache->fHash.add(rec);
+    cache->fLRU.addToHead(rec);
+    cache->fBytesUsed += rec->fBytes;
+    cache->purgeAsNeeded();
+}
+
+// The points are offset the same way SkPath::offset() does, so the key
+// matches the path the mask is built from bit for bit.
+static void append_points(SkTDArray<int32_t>* key, const SkPoint pts[], int count,
+                          SkScalar dx, SkScalar dy) {
+    for (int i = 0; i < count; i++) {
+        *key->append() = SkFloat2Bits(pts[i].fX + dx);
+        *key->append() = SkFloat2Bits(pts[i].fY + dy);
+    }
+}
+
+static void build_key(const SkPath& path, SkScalar dx, SkScalar dy,
+                      SkTDArray<int32_t>* key) {
+    key->setReserve(1 + path.countVerbs() + 2 * path.countPoints());
+    *key->append() = path.getFillType();
+
+    SkPath::RawIter iter(path);
+    SkPoint         pts[4];
+    SkPath::Verb    verb;
+    while ((verb = iter.next(pts)) != SkPath::kDone_Verb) {
+        *key->append() = verb;
+        switch (verb) {
+            case SkPath::kMove_Verb:
+                append_points(key, pts, 1, dx, dy);
+                break;
+            case SkPath::kLine_Verb:
+                append_points(key, &pts[1], 1, dx, dy);
+                break;
+            case SkPath::kQuad_Verb:
+                append_points(key, &pts[1], 2, dx, dy);
+                break;
+            case SkPath::kConic_Verb:
+                append_points(key, &pts[1], 2, dx, dy);
+                *key->append() = SkFloat2Bits(iter.conicWeight());
+                break;
+            case SkPath::kCubic_Verb:
+                append_points(key, &pts[1], 3, dx, dy);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+bool SkAAClipCache::SetPath(const SkPath& path, const SkIRect& bounds, SkAAClip* clip) {
+    if (path.isInverseFillType() || path.isRect(NULL)) {
+        return false;
+    }
+    const SkRect& pathBounds = path.getBounds();
+    if (!pathBounds.isFinite()) {
+        return false;
+    }
+    SkIRect ibounds;
+    pathBounds.roundOut(&ibounds);
+    if (ibounds.isEmpty() ||
+            ibounds.width() > kMaxCachedDimension ||
+            ibounds.height() > kMaxCachedDimension) {
+        return false;
+    }
+    const int64_t pathArea = sk_64_mul(ibounds.width(), ibounds.height());
+    const int64_t clipArea = sk_64_mul(bounds.width(), bounds.height());
+    if (pathArea > kMaxPathToClipAreaRatio * clipArea) {
+        return false;
+    }
+
+    // Move the path to start in the [0, 1) pixel, so that whole pixel
+    // translations of it share a mask.
+    const int dx = SkScalarFloorToInt(pathBounds.fLeft);
+    const int dy = SkScalarFloorToInt(pathBounds.fTop);
+
+    SkTDArray<int32_t> words;
+    build_key(path, -SkIntToScalar(dx), -SkIntToScalar(dy), &words);
+    ClipKey key(words.begin(), words.count());
+
+    SkAAClip mask;
+    switch (find_mask(key, &mask)) {
+        case kFound_FindResult:
+            break;
+        case kBuild_FindResult: {
+            SkPath moved;
+            path.offset(-SkIntToScalar(dx), -SkIntToScalar(dy), &moved);
+            mask.setPath(moved, NULL, true);
+            add_mask(key, mask);
+            break;
+        }
+        case kSkip_FindResult:
+            return false;
+    }
+
+    mask.translate(dx, dy, clip);
+    clip->op(bounds, SkRegion::kIntersect_Op);
+    return true;
+}
+
+size_t SkAAClipCache::GetByteLimit() {
+    SkAutoMutexAcquire ama(gMutex);
+    return get_cache()->fByteLimit;
+}
+
+size_t SkAAClipCache::SetByteLimit(size_t newLimit) {
+    SkAutoMutexAcquire ama(gMutex);
+    ClipCache* cache = get_cache();
+    size_t prevLimit = cache->fByteLimit;
+    cache->fByteLimit = newLimit;
+    cache->purgeAsNeeded();
+    return prevLimit;
+}
+
+size_t SkAAClipCache::GetBytesUsed() {
+    SkAutoMutexAcquire ama(gMutex);
+    return get_cache()->fBytesUsed;
+}
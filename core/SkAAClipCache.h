@@ -0,0 +1,56 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkAAClipCache_DEFINED
+#define SkAAClipCache_DEFINED
+
+#include "SkTypes.h"
+
+class SkAAClip;
+class SkPath;
+struct SkIRect;
+
+#ifndef SK_DEFAULT_AACLIP_CACHE_LIMIT
+    #define SK_DEFAULT_AACLIP_CACHE_LIMIT   (512 * 1024)
+#endif
+
+/**
+ *  Process-wide cache of antialiased clip masks, so that a clip path that is
+ *  applied over and over (every frame, or once per tile) is only scan
+ *  converted once.
+ *
+ *  Masks are keyed by the device space path, moved so that its bounds start
+ *  in the [0, 1) pixel, and stored without being clipped. A path that is only
+ *  translated by whole pixels (as when each tile offsets the same picture)
+ *  finds the same mask, which is moved back and intersected with the clip
+ *  bounds. SkAAClip shares its runs on copy and translate, so a hit costs a
+ *  pass over the path to build the key, and a rect intersection.
+ *
+ *  A mask is only built in full, and added, the second time its key misses,
+ *  and only if the path is not much larger than the clip bounds. Until then
+ *  (and for masks too large to keep) the caller builds a clipped mask as if
+ *  there were no cache.
+ *
+ *  The cache purges the least recently used masks once their total size goes
+ *  over the limit. Safe to use from any thread.
+ */
+class SkAAClipCache {
+public:
+    /**
+     *  Set clip to the antialiased coverage of path within bounds, reusing or
+     *  adding a cached mask. Returns false, leaving clip untouched, if the
+     *  path is not worth caching (inverse filled, a rect, too large, or not
+     *  seen before); the caller then builds the clip itself.
+     */
+    static bool SetPath(const SkPath& path, const SkIRect& bounds, SkAAClip* clip);
+
+    static size_t GetByteLimit();
+    static size_t SetByteLimit(size_t newLimit);
+    static size_t GetBytesUsed();
+};
+
+#endif
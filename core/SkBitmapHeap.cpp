@@ -223,6 +223,7 @@ size_t SkBitmapHeap::freeMemoryIfPossible(size_t bytesToFree) {
             // Everything was evicted
             fMostRecentlyUsed = NULL;
             fBytesAllocated -= (fStorage.count() * sizeof(SkBitmapHeapEntry));
+            SkAutoMutexAcquire ama(fStorageMutex);
             fStorage.deleteAll();
             fUnusedSlots.reset();
             SkASSERT(0 == fBytesAllocated);
@@ -334,7 +335,10 @@ int32_t SkBitmapHeap::insert(const SkBitmap& originalBitmap) {
             entry = fStorage[slot];
         } else {
             entry = SkNEW(SkBitmapHeapEntry);
-            fStorage.append(1, &entry);
+            {
+                SkAutoMutexAcquire ama(fStorageMutex);
+                fStorage.append(1, &entry);
+            }
             entry->fSlot = fStorage.count() - 1;
             fBytesAllocated += sizeof(SkBitmapHeapEntry);
         }
@@ -356,7 +360,10 @@ int32_t SkBitmapHeap::insert(const SkBitmap& originalBitmap) {
         // If entry is the last slot in storage, it is safe to delete it.
         if (fStorage.count() - 1 == entry->fSlot) {
             // free the slot
-            fStorage.remove(entry->fSlot);
+            {
+                SkAutoMutexAcquire ama(fStorageMutex);
+                fStorage.remove(entry->fSlot);
+            }
             fBytesAllocated -= sizeof(SkBitmapHeapEntry);
             SkDELETE(entry);
         } else {
@@ -169,10 +169,11 @@ public:
      * @return  a SkBitmapHeapEntry that wraps the bitmap or NULL if external storage is used.
      */
     SkBitmapHeapEntry* getEntry(int32_t slot) const {
-        SkASSERT(slot <= fStorage.count());
         if (fExternalStorage != NULL) {
             return NULL;
         }
+        SkAutoMutexAcquire ama(fStorageMutex);
+        SkASSERT(slot <= fStorage.count());
         return fStorage[slot];
     }
 
@@ -286,6 +287,11 @@ private:
 
     // heap storage
     SkTDArray<SkBitmapHeapEntry*> fStorage;
+    // Only the owner adds or removes entries, but a reader can look them up
+    // from another thread (e.g. SkDeferredCanvas's playback thread) while it
+    // does. This guards the array against being reallocated under getEntry();
+    // the entries themselves are kept alive by their reference counts.
+    mutable SkMutex fStorageMutex;
     // Used to mark slots in fStorage as deleted without actually deleting
     // the slot so as not to mess up the numbering.
     SkTDArray<int> fUnusedSlots;
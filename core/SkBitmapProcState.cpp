@@ -14,6 +14,7 @@
 #include "SkBitmapScaler.h"
 #include "SkMipMap.h"
 #include "SkPixelRef.h"
+#include "SkRTConf.h"
 #include "SkScaledImageCache.h"
 
 #if !SK_ARM_NEON_IS_NONE
@@ -34,6 +35,8 @@ extern void  Clamp_SI8_opaque_D32_filter_DX_shaderproc_neon(const SkBitmapProcSt
 
 ///////////////////////////////////////////////////////////////////////////////
 
+SK_CONF_DECLARE(bool, c_lazyMipMaps, "bitmap.lazyMipMaps", false, "Build each mipmap level the first time it is drawn, instead of all of them at once");
+
 // true iff the matrix contains, at most, scale and translate elements
 static bool matrix_only_scale_translate(const SkMatrix& m) {
     return m.getType() <= (SkMatrix::kScale_Mask | SkMatrix::kTranslate_Mask);
@@ -259,7 +262,9 @@ bool SkBitmapProcState::possiblyScaleImage() {
         fScaledCacheID = SkScaledImageCache::FindAndLockMip(fOrigBitmap, &mip);
         if (!fScaledCacheID) {
             SkASSERT(NULL == mip);
-            mip = SkMipMap::Build(fOrigBitmap);
+            mip = SkMipMap::Build(fOrigBitmap, c_lazyMipMaps ?
+                                  SkMipMap::kLazy_BuildMode :
+                                  SkMipMap::kEager_BuildMode);
             if (mip) {
                 fScaledCacheID = SkScaledImageCache::AddAndLockMip(fOrigBitmap,
                                                                    mip);
@@ -292,8 +297,65 @@ bool SkBitmapProcState::possiblyScaleImage() {
     return false;
 }
 
+/*
+ *  Returns how many times (at most 3, the smallest scale a JPEG decoder can
+ *  produce directly) the bitmap can be halved before it is drawn through
+ *  inv without losing detail, or 0. Only for clamped scale+translate draws,
+ *  so that the matrix can simply be rescaled to the smaller bitmap.
+ */
+static int decode_pow2_for_matrix(const SkMatrix& inv,
+                                  SkShader::TileMode tileModeX,
+                                  SkShader::TileMode tileModeY) {
+    if (SkShader::kClamp_TileMode != tileModeX ||
+        SkShader::kClamp_TileMode != tileModeY ||
+        (inv.getType() & ~(SkMatrix::kScale_Mask | SkMatrix::kTranslate_Mask))) {
+        return 0;
+    }
+    const SkScalar minScale = SkMinScalar(SkScalarAbs(inv.getScaleX()),
+                                          SkScalarAbs(inv.getScaleY()));
+    int pow2 = 0;
+    while (pow2 < 3 && minScale >= SkIntToScalar(2 << pow2)) {
+        pow2 += 1;
+    }
+    return pow2;
+}
+
+/*
+ *  Sets dst to the part of src's pixel ref that src covers, rounded out to
+ *  whole samples of 2^pow2 pixels (but not past the pixel ref's edges), and
+ *  returns how far src starts into it.
+ *
+ *  Decoding that at 1/2^pow2 scale maps it exactly onto the decoded pixels,
+ *  wherever src starts; an unaligned subset would have to be rounded out by
+ *  the decoder, to an origin and size that do not scale back exactly.
+ */
+static SkIPoint align_to_samples(const SkBitmap& src, int pow2, SkBitmap* dst) {
+    SkPixelRef* pr = src.pixelRef();
+    const SkIPoint& origin = src.pixelRefOrigin();
+    const int mask = (1 << pow2) - 1;
+    const SkIRect aligned = SkIRect::MakeLTRB(
+            origin.fX & ~mask,
+            origin.fY & ~mask,
+            SkTMin((origin.fX + src.width() + mask) & ~mask, pr->info().fWidth),
+            SkTMin((origin.fY + src.height() + mask) & ~mask, pr->info().fHeight));
+
+    SkImageInfo info;
+    if (!src.asImageInfo(&info)) {
+        *dst = src;
+        return SkIPoint::Make(0, 0);
+    }
+    info.fWidth = aligned.width();
+    info.fHeight = aligned.height();
+    dst->setConfig(info);
+    dst->setPixelRef(pr, aligned.fLeft, aligned.fTop);
+    return SkIPoint::Make(origin.fX - aligned.fLeft, origin.fY - aligned.fTop);
+}
+
 static bool get_locked_pixels(const SkBitmap& src, int pow2, SkBitmap* dst) {
     SkPixelRef* pr = src.pixelRef();
+    // dst starts out as src, so that the pixel ref can see which part of it
+    // (pixelRefOrigin() and size) is being drawn.
+    *dst = src;
     if (pr && pr->decodeInto(pow2, dst)) {
         return true;
     }
@@ -323,34 +385,58 @@ bool SkBitmapProcState::lockBaseBitmap() {
             return false;
         }
     } else {
-        fScaledCacheID = SkScaledImageCache::FindAndLock(fOrigBitmap,
-                                                         SK_Scalar1, SK_Scalar1,
-                                                         &fScaledBitmap);
-        if (fScaledCacheID) {
-            fScaledBitmap.lockPixels();
-            if (!fScaledBitmap.getPixels()) {
-                fScaledBitmap.unlockPixels();
-                // found a purged entry (discardablememory?), release it
-                SkScaledImageCache::Unlock(fScaledCacheID);
-                fScaledCacheID = NULL;
-                // fall through to rebuild
-            }
-        }
-
-        if (NULL == fScaledCacheID) {
-            if (!get_locked_pixels(fOrigBitmap, 0, &fScaledBitmap)) {
+        // A pixel ref that decodes on demand can decode a downscaled draw at
+        // a smaller size. It caches that itself: entries here are keyed by
+        // the draw's inverse scale (see possiblyScaleImage()), which a
+        // decode scale must not be mistaken for.
+        const int pow2 = decode_pow2_for_matrix(fInvMatrix, fTileModeX, fTileModeY);
+        if (pow2 > 0) {
+            SkBitmap aligned;
+            const SkIPoint offset = align_to_samples(fOrigBitmap, pow2, &aligned);
+            if (!get_locked_pixels(aligned, pow2, &fScaledBitmap)) {
                 return false;
             }
+            fInvMatrix.postTranslate(SkIntToScalar(offset.fX), SkIntToScalar(offset.fY));
+            // The last sample may be partial, and rounded either way.
+            const int sample = 1 << pow2;
+            const int w = fScaledBitmap.width();
+            const int h = fScaledBitmap.height();
+            if ((w == aligned.width() >> pow2 || w == (aligned.width() + sample - 1) >> pow2) &&
+                (h == aligned.height() >> pow2 || h == (aligned.height() + sample - 1) >> pow2)) {
+                const SkScalar scale = SK_Scalar1 / sample;
+                fInvMatrix.postScale(scale, scale);
+            } else if (w != aligned.width() || h != aligned.height()) {
+                // The decoder picked some other size.
+                fInvMatrix.postScale(SkIntToScalar(w) / aligned.width(),
+                                     SkIntToScalar(h) / aligned.height());
+            }
+        } else {
+            fScaledCacheID = SkScaledImageCache::FindAndLock(fOrigBitmap,
+                                                             SK_Scalar1, SK_Scalar1,
+                                                             &fScaledBitmap);
+            if (fScaledCacheID) {
+                fScaledBitmap.lockPixels();
+                if (!fScaledBitmap.getPixels()) {
+                    fScaledBitmap.unlockPixels();
+                    // found a purged entry (discardablememory?), release it
+                    SkScaledImageCache::Unlock(fScaledCacheID);
+                    fScaledCacheID = NULL;
+                    // fall through to rebuild
+                }
+            }
 
-            // TODO: if fScaled comes back at a different width/height than fOrig,
-            // we need to update the matrix we are using to sample from this guy.
-
-            fScaledCacheID = SkScaledImageCache::AddAndLock(fOrigBitmap,
-                                                            SK_Scalar1, SK_Scalar1,
-                                                            fScaledBitmap);
-            if (!fScaledCacheID) {
-                fScaledBitmap.reset();
-                return false;
+            if (NULL == fScaledCacheID) {
+                if (!get_locked_pixels(fOrigBitmap, 0, &fScaledBitmap)) {
+                    return false;
+                }
+
+                fScaledCacheID = SkScaledImageCache::AddAndLock(fOrigBitmap,
+                                                                SK_Scalar1, SK_Scalar1,
+                                                                fScaledBitmap);
+                if (!fScaledCacheID) {
+                    fScaledBitmap.reset();
+                    return false;
+                }
             }
         }
     }
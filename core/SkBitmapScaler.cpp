@@ -4,6 +4,81 @@
 #include "SkTArray.h"
 #include "SkErrorInternals.h"
 #include "SkConvolver.h"
+#include "SkRefCnt.h"
+#include "SkTDArray.h"
+#include "SkThread.h"
+
+// SkResizeFilter cache ----------------------------------------------------------
+
+// Resizing many images between the same sizes (e.g. when making thumbnails)
+// computes the same filters over and over, so the most recently used ones are
+// kept around.
+namespace {
+
+struct FilterKey {
+    SkBitmapScaler::ResizeMethod fMethod;
+    int fSrcSize;
+    int fDestSize;
+    int fDestSubsetLo;
+    int fDestSubsetSize;
+    SkConvolveFilterPadding_pointer fApplySIMDPadding;
+
+    bool operator==(const FilterKey& other) const {
+        return fMethod == other.fMethod &&
+               fSrcSize == other.fSrcSize &&
+               fDestSize == other.fDestSize &&
+               fDestSubsetLo == other.fDestSubsetLo &&
+               fDestSubsetSize == other.fDestSubsetSize &&
+               fApplySIMDPadding == other.fApplySIMDPadding;
+    }
+};
+
+// A computed filter. It isn't changed once it is in the cache, so several
+// resizes can use it at once.
+class CachedFilter : public SkRefCnt {
+public:
+    explicit CachedFilter(const FilterKey& key) : fKey(key) {}
+
+    const FilterKey fKey;
+    SkConvolutionFilter1D fFilter;
+};
+
+}  // namespace
+
+static const int kMaxCachedFilters = 16;
+
+SK_DECLARE_STATIC_MUTEX(gFilterCacheMutex);
+// Most recently used first. The cache holds a reference to each filter.
+static SkTDArray<CachedFilter*>* gFilterCache;
+
+// Returns a ref'd filter, or NULL if there is none for key.
+static CachedFilter* find_cached_filter(const FilterKey& key) {
+    SkAutoMutexAcquire ama(gFilterCacheMutex);
+    if (NULL == gFilterCache) {
+        return NULL;
+    }
+    for (int i = 0; i < gFilterCache->count(); i++) {
+        CachedFilter* filter = (*gFilterCache)[i];
+        if (filter->fKey == key) {
+            gFilterCache->remove(i);
+            *gFilterCache->insert(0) = filter;
+            return SkRef(filter);
+        }
+    }
+    return NULL;
+}
+
+static void add_cached_filter(CachedFilter* filter) {
+    SkAutoMutexAcquire ama(gFilterCacheMutex);
+    if (NULL == gFilterCache) {
+        gFilterCache = SkNEW(SkTDArray<CachedFilter*>);
+    }
+    if (gFilterCache->count() == kMaxCachedFilters) {
+        gFilterCache->top()->unref();
+        gFilterCache->pop();
+    }
+    *gFilterCache->insert(0) = SkRef(filter);
+}
 
 // SkResizeFilter ----------------------------------------------------------------
 
@@ -21,13 +96,22 @@ public:
     }
 
     // Returns the filled filter values.
-    const SkConvolutionFilter1D& xFilter() { return fXFilter; }
-    const SkConvolutionFilter1D& yFilter() { return fYFilter; }
+    const SkConvolutionFilter1D& xFilter() { return fXFilter->fFilter; }
+    const SkConvolutionFilter1D& yFilter() { return fYFilter->fFilter; }
 
 private:
 
+    SkBitmapScaler::ResizeMethod fMethod;
+
+    // Only created when a filter isn't in the cache.
     SkBitmapFilter* fBitmapFilter;
 
+    // Returns the (ref'd) filter for one direction, from the cache if
+    // possible.
+    CachedFilter* getFilter(int srcSize, int destSize,
+                            int destSubsetLo, int destSubsetSize,
+                            const SkConvolutionProcs& convolveProcs);
+
     // Computes one set of filters either horizontally or vertically. The caller
     // will specify the "min" and "max" rather than the bottom/top and
     // right/bottom so that the same code can be re-used in each dimension.
@@ -45,59 +129,79 @@ private:
                         SkConvolutionFilter1D* output,
                         const SkConvolutionProcs& convolveProcs);
 
-    SkConvolutionFilter1D fXFilter;
-    SkConvolutionFilter1D fYFilter;
+    SkAutoTUnref<CachedFilter> fXFilter;
+    SkAutoTUnref<CachedFilter> fYFilter;
 };
 
 SkResizeFilter::SkResizeFilter(SkBitmapScaler::ResizeMethod method,
                                int srcFullWidth, int srcFullHeight,
                                int destWidth, int destHeight,
                                const SkIRect& destSubset,
-                               const SkConvolutionProcs& convolveProcs) {
+                               const SkConvolutionProcs& convolveProcs)
+    : fMethod(method)
+    , fBitmapFilter(NULL) {
 
     // method will only ever refer to an "algorithm method".
     SkASSERT((SkBitmapScaler::RESIZE_FIRST_ALGORITHM_METHOD <= method) &&
              (method <= SkBitmapScaler::RESIZE_LAST_ALGORITHM_METHOD));
 
-    switch(method) {
-        case SkBitmapScaler::RESIZE_BOX:
-            fBitmapFilter = SkNEW(SkBoxFilter);
-            break;
-        case SkBitmapScaler::RESIZE_TRIANGLE:
-            fBitmapFilter = SkNEW(SkTriangleFilter);
-            break;
-        case SkBitmapScaler::RESIZE_MITCHELL:
-            fBitmapFilter = SkNEW_ARGS(SkMitchellFilter, (1.f/3.f, 1.f/3.f));
-            break;
-        case SkBitmapScaler::RESIZE_HAMMING:
-            fBitmapFilter = SkNEW(SkHammingFilter);
-            break;
-        case SkBitmapScaler::RESIZE_LANCZOS3:
-            fBitmapFilter = SkNEW(SkLanczosFilter);
-            break;
-        default:
-            // NOTREACHED:
-            fBitmapFilter = SkNEW_ARGS(SkMitchellFilter, (1.f/3.f, 1.f/3.f));
-            break;
-    }
+    // A square resize gets the same filter in both directions from the cache.
+    fXFilter.reset(this->getFilter(srcFullWidth, destWidth,
+                                   destSubset.fLeft, destSubset.width(),
+                                   convolveProcs));
+    fYFilter.reset(this->getFilter(srcFullHeight, destHeight,
+                                   destSubset.fTop, destSubset.height(),
+                                   convolveProcs));
+}
 
+CachedFilter* SkResizeFilter::getFilter(int srcSize, int destSize,
+                                        int destSubsetLo, int destSubsetSize,
+                                        const SkConvolutionProcs& convolveProcs) {
+    FilterKey key;
+    key.fMethod = fMethod;
+    key.fSrcSize = srcSize;
+    key.fDestSize = destSize;
+    key.fDestSubsetLo = destSubsetLo;
+    key.fDestSubsetSize = destSubsetSize;
+    key.fApplySIMDPadding = convolveProcs.fApplySIMDPadding;
+
+    CachedFilter* filter = find_cached_filter(key);
+    if (filter) {
+        return filter;
+    }
 
-    float scaleX = static_cast<float>(destWidth) /
-                   static_cast<float>(srcFullWidth);
-    float scaleY = static_cast<float>(destHeight) /
-                   static_cast<float>(srcFullHeight);
-
-    this->computeFilters(srcFullWidth, destSubset.fLeft, destSubset.width(),
-                         scaleX, &fXFilter, convolveProcs);
-    if (srcFullWidth == srcFullHeight &&
-        destSubset.fLeft == destSubset.fTop &&
-        destSubset.width() == destSubset.height()&&
-        scaleX == scaleY) {
-        fYFilter = fXFilter;
-    } else {
-        this->computeFilters(srcFullHeight, destSubset.fTop, destSubset.height(),
-                          scaleY, &fYFilter, convolveProcs);
+    if (NULL == fBitmapFilter) {
+        switch(fMethod) {
+            case SkBitmapScaler::RESIZE_BOX:
+                fBitmapFilter = SkNEW(SkBoxFilter);
+                break;
+            case SkBitmapScaler::RESIZE_TRIANGLE:
+                fBitmapFilter = SkNEW(SkTriangleFilter);
+                break;
+            case SkBitmapScaler::RESIZE_MITCHELL:
+                fBitmapFilter = SkNEW_ARGS(SkMitchellFilter, (1.f/3.f, 1.f/3.f));
+                break;
+            case SkBitmapScaler::RESIZE_HAMMING:
+                fBitmapFilter = SkNEW(SkHammingFilter);
+                break;
+            case SkBitmapScaler::RESIZE_LANCZOS3:
+                fBitmapFilter = SkNEW(SkLanczosFilter);
+                break;
+            default:
+                // NOTREACHED:
+                fBitmapFilter = SkNEW_ARGS(SkMitchellFilter, (1.f/3.f, 1.f/3.f));
+                break;
+        }
     }
+
+    float scale = static_cast<float>(destSize) /
+                  static_cast<float>(srcSize);
+
+    filter = SkNEW_ARGS(CachedFilter, (key));
+    this->computeFilters(srcSize, destSubsetLo, destSubsetSize,
+                         scale, &filter->fFilter, convolveProcs);
+    add_cached_filter(filter);
+    return filter;
 }
 
 // TODO(egouriou): Take advantage of periods in the convolution.
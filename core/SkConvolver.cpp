@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include "SkConvolver.h"
+#include "SkParallel.h"
 #include "SkSize.h"
 #include "SkTypes.h"
 
@@ -330,17 +331,36 @@ const SkConvolutionFilter1D::ConvolutionFixed* SkConvolutionFilter1D::GetSingleF
     return &fFilterValues[filter.fDataLocation];
 }
 
-void BGRAConvolve2D(const unsigned char* sourceData,
-                    int sourceByteRowStride,
-                    bool sourceHasAlpha,
-                    const SkConvolutionFilter1D& filterX,
-                    const SkConvolutionFilter1D& filterY,
-                    int outputByteRowStride,
-                    unsigned char* output,
-                    const SkConvolutionProcs& convolveProcs,
-                    bool useSimdIfPossible) {
+namespace {
 
-    int maxYFilterSize = filterY.maxFilter();
+struct ConvolveRec {
+    const unsigned char* fSourceData;
+    int fSourceByteRowStride;
+    bool fSourceHasAlpha;
+    const SkConvolutionFilter1D* fFilterX;
+    const SkConvolutionFilter1D* fFilterY;
+    int fOutputByteRowStride;
+    unsigned char* fOutput;
+    const SkConvolutionProcs* fConvolveProcs;
+
+    int fRowBufferWidth;
+    int fRowBufferHeight;
+    // Horizontal convolution can only use SIMD below this source row.
+    int fLastSimdRow;
+};
+
+}  // namespace
+
+// Produces the output rows [startY, stopY). Each call has its own circular
+// buffer, so rows at the edge of a band that the filters of both neighbouring
+// bands need are convolved horizontally by both.
+static void ConvolveRows(const ConvolveRec& rec, int startY, int stopY) {
+    const SkConvolutionFilter1D& filterX = *rec.fFilterX;
+    const SkConvolutionFilter1D& filterY = *rec.fFilterY;
+    const SkConvolutionProcs& convolveProcs = *rec.fConvolveProcs;
+    const unsigned char* sourceData = rec.fSourceData;
+    int sourceByteRowStride = rec.fSourceByteRowStride;
+    bool sourceHasAlpha = rec.fSourceHasAlpha;
 
     // The next row in the input that we will generate a horizontally
     // convolved row for. If the filter doesn't start at the beginning of the
@@ -349,59 +369,21 @@ void BGRAConvolve2D(const unsigned char* sourceData,
     // row for convolution as the first pixel for the first vertical filter.
     int filterOffset, filterLength;
     const SkConvolutionFilter1D::ConvolutionFixed* filterValues =
-        filterY.FilterForValue(0, &filterOffset, &filterLength);
+        filterY.FilterForValue(startY, &filterOffset, &filterLength);
     int nextXRow = filterOffset;
 
-    // We loop over each row in the input doing a horizontal convolution. This
-    // will result in a horizontally convolved image. We write the results into
-    // a circular buffer of convolved rows and do vertical convolution as rows
-    // are available. This prevents us from having to store the entire
-    // intermediate image and helps cache coherency.
-    // We will need four extra rows to allow horizontal convolution could be done
-    // simultaneously. We also pad each row in row buffer to be aligned-up to
-    // 16 bytes.
-    // TODO(jiesun): We do not use aligned load from row buffer in vertical
-    // convolution pass yet. Somehow Windows does not like it.
-    int rowBufferWidth = (filterX.numValues() + 15) & ~0xF;
-    int rowBufferHeight = maxYFilterSize +
-                          (convolveProcs.fConvolve4RowsHorizontally ? 4 : 0);
-    CircularRowBuffer rowBuffer(rowBufferWidth,
-                                rowBufferHeight,
+    CircularRowBuffer rowBuffer(rec.fRowBufferWidth,
+                                rec.fRowBufferHeight,
                                 filterOffset);
 
-    // Loop over every possible output row, processing just enough horizontal
-    // convolutions to run each subsequent vertical convolution.
-    SkASSERT(outputByteRowStride >= filterX.numValues() * 4);
-    int numOutputRows = filterY.numValues();
-
-    // We need to check which is the last line to convolve before we advance 4
-    // lines in one iteration.
-    int lastFilterOffset, lastFilterLength;
-
-    // SSE2 can access up to 3 extra pixels past the end of the
-    // buffer. At the bottom of the image, we have to be careful
-    // not to access data past the end of the buffer. Normally
-    // we fall back to the C++ implementation for the last row.
-    // If the last row is less than 3 pixels wide, we may have to fall
-    // back to the C++ version for more rows. Compute how many
-    // rows we need to avoid the SSE implementation for here.
-    filterX.FilterForValue(filterX.numValues() - 1, &lastFilterOffset,
-                           &lastFilterLength);
-    int avoidSimdRows = 1 + convolveProcs.fExtraHorizontalReads /
-        (lastFilterOffset + lastFilterLength);
-
-    filterY.FilterForValue(numOutputRows - 1, &lastFilterOffset,
-                           &lastFilterLength);
-
-    for (int outY = 0; outY < numOutputRows; outY++) {
+    for (int outY = startY; outY < stopY; outY++) {
         filterValues = filterY.FilterForValue(outY,
                                               &filterOffset, &filterLength);
 
         // Generate output rows until we have enough to run the current filter.
         while (nextXRow < filterOffset + filterLength) {
             if (convolveProcs.fConvolve4RowsHorizontally &&
-                nextXRow + 3 < lastFilterOffset + lastFilterLength -
-                avoidSimdRows) {
+                nextXRow + 3 < rec.fLastSimdRow) {
                 const unsigned char* src[4];
                 unsigned char* outRow[4];
                 for (int i = 0; i < 4; ++i) {
@@ -413,8 +395,7 @@ void BGRAConvolve2D(const unsigned char* sourceData,
             } else {
                 // Check if we need to avoid SSE2 for this row.
                 if (convolveProcs.fConvolveHorizontally &&
-                    nextXRow < lastFilterOffset + lastFilterLength -
-                    avoidSimdRows) {
+                    nextXRow < rec.fLastSimdRow) {
                     convolveProcs.fConvolveHorizontally(
                         &sourceData[nextXRow * sourceByteRowStride],
                         filterX, rowBuffer.advanceRow(), sourceHasAlpha);
@@ -434,7 +415,7 @@ void BGRAConvolve2D(const unsigned char* sourceData,
         }
 
         // Compute where in the output image this row of final data will go.
-        unsigned char* curOutputRow = &output[outY * outputByteRowStride];
+        unsigned char* curOutputRow = &rec.fOutput[outY * rec.fOutputByteRowStride];
 
         // Get the list of rows that the circular buffer has, in order.
         int firstRowInCircularBuffer;
@@ -459,3 +440,73 @@ void BGRAConvolve2D(const unsigned char* sourceData,
         }
     }
 }
+
+static void ConvolveBand(void* context, int startY, int stopY) {
+    ConvolveRows(*static_cast<const ConvolveRec*>(context), startY, stopY);
+}
+
+void BGRAConvolve2D(const unsigned char* sourceData,
+                    int sourceByteRowStride,
+                    bool sourceHasAlpha,
+                    const SkConvolutionFilter1D& filterX,
+                    const SkConvolutionFilter1D& filterY,
+                    int outputByteRowStride,
+                    unsigned char* output,
+                    const SkConvolutionProcs& convolveProcs,
+                    bool useSimdIfPossible) {
+    // Bands of output rows are convolved independently, on as many threads as
+    // SkParallel has. Every band after the first redoes the horizontal pass
+    // for up to maxFilter() source rows, so bands shouldn't be much smaller
+    // than this.
+    static const int kMinRowsPerBand = 32;
+
+    int maxYFilterSize = filterY.maxFilter();
+
+    // We loop over each row in the input doing a horizontal convolution. This
+    // will result in a horizontally convolved image. We write the results into
+    // a circular buffer of convolved rows and do vertical convolution as rows
+    // are available. This prevents us from having to store the entire
+    // intermediate image and helps cache coherency.
+    // We will need four extra rows to allow horizontal convolution could be done
+    // simultaneously. We also pad each row in row buffer to be aligned-up to
+    // 16 bytes.
+    // TODO(jiesun): We do not use aligned load from row buffer in vertical
+    // convolution pass yet. Somehow Windows does not like it.
+    int rowBufferWidth = (filterX.numValues() + 15) & ~0xF;
+    int rowBufferHeight = maxYFilterSize +
+                          (convolveProcs.fConvolve4RowsHorizontally ? 4 : 0);
+
+    // Loop over every possible output row, processing just enough horizontal
+    // convolutions to run each subsequent vertical convolution.
+    SkASSERT(outputByteRowStride >= filterX.numValues() * 4);
+    int numOutputRows = filterY.numValues();
+
+    // We need to check which is the last line to convolve before we advance 4
+    // lines in one iteration.
+    int lastFilterOffset, lastFilterLength;
+
+    // SSE2 can access up to 3 extra pixels past the end of the
+    // buffer. At the bottom of the image, we have to be careful
+    // not to access data past the end of the buffer. Normally
+    // we fall back to the C++ implementation for the last row.
+    // If the last row is less than 3 pixels wide, we may have to fall
+    // back to the C++ version for more rows. Compute how many
+    // rows we need to avoid the SSE implementation for here.
+    filterX.FilterForValue(filterX.numValues() - 1, &lastFilterOffset,
+                           &lastFilterLength);
+    int avoidSimdRows = 1 + convolveProcs.fExtraHorizontalReads /
+        (lastFilterOffset + lastFilterLength);
+
+    filterY.FilterForValue(numOutputRows - 1, &lastFilterOffset,
+                           &lastFilterLength);
+
+    ConvolveRec rec = {
+        sourceData, sourceByteRowStride, sourceHasAlpha,
+        &filterX, &filterY,
+        outputByteRowStride, output,
+        &convolveProcs,
+        rowBufferWidth, rowBufferHeight,
+        lastFilterOffset + lastFilterLength - avoidSimdRows,
+    };
+    SkParallel::ForRanges(numOutputRows, kMinRowsPerBand, ConvolveBand, &rec);
+}
@@ -1694,6 +1694,69 @@ void SkDraw1Glyph::blitMaskAsSprite(const SkMask& mask) const {
     fDraw->drawSprite(bm, mask.fBounds.x(), mask.fBounds.y(), *fPaint);
 }
 
+/**
+ *  Holds back the glyphs of a run that the clip does not reject, so that the
+ *  images missing from the strike can be rasterized in one batch (which the
+ *  scaler context may do faster than one at a time) before they are drawn.
+ *  With subpixel positioning a glyph's image depends on where it is drawn,
+ *  and a custom SkDraw1Glyph proc may not want images at all, so those runs
+ *  are not batched: each glyph is drawn as it is added.
+ */
+class SkDraw1GlyphBatch : SkNoncopyable {
+public:
+    SkDraw1GlyphBatch(const SkDraw1Glyph& d1g, SkDraw1Glyph::Proc proc,
+                      const SkPaint& paint, const char text[], size_t byteLength)
+        : fD1G(d1g)
+        , fProc(proc)
+        , fBatching(!hasCustomD1GProc(*d1g.fDraw) &&
+                    !d1g.fCache->isSubpixel() && !paint.isSubpixelText())
+        , fCount(0) {
+        if (fBatching) {
+            int count = paint.countText(text, byteLength);
+            fGlyphs.reset(count);
+            fPositions.reset(count);
+        }
+    }
+
+    void add(SkFixed fx, SkFixed fy, const SkGlyph& glyph) {
+        if (!fBatching) {
+            fProc(fD1G, fx, fy, glyph);
+            return;
+        }
+        SkIRect bounds;
+        bounds.setXYWH(SkFixedFloorToInt(fx) + glyph.fLeft,
+                       SkFixedFloorToInt(fy) + glyph.fTop,
+                       glyph.fWidth, glyph.fHeight);
+        if (!SkIRect::Intersects(bounds, fD1G.fClipBounds)) {
+            return;
+        }
+        fGlyphs[fCount] = &glyph;
+        fPositions[fCount].set(fx, fy);
+        fCount += 1;
+    }
+
+    void draw() {
+        if (0 == fCount) {
+            return;
+        }
+        // Only takes the strike's lock once, and only rasterizes if some
+        // images are missing.
+        fD1G.fCache->findImages(fGlyphs.get(), fCount);
+        for (int i = 0; i < fCount; ++i) {
+            fProc(fD1G, fPositions[i].fX, fPositions[i].fY, *fGlyphs[i]);
+        }
+        fCount = 0;
+    }
+
+private:
+    const SkDraw1Glyph&                 fD1G;
+    const SkDraw1Glyph::Proc            fProc;
+    const bool                          fBatching;
+    int                                 fCount;
+    SkAutoSTMalloc<32, const SkGlyph*>  fGlyphs;
+    SkAutoSTMalloc<32, SkIPoint>        fPositions;     // SkFixed x and y
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void SkDraw::drawText(const char text[], size_t byteLength,
@@ -1778,18 +1841,20 @@ void SkDraw::drawText(const char text[], size_t byteLength,
     SkFixed fx = SkScalarToFixed(x) + d1g.fHalfSampleX;
     SkFixed fy = SkScalarToFixed(y) + d1g.fHalfSampleY;
 
+    SkDraw1GlyphBatch batch(d1g, proc, paint, text, byteLength);
     while (text < stop) {
         const SkGlyph& glyph = glyphCacheProc(cache, &text, fx & fxMask, fy & fyMask);
 
         fx += autokern.adjust(glyph);
 
         if (glyph.fWidth) {
-            proc(d1g, fx, fy, glyph);
+            batch.add(fx, fy, glyph);
         }
 
         fx += glyph.fAdvanceX;
         fy += glyph.fAdvanceY;
     }
+    batch.draw();
 }
 
 // last parameter is interpreted as SkFixed [x, y]
@@ -2053,6 +2118,7 @@ void SkDraw::drawPosText(const char text[], size_t byteLength,
             }
         }
     } else {    // not subpixel
+        SkDraw1GlyphBatch batch(d1g, proc, paint, text, byteLength);
         if (SkPaint::kLeft_Align == paint.getTextAlign()) {
             while (text < stop) {
                 // the last 2 parameters are ignored
@@ -2061,10 +2127,9 @@ void SkDraw::drawPosText(const char text[], size_t byteLength,
                 if (glyph.fWidth) {
                     tmsProc(tms, pos);
 
-                    proc(d1g,
-                         SkScalarToFixed(tms.fLoc.fX) + SK_FixedHalf, //d1g.fHalfSampleX,
-                         SkScalarToFixed(tms.fLoc.fY) + SK_FixedHalf, //d1g.fHalfSampleY,
-                         glyph);
+                    batch.add(SkScalarToFixed(tms.fLoc.fX) + SK_FixedHalf, //d1g.fHalfSampleX,
+                              SkScalarToFixed(tms.fLoc.fY) + SK_FixedHalf, //d1g.fHalfSampleY,
+                              glyph);
                 }
                 pos += scalarsPerPosition;
             }
@@ -2079,14 +2144,14 @@ void SkDraw::drawPosText(const char text[], size_t byteLength,
                     SkIPoint fixedLoc;
                     alignProc(tms.fLoc, glyph, &fixedLoc);
 
-                    proc(d1g,
-                         fixedLoc.fX + SK_FixedHalf, //d1g.fHalfSampleX,
-                         fixedLoc.fY + SK_FixedHalf, //d1g.fHalfSampleY,
-                         glyph);
+                    batch.add(fixedLoc.fX + SK_FixedHalf, //d1g.fHalfSampleX,
+                              fixedLoc.fY + SK_FixedHalf, //d1g.fHalfSampleY,
+                              glyph);
                 }
                 pos += scalarsPerPosition;
             }
         }
+        batch.draw();
     }
 }
 
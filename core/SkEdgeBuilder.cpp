@@ -12,13 +12,13 @@
 #include "SkLineClipper.h"
 #include "SkGeometry.h"
 
-template <typename T> static T* typedAllocThrow(SkChunkAlloc& alloc) {
+template <typename T> static T* typedAllocThrow(SkScratchAlloc& alloc) {
     return static_cast<T*>(alloc.allocThrow(sizeof(T)));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-SkEdgeBuilder::SkEdgeBuilder() : fAlloc(16*1024) {
+SkEdgeBuilder::SkEdgeBuilder() {
     fEdgeList = NULL;
 }
 
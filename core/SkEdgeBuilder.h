@@ -8,8 +8,8 @@
 #ifndef SkEdgeBuilder_DEFINED
 #define SkEdgeBuilder_DEFINED
 
-#include "SkChunkAlloc.h"
 #include "SkRect.h"
+#include "SkScratchAlloc.h"
 #include "SkTDArray.h"
 
 struct SkEdge;
@@ -27,7 +27,7 @@ public:
     SkEdge** edgeList() { return fEdgeList; }
 
 private:
-    SkChunkAlloc        fAlloc;
+    SkScratchAlloc      fAlloc;
     SkTDArray<SkEdge*>  fList;
 
     /*
@@ -14,6 +14,7 @@
 #include "SkPath.h"
 #include "SkTemplates.h"
 #include "SkTLS.h"
+#include "SkTSort.h"
 #include "SkTypeface.h"
 
 //#define SPEW_PURGE_STATUS
@@ -78,12 +79,13 @@ SkGlyphCache::SkGlyphCache(SkTypeface* typeface, const SkDescriptor* desc, SkSca
     fDesc = desc->copy();
     fScalerContext->getFontMetrics(&fFontMetrics);
 
-    // init to 0 so that all of the pointers will be null
+    // init to 0 so that all of the slots will be empty
     memset(fGlyphHash, 0, sizeof(fGlyphHash));
-    // init with 0xFF so that the charCode field will be -1, which is invalid
-    memset(fCharToGlyphHash, 0xFF, sizeof(fCharToGlyphHash));
+    memset(fCharToGlyphHash, 0, sizeof(fCharToGlyphHash));
 
     fMemoryUsed = sizeof(*this);
+    fUseCount = 0;
+    fMemoryAccounted = 0;
 
     fGlyphArray.setReserve(kMinGlyphCount);
 
@@ -137,23 +139,58 @@ SkGlyphCache::~SkGlyphCache() {
 #define VALIDATE()
 #endif
 
+static inline SkGlyph* slot_glyph(uintptr_t slot) {
+    return reinterpret_cast<SkGlyph*>(slot & ~(uintptr_t)1);
+}
+
+static inline bool slot_has_full_metrics(uintptr_t slot) {
+    return SkToBool(slot & 1);
+}
+
+static inline uintptr_t make_slot(const void* ptr, bool fullMetrics) {
+    uintptr_t slot = reinterpret_cast<uintptr_t>(ptr);
+    SkASSERT(0 == (slot & 1));
+    return slot | (fullMetrics ? 1 : 0);
+}
+
+// Slots are written while holding fMutex, but read without it, so they must
+// be loaded exactly once per lookup.
+static inline uintptr_t read_slot(const uintptr_t* slot) {
+    return *(const volatile uintptr_t*)slot;
+}
+
+/*  Every sk_atomic operation is a full memory barrier, so bumping a counter
+    guarantees that the stores that built a glyph (or its image/path) are
+    visible to other threads before the store that publishes a pointer to it.
+    Readers only dereference what they load, so they need no barrier of their
+    own.
+*/
+void SkGlyphCache::publishBarrier() {
+    static int32_t gPublishCount;
+    sk_atomic_inc(&gPublishCount);
+}
+
 uint16_t SkGlyphCache::unicharToGlyph(SkUnichar charCode) {
     VALIDATE();
     uint32_t id = SkGlyph::MakeID(charCode);
-    const CharGlyphRec& rec = fCharToGlyphHash[ID2HashIndex(id)];
+    uintptr_t slot = read_slot(&fCharToGlyphHash[ID2HashIndex(id)]);
+    const CharGlyphRec* rec = reinterpret_cast<const CharGlyphRec*>(slot_glyph(slot));
 
-    if (rec.fID == id) {
-        return rec.fGlyph->getGlyphID();
+    if (rec && rec->fID == id) {
+        return rec->fGlyph->getGlyphID();
     } else {
+        SkAutoMutexAcquire ac(fMutex);
         return fScalerContext->charToGlyphID(charCode);
     }
 }
 
 SkUnichar SkGlyphCache::glyphToUnichar(uint16_t glyphID) {
+    SkAutoMutexAcquire ac(fMutex);
     return fScalerContext->glyphIDToChar(glyphID);
 }
 
 unsigned SkGlyphCache::getGlyphCount() {
+    SkAutoMutexAcquire ac(fMutex);
     return fScalerContext->getGlyphCount();
 }
 
@@ -162,119 +199,145 @@ unsigned SkGlyphCache::getGlyphCount() {
 const SkGlyph& SkGlyphCache::getUnicharAdvance(SkUnichar charCode) {
     VALIDATE();
     uint32_t id = SkGlyph::MakeID(charCode);
-    CharGlyphRec* rec = &fCharToGlyphHash[ID2HashIndex(id)];
+    uintptr_t slot = read_slot(&fCharToGlyphHash[ID2HashIndex(id)]);
+    const CharGlyphRec* rec = reinterpret_cast<const CharGlyphRec*>(slot_glyph(slot));
 
-    if (rec->fID != id) {
-        // this ID is based on the UniChar
-        rec->fID = id;
-        // this ID is based on the glyph index
-        id = SkGlyph::MakeID(fScalerContext->charToGlyphID(charCode));
-        rec->fGlyph = this->lookupMetrics(id, kJustAdvance_MetricsType);
+    if (rec && rec->fID == id) {
+        RecordHashSuccess();
+        return *rec->fGlyph;
     }
-    return *rec->fGlyph;
+    RecordHashCollisionIf(rec != NULL);
+    return this->lockedUnicharLookup(id, charCode, 0, 0, kJustAdvance_MetricsType);
 }
 
 const SkGlyph& SkGlyphCache::getGlyphIDAdvance(uint16_t glyphID) {
     VALIDATE();
     uint32_t id = SkGlyph::MakeID(glyphID);
-    unsigned index = ID2HashIndex(id);
-    SkGlyph* glyph = fGlyphHash[index];
+    uintptr_t slot = read_slot(&fGlyphHash[ID2HashIndex(id)]);
+    const SkGlyph* glyph = slot_glyph(slot);
 
-    if (NULL == glyph || glyph->fID != id) {
-        glyph = this->lookupMetrics(glyphID, kJustAdvance_MetricsType);
-        fGlyphHash[index] = glyph;
+    if (glyph && glyph->fID == id) {
+        RecordHashSuccess();
+        return *glyph;
     }
-    return *glyph;
+    RecordHashCollisionIf(glyph != NULL);
+    return this->lockedGlyphIDLookup(id, glyphID, kJustAdvance_MetricsType);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 const SkGlyph& SkGlyphCache::getUnicharMetrics(SkUnichar charCode) {
-    VALIDATE();
-    uint32_t id = SkGlyph::MakeID(charCode);
-    CharGlyphRec* rec = &fCharToGlyphHash[ID2HashIndex(id)];
-
-    if (rec->fID != id) {
-        RecordHashCollisionIf(rec->fGlyph != NULL);
-        // this ID is based on the UniChar
-        rec->fID = id;
-        // this ID is based on the glyph index
-        id = SkGlyph::MakeID(fScalerContext->charToGlyphID(charCode));
-        rec->fGlyph = this->lookupMetrics(id, kFull_MetricsType);
-    } else {
-        RecordHashSuccess();
-        if (rec->fGlyph->isJustAdvance()) {
-            fScalerContext->getMetrics(rec->fGlyph);
-        }
-    }
-    SkASSERT(rec->fGlyph->isFullMetrics());
-    return *rec->fGlyph;
+    return this->getUnicharMetrics(charCode, 0, 0);
 }
 
 const SkGlyph& SkGlyphCache::getUnicharMetrics(SkUnichar charCode,
                                                SkFixed x, SkFixed y) {
     VALIDATE();
     uint32_t id = SkGlyph::MakeID(charCode, x, y);
-    CharGlyphRec* rec = &fCharToGlyphHash[ID2HashIndex(id)];
+    uintptr_t slot = read_slot(&fCharToGlyphHash[ID2HashIndex(id)]);
+    const CharGlyphRec* rec = reinterpret_cast<const CharGlyphRec*>(slot_glyph(slot));
 
-    if (rec->fID != id) {
-        RecordHashCollisionIf(rec->fGlyph != NULL);
-        // this ID is based on the UniChar
-        rec->fID = id;
-        // this ID is based on the glyph index
-        id = SkGlyph::MakeID(fScalerContext->charToGlyphID(charCode), x, y);
-        rec->fGlyph = this->lookupMetrics(id, kFull_MetricsType);
-    } else {
+    if (rec && rec->fID == id && slot_has_full_metrics(slot)) {
         RecordHashSuccess();
-        if (rec->fGlyph->isJustAdvance()) {
-            fScalerContext->getMetrics(rec->fGlyph);
-        }
+        SkASSERT(rec->fGlyph->isFullMetrics());
+        return *rec->fGlyph;
     }
-    SkASSERT(rec->fGlyph->isFullMetrics());
-    return *rec->fGlyph;
+    RecordHashCollisionIf(rec != NULL && rec->fID != id);
+    return this->lockedUnicharLookup(id, charCode, x, y, kFull_MetricsType);
 }
 
 const SkGlyph& SkGlyphCache::getGlyphIDMetrics(uint16_t glyphID) {
-    VALIDATE();
-    uint32_t id = SkGlyph::MakeID(glyphID);
-    unsigned index = ID2HashIndex(id);
-    SkGlyph* glyph = fGlyphHash[index];
-
-    if (NULL == glyph || glyph->fID != id) {
-        RecordHashCollisionIf(glyph != NULL);
-        glyph = this->lookupMetrics(glyphID, kFull_MetricsType);
-        fGlyphHash[index] = glyph;
-    } else {
-        RecordHashSuccess();
-        if (glyph->isJustAdvance()) {
-            fScalerContext->getMetrics(glyph);
-        }
-    }
-    SkASSERT(glyph->isFullMetrics());
-    return *glyph;
+    return this->getGlyphIDMetrics(glyphID, 0, 0);
 }
 
 const SkGlyph& SkGlyphCache::getGlyphIDMetrics(uint16_t glyphID,
                                                SkFixed x, SkFixed y) {
     VALIDATE();
     uint32_t id = SkGlyph::MakeID(glyphID, x, y);
-    unsigned index = ID2HashIndex(id);
-    SkGlyph* glyph = fGlyphHash[index];
+    uintptr_t slot = read_slot(&fGlyphHash[ID2HashIndex(id)]);
+    const SkGlyph* glyph = slot_glyph(slot);
 
-    if (NULL == glyph || glyph->fID != id) {
-        RecordHashCollisionIf(glyph != NULL);
-        glyph = this->lookupMetrics(id, kFull_MetricsType);
-        fGlyphHash[index] = glyph;
-    } else {
+    if (glyph && glyph->fID == id && slot_has_full_metrics(slot)) {
         RecordHashSuccess();
-        if (glyph->isJustAdvance()) {
-            fScalerContext->getMetrics(glyph);
+        SkASSERT(glyph->isFullMetrics());
+        return *glyph;
+    }
+    RecordHashCollisionIf(glyph != NULL && glyph->fID != id);
+    return this->lockedGlyphIDLookup(id, glyphID, kFull_MetricsType);
+}
+
+const SkGlyph& SkGlyphCache::lockedGlyphIDLookup(uint32_t id, uint16_t glyphID,
+                                                 MetricsType mtype) {
+    SkAutoMutexAcquire ac(fMutex);
+
+    SkGlyph* glyph = this->lookupMetrics(id, mtype);
+    SkASSERT(glyph->getGlyphID() == glyphID);
+
+    this->publishBarrier();
+    fGlyphHash[ID2HashIndex(id)] = make_slot(glyph, glyph->isFullMetrics());
+    return *glyph;
+}
+
+const SkGlyph& SkGlyphCache::lockedUnicharLookup(uint32_t id, SkUnichar charCode,
+                                                 SkFixed x, SkFixed y,
+                                                 MetricsType mtype) {
+    SkAutoMutexAcquire ac(fMutex);
+
+    uintptr_t* slot = &fCharToGlyphHash[ID2HashIndex(id)];
+    CharGlyphRec* rec = reinterpret_cast<CharGlyphRec*>(slot_glyph(*slot));
+    SkGlyph* glyph;
+    if (rec && rec->fID == id) {
+        // another thread may have published it while we waited for the mutex
+        glyph = rec->fGlyph;
+        if (kFull_MetricsType == mtype) {
+            this->upgradeMetrics(glyph);
         }
+    } else {
+        // this ID is based on the glyph index
+        uint32_t glyphID = SkGlyph::MakeID(fScalerContext->charToGlyphID(charCode), x, y);
+        glyph = this->lookupMetrics(glyphID, mtype);
+
+        // recs are never modified once published, so we always make a new one
+        rec = (CharGlyphRec*)fGlyphAlloc.alloc(sizeof(CharGlyphRec),
+                                               SkChunkAlloc::kThrow_AllocFailType);
+        fMemoryUsed += sizeof(CharGlyphRec);
+        // this ID is based on the UniChar
+        rec->fID = id;
+        rec->fGlyph = glyph;
     }
-    SkASSERT(glyph->isFullMetrics());
+
+    this->publishBarrier();
+    *slot = make_slot(rec, glyph->isFullMetrics());
     return *glyph;
 }
 
+void SkGlyphCache::upgradeMetrics(SkGlyph* glyph) {
+    if (!glyph->isJustAdvance()) {
+        return;
+    }
+
+    // Readers may be looking at this glyph's advance without holding fMutex,
+    // so compute the full metrics on the side, and only then copy them in.
+    // fMaskFormat is written last, since it marks the metrics as complete.
+    SkGlyph tmp;
+    tmp.init(glyph->fID);
+    fScalerContext->getMetrics(&tmp);
+
+    glyph->fAdvanceX = tmp.fAdvanceX;
+    glyph->fAdvanceY = tmp.fAdvanceY;
+    glyph->fWidth = tmp.fWidth;
+    glyph->fHeight = tmp.fHeight;
+    glyph->fTop = tmp.fTop;
+    glyph->fLeft = tmp.fLeft;
+    glyph->fRsbDelta = tmp.fRsbDelta;
+    glyph->fLsbDelta = tmp.fLsbDelta;
+#ifdef SK_BUILD_FOR_WIN32
+    glyph->fColor = tmp.fColor;
+#endif
+    this->publishBarrier();
+    glyph->fMaskFormat = tmp.fMaskFormat;
+}
+
 SkGlyph* SkGlyphCache::lookupMetrics(uint32_t id, MetricsType mtype) {
     SkGlyph* glyph;
 
@@ -296,8 +359,8 @@ SkGlyph* SkGlyphCache::lookupMetrics(uint32_t id, MetricsType mtype) {
         }
         glyph = gptr[hi];
         if (glyph->fID == id) {
-            if (kFull_MetricsType == mtype && glyph->isJustAdvance()) {
-                fScalerContext->getMetrics(glyph);
+            if (kFull_MetricsType == mtype) {
+                this->upgradeMetrics(glyph);
             }
             return glyph;
         }
@@ -334,30 +397,101 @@ SkGlyph* SkGlyphCache::lookupMetrics(uint32_t id, MetricsType mtype) {
 const void* SkGlyphCache::findImage(const SkGlyph& glyph) {
     if (glyph.fWidth > 0 && glyph.fWidth < kMaxGlyphWidth) {
         if (glyph.fImage == NULL) {
-            size_t  size = glyph.computeImageSize();
-            const_cast<SkGlyph&>(glyph).fImage = fGlyphAlloc.alloc(size,
+            SkAutoMutexAcquire ac(fMutex);
+            // check again, in case another thread generated it while we
+            // waited for the mutex
+            if (glyph.fImage == NULL) {
+                size_t  size = glyph.computeImageSize();
+                void* image = fGlyphAlloc.alloc(size,
                                         SkChunkAlloc::kReturnNil_AllocFailType);
-            // check that alloc() actually succeeded
-            if (glyph.fImage) {
-                fScalerContext->getImage(glyph);
-                // TODO: the scaler may have changed the maskformat during
-                // getImage (e.g. from AA or LCD to BW) which means we may have
-                // overallocated the buffer. Check if the new computedImageSize
-                // is smaller, and if so, strink the alloc size in fImageAlloc.
-                fMemoryUsed += size;
+                // check that alloc() actually succeeded
+                if (image) {
+                    // Other threads may be reading this glyph, so rasterize
+                    // through a copy, and publish the image once it is done.
+                    SkGlyph tmp = glyph;
+                    tmp.fImage = image;
+                    fScalerContext->getImage(tmp);
+                    // TODO: the scaler may have changed the maskformat during
+                    // getImage (e.g. from AA or LCD to BW) which means we may have
+                    // overallocated the buffer. Check if the new computedImageSize
+                    // is smaller, and if so, strink the alloc size in fImageAlloc.
+                    fMemoryUsed += size;
+                    this->publishBarrier();
+                    const_cast<SkGlyph&>(glyph).fImage = image;
+                }
             }
         }
     }
     return glyph.fImage;
 }
 
+void SkGlyphCache::findImages(const SkGlyph* glyphs[], int count) {
+    SkAutoMutexAcquire ac(fMutex);
+
+    // Usually every image is there already, and this is all there is to do.
+    SkTDArray<const SkGlyph*> missing;
+    for (int i = 0; i < count; ++i) {
+        const SkGlyph* glyph = glyphs[i];
+        if (NULL == glyph->fImage && glyph->fWidth > 0 && glyph->fWidth < kMaxGlyphWidth) {
+            *missing.append() = glyph;
+        }
+    }
+    if (missing.isEmpty()) {
+        return;
+    }
+    if (missing.count() > 1) {
+        SkTQSort(missing.begin(), missing.end() - 1);
+    }
+
+    // As in findImage, rasterize through copies, and publish the images once
+    // they are all done.
+    SkTDArray<const SkGlyph*> originals;
+    SkTDArray<SkGlyph> copies;
+    copies.setReserve(missing.count());
+    for (int i = 0; i < missing.count(); ++i) {
+        const SkGlyph* glyph = missing[i];
+        if (i > 0 && glyph == missing[i - 1]) {
+            continue;
+        }
+        size_t size = glyph->computeImageSize();
+        void* image = fGlyphAlloc.alloc(size, SkChunkAlloc::kReturnNil_AllocFailType);
+        if (NULL == image) {
+            continue;
+        }
+        fMemoryUsed += size;
+        *originals.append() = glyph;
+        SkGlyph* copy = copies.append();
+        *copy = *glyph;
+        copy->fImage = image;
+    }
+    if (originals.isEmpty()) {
+        return;
+    }
+
+    SkTDArray<const SkGlyph*> batch;
+    for (int i = 0; i < copies.count(); ++i) {
+        *batch.append() = &copies[i];
+    }
+    fScalerContext->getImages(batch.begin(), batch.count());
+
+    this->publishBarrier();
+    for (int i = 0; i < originals.count(); ++i) {
+        const_cast<SkGlyph*>(originals[i])->fImage = copies[i].fImage;
+    }
+}
+
 const SkPath* SkGlyphCache::findPath(const SkGlyph& glyph) {
     if (glyph.fWidth) {
         if (glyph.fPath == NULL) {
-            const_cast<SkGlyph&>(glyph).fPath = SkNEW(SkPath);
-            fScalerContext->getPath(glyph, glyph.fPath);
-            fMemoryUsed += sizeof(SkPath) +
-                    glyph.fPath->countPoints() * sizeof(SkPoint);
+            SkAutoMutexAcquire ac(fMutex);
+            if (glyph.fPath == NULL) {
+                SkPath* path = SkNEW(SkPath);
+                fScalerContext->getPath(glyph, path);
+                fMemoryUsed += sizeof(SkPath) +
+                        path->countPoints() * sizeof(SkPoint);
+                this->publishBarrier();
+                const_cast<SkGlyph&>(glyph).fPath = path;
+            }
         }
     }
     return glyph.fPath;
@@ -366,6 +500,7 @@ const SkPath* SkGlyphCache::findPath(const SkGlyph& glyph) {
 ///////////////////////////////////////////////////////////////////////////////
 
 bool SkGlyphCache::getAuxProcData(void (*proc)(void*), void** dataPtr) const {
+    SkAutoMutexAcquire ac(fMutex);
     const AuxProcRec* rec = fAuxProcList;
     while (rec) {
         if (rec->fProc == proc) {
@@ -379,16 +514,18 @@ bool SkGlyphCache::getAuxProcData(void (*proc)(void*), void** dataPtr) const {
     return false;
 }
 
-void SkGlyphCache::setAuxProc(void (*proc)(void*), void* data) {
+void* SkGlyphCache::setAuxProc(void (*proc)(void*), void* data) {
     if (proc == NULL) {
-        return;
+        return data;
     }
 
+    // The strike is shared, so the lookup and the insert must happen under
+    // one lock for only one caller's data to win.
+    SkAutoMutexAcquire ac(fMutex);
     AuxProcRec* rec = fAuxProcList;
     while (rec) {
         if (rec->fProc == proc) {
-            rec->fData = data;
-            return;
+            return rec->fData;
         }
         rec = rec->fNext;
     }
@@ -398,6 +535,7 @@ void SkGlyphCache::setAuxProc(void (*proc)(void*), void* data) {
     rec->fData = data;
     rec->fNext = fAuxProcList;
     fAuxProcList = rec;
+    return data;
 }
 
 void SkGlyphCache::invokeAndRemoveAuxProcs() {
@@ -464,11 +602,9 @@ void SkGlyphCache::VisitAllCaches(bool (*proc)(SkGlyphCache*, void*),
     globals.validate();
 }
 
-/*  This guy calls the visitor from within the mutext lock, so the visitor
-    cannot:
-    - take too much time
-    - try to acquire the mutext again
-    - call a fontscaler (which might call into the cache)
+/*  The visitor is called without holding the globals' mutex, while the caller
+    holds a use of the strike, so it may safely call into the strike. It must
+    not assume that it is the strike's only user.
 */
 SkGlyphCache* SkGlyphCache::VisitCache(SkTypeface* typeface,
                               const SkDescriptor* desc,
@@ -480,50 +616,65 @@ SkGlyphCache* SkGlyphCache::VisitCache(SkTypeface* typeface,
     SkASSERT(desc);
 
     SkGlyphCache_Globals& globals = getGlobals();
-    SkAutoMutexAcquire    ac(globals.fMutex);
     SkGlyphCache*         cache;
-    bool                  insideMutex = true;
+    {
+        SkAutoMutexAcquire    ac(globals.fMutex);
 
-    globals.validate();
+        globals.validate();
 
-    for (cache = globals.internalGetHead(); cache != NULL; cache = cache->fNext) {
-        if (cache->fDesc->equals(*desc)) {
-            globals.internalDetachCache(cache);
-            goto FOUND_IT;
+        cache = globals.internalFind(*desc);
+        if (cache) {
+            globals.internalMoveToHead(cache);
+            cache->fUseCount += 1;
         }
     }
 
-    /* Release the mutex now, before we create a new entry (which might have
-        side-effects like trying to access the cache/mutex (yikes!)
-    */
-    ac.release();           // release the mutex now
-    insideMutex = false;    // can't use globals anymore
+    if (NULL == cache) {
+        /* Create the new entry outside of the mutex, since it might have
+            side-effects like trying to access the cache/mutex (yikes!)
+        */
+        SkGlyphCache* newCache;
+
+        // Check if we can create a scaler-context before creating the glyphcache.
+        // If not, we may have exhausted OS/font resources, so try purging the
+        // cache once and try again.
+        {
+            // pass true the first time, to notice if the scalercontext failed,
+            // so we can try the purge.
+            SkScalerContext* ctx = typeface->createScalerContext(desc, true);
+            if (!ctx) {
+                getSharedGlobals().purgeAll();
+                ctx = typeface->createScalerContext(desc, false);
+                SkASSERT(ctx);
+            }
+            newCache = SkNEW_ARGS(SkGlyphCache, (typeface, desc, ctx));
+        }
 
-    // Check if we can create a scaler-context before creating the glyphcache.
-    // If not, we may have exhausted OS/font resources, so try purging the
-    // cache once and try again.
-    {
-        // pass true the first time, to notice if the scalercontext failed,
-        // so we can try the purge.
-        SkScalerContext* ctx = typeface->createScalerContext(desc, true);
-        if (!ctx) {
-            getSharedGlobals().purgeAll();
-            ctx = typeface->createScalerContext(desc, false);
-            SkASSERT(ctx);
+        {
+            SkAutoMutexAcquire    ac(globals.fMutex);
+
+            // Another thread may have created the same strike while we were
+            // building ours. If so, share theirs rather than keeping a
+            // duplicate.
+            cache = globals.internalFind(*desc);
+            if (cache) {
+                globals.internalMoveToHead(cache);
+            } else {
+                globals.internalAttachCacheToHead(newCache);
+                cache = newCache;
+                newCache = NULL;
+            }
+            cache->fUseCount += 1;
         }
-        cache = SkNEW_ARGS(SkGlyphCache, (typeface, desc, ctx));
-    }
 
-FOUND_IT:
+        // deleted outside of the mutex, since it calls out to the auxprocs
+        SkDELETE(newCache);
+    }
 
     AutoValidate av(cache);
 
-    if (!proc(cache, context)) {   // need to reattach
-        if (insideMutex) {
-            globals.internalAttachCacheToHead(cache);
-        } else {
-            globals.attachCacheToHead(cache);
-        }
+    if (!proc(cache, context)) {   // need to release
+        globals.releaseCache(cache);
         cache = NULL;
     }
     return cache;
@@ -531,20 +682,21 @@ FOUND_IT:
 
 void SkGlyphCache::AttachCache(SkGlyphCache* cache) {
     SkASSERT(cache);
-    SkASSERT(cache->fNext == NULL);
 
-    getGlobals().attachCacheToHead(cache);
+    getGlobals().releaseCache(cache);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void SkGlyphCache_Globals::attachCacheToHead(SkGlyphCache* cache) {
+void SkGlyphCache_Globals::releaseCache(SkGlyphCache* cache) {
     SkAutoMutexAcquire    ac(fMutex);
 
     this->validate();
     cache->validate();
 
-    this->internalAttachCacheToHead(cache);
+    SkASSERT(cache->fUseCount > 0);
+    cache->fUseCount -= 1;
+    this->internalUpdateMemoryUsed(cache);
     this->internalPurge();
 }
 
@@ -588,15 +740,18 @@ size_t SkGlyphCache_Globals::internalPurge(size_t minBytesNeeded) {
 
     // we start at the tail and proceed backwards, as the linklist is in LRU
     // order, with unimportant entries at the tail.
+    // Strikes that are still in use by some thread are skipped.
     SkGlyphCache* cache = this->internalGetTail();
     while (cache != NULL &&
            (bytesFreed < bytesNeeded || countFreed < countNeeded)) {
         SkGlyphCache* prev = cache->fPrev;
-        bytesFreed += cache->fMemoryUsed;
-        countFreed += 1;
+        if (0 == cache->fUseCount) {
+            bytesFreed += cache->fMemoryAccounted;
+            countFreed += 1;
 
-        this->internalDetachCache(cache);
-        SkDELETE(cache);
+            this->internalDetachCache(cache);
+            SkDELETE(cache);
+        }
         cache = prev;
     }
 
@@ -614,20 +769,54 @@ size_t SkGlyphCache_Globals::internalPurge(size_t minBytesNeeded) {
 
 void SkGlyphCache_Globals::internalAttachCacheToHead(SkGlyphCache* cache) {
     SkASSERT(NULL == cache->fPrev && NULL == cache->fNext);
+    SkASSERT(NULL == fHash.find(*cache->fDesc));
     if (fHead) {
         fHead->fPrev = cache;
         cache->fNext = fHead;
     }
     fHead = cache;
+    fHash.add(cache);
 
     fCacheCount += 1;
-    fTotalMemoryUsed += cache->fMemoryUsed;
+    cache->fMemoryAccounted = 0;
+    this->internalUpdateMemoryUsed(cache);
+}
+
+void SkGlyphCache_Globals::internalMoveToHead(SkGlyphCache* cache) {
+    if (fHead == cache) {
+        return;
+    }
+
+    // unlink without touching the hash or the accounting
+    SkASSERT(cache->fPrev);
+    cache->fPrev->fNext = cache->fNext;
+    if (cache->fNext) {
+        cache->fNext->fPrev = cache->fPrev;
+    }
+
+    cache->fPrev = NULL;
+    cache->fNext = fHead;
+    fHead->fPrev = cache;
+    fHead = cache;
+}
+
+void SkGlyphCache_Globals::internalUpdateMemoryUsed(SkGlyphCache* cache) {
+    size_t memoryUsed;
+    {
+        SkAutoMutexAcquire ac(cache->fMutex);
+        memoryUsed = cache->fMemoryUsed;
+    }
+    // strikes never shrink
+    SkASSERT(memoryUsed >= cache->fMemoryAccounted);
+    fTotalMemoryUsed += memoryUsed - cache->fMemoryAccounted;
+    cache->fMemoryAccounted = memoryUsed;
 }
 
 void SkGlyphCache_Globals::internalDetachCache(SkGlyphCache* cache) {
     SkASSERT(fCacheCount > 0);
     fCacheCount -= 1;
-    fTotalMemoryUsed -= cache->fMemoryUsed;
+    fTotalMemoryUsed -= cache->fMemoryAccounted;
+    fHash.remove(*cache->fDesc);
 
     if (cache->fPrev) {
         cache->fPrev->fNext = cache->fNext;
@@ -646,6 +835,7 @@ void SkGlyphCache_Globals::internalDetachCache(SkGlyphCache* cache) {
 
 void SkGlyphCache::validate() const {
 #ifdef SK_DEBUG_GLYPH_CACHE
+    SkAutoMutexAcquire ac(fMutex);
     int count = fGlyphArray.count();
     for (int i = 0; i < count; i++) {
         const SkGlyph* glyph = fGlyphArray[i];
@@ -664,13 +854,14 @@ void SkGlyphCache_Globals::validate() const {
 
     const SkGlyphCache* head = fHead;
     while (head != NULL) {
-        computedBytes += head->fMemoryUsed;
+        computedBytes += head->fMemoryAccounted;
         computedCount += 1;
         head = head->fNext;
     }
 
     SkASSERT(fTotalMemoryUsed == computedBytes);
     SkASSERT(fCacheCount == computedCount);
+    SkASSERT(fHash.count() == computedCount);
 }
 
 #endif
@@ -17,6 +17,7 @@
 #include "SkScalerContext.h"
 #include "SkTemplates.h"
 #include "SkTDArray.h"
+#include "SkThread.h"
 
 struct SkDeviceProperties;
 class SkPaint;
@@ -33,6 +34,11 @@ class SkGlyphCache_Globals;
 
     The strikes are held in a global list, available to all threads. To interact
     with one, call either VisitCache() or DetachCache().
+
+    A strike may be used by several threads at once. Glyphs that are already
+    in the strike are found without taking any lock; generating a new glyph
+    (or its image or path) is serialized by a per-strike mutex, which also
+    guards every call into the strike's SkScalerContext.
 */
 class SkGlyphCache {
 public:
@@ -88,6 +94,13 @@ public:
         this will trigger that.
     */
     const void* findImage(const SkGlyph&);
+    /** Make sure the images of the glyphs are generated, like calling
+        findImage on each. The missing ones are rasterized together, which
+        the scaler context may be able to do faster than one at a time. The
+        same glyph may be passed more than once. The images are only looked
+        at under the strike's lock, which is taken once.
+    */
+    void findImages(const SkGlyph* glyphs[], int count);
     /** Return the Path associated with the glyph. If it has not been generated
         this will trigger that.
     */
@@ -120,10 +133,20 @@ public:
 
     //! If the proc is found, return true and set *dataPtr to its data
     bool getAuxProcData(void (*auxProc)(void*), void** dataPtr) const;
-    //! Add a proc/data pair to the glyphcache. proc should be non-null
-    void setAuxProc(void (*auxProc)(void*), void* auxData);
+    /** Add a proc/data pair to the glyphcache, unless another thread has
+        already added data for proc, in which case that data is kept. Returns
+        the data now associated with proc, so a caller whose data was not
+        kept can release it and use the returned data instead. proc should be
+        non-null.
+    */
+    void* setAuxProc(void (*auxProc)(void*), void* auxData);
 
+    /** Note: SkScalerContext is not thread-safe, and this strike may be in use
+        by other threads. Callers that invoke the scaler directly must hold the
+        mutex returned by getScalerContextMutex().
+    */
     SkScalerContext* getScalerContext() const { return fScalerContext; }
+    SkBaseMutex* getScalerContextMutex() const { return &fMutex; }
 
     /** Call proc on all cache entries, stopping early if proc returns true.
         The proc should not create or delete caches, since it could produce
@@ -132,27 +155,27 @@ public:
     static void VisitAllCaches(bool (*proc)(SkGlyphCache*, void*), void* ctx);
 
     /** Find a matching cache entry, and call proc() with it. If none is found
-        create a new one. If the proc() returns true, detach the cache and
-        return it, otherwise leave it and return NULL.
+        create a new one. If the proc() returns true, return the cache, which
+        the caller must later hand back with AttachCache(). Otherwise return
+        NULL.
     */
     static SkGlyphCache* VisitCache(SkTypeface*, const SkDescriptor* desc,
                                     bool (*proc)(const SkGlyphCache*, void*),
                                     void* context);
 
     /** Given a strike that was returned by either VisitCache() or DetachCache()
-        add it back into the global cache list (after which the caller should
-        not reference it anymore.
+        release it back to the global cache (after which the caller should
+        not reference it anymore). Strikes are only purged once every user
+        has released them.
     */
     static void AttachCache(SkGlyphCache*);
 
-    /** Detach a strike from the global cache matching the specified descriptor.
-        Once detached, it can be queried/modified by the current thread, and
-        when finished, be reattached to the global cache with AttachCache().
-        While detached, if another request is made with the same descriptor,
-        a different strike will be generated. This is fine. It does mean we
-        can have more than 1 strike for the same descriptor, but that will
-        eventually get purged, and the win is that different thread will never
-        block each other while a strike is being used.
+    /** Return the strike from the global cache matching the specified
+        descriptor, creating it if needed. Once returned, it can be queried by
+        the current thread, and when finished, be released to the global cache
+        with AttachCache(). If another request is made with the same descriptor
+        in the meantime, the same strike is shared with that thread rather than
+        generating a duplicate.
     */
     static SkGlyphCache* DetachCache(SkTypeface* typeface,
                                      const SkDescriptor* desc) {
@@ -194,7 +217,15 @@ private:
         kFull_MetricsType
     };
 
+    // These must be called with fMutex held.
     SkGlyph* lookupMetrics(uint32_t id, MetricsType);
+    void upgradeMetrics(SkGlyph*);
+    void publishBarrier();
+
+    const SkGlyph& lockedGlyphIDLookup(uint32_t id, uint16_t glyphID, MetricsType);
+    const SkGlyph& lockedUnicharLookup(uint32_t id, SkUnichar charCode,
+                                       SkFixed x, SkFixed y, MetricsType);
+
     static bool DetachProc(const SkGlyphCache*, void*) { return true; }
 
     SkGlyphCache*       fNext, *fPrev;
@@ -202,21 +233,38 @@ private:
     SkScalerContext*    fScalerContext;
     SkPaint::FontMetrics fFontMetrics;
 
+    // Guards fScalerContext, fGlyphArray, fGlyphAlloc, fMemoryUsed,
+    // fAuxProcList, and all writes to the hash tables below.
+    mutable SkMutex     fMutex;
+
     enum {
         kHashBits   = 8,
         kHashCount  = 1 << kHashBits,
         kHashMask   = kHashCount - 1
     };
-    SkGlyph*            fGlyphHash[kHashCount];
+
+    /*  The two hash tables are read without holding fMutex. Each slot is a
+        single word: a pointer (an SkGlyph* or a CharGlyphRec*), with the low
+        bit set if the glyph had full metrics when it was published. Whatever
+        a slot points at is fully initialized before the slot is written, and
+        its metrics are never modified afterwards, except for a just-advance
+        glyph being upgraded to full metrics, which is republished with the
+        bit set.
+    */
+    enum {
+        kFullMetrics_SlotBit = 1
+    };
+    uintptr_t           fGlyphHash[kHashCount];
     SkTDArray<SkGlyph*> fGlyphArray;
     SkChunkAlloc        fGlyphAlloc;
 
+    // Immutable once published in fCharToGlyphHash.
     struct CharGlyphRec {
         uint32_t    fID;    // unichar + subpixel
         SkGlyph*    fGlyph;
     };
     // no reason to use the same kHashCount as fGlyphHash, but we do for now
-    CharGlyphRec    fCharToGlyphHash[kHashCount];
+    uintptr_t       fCharToGlyphHash[kHashCount];
 
     static inline unsigned ID2HashIndex(uint32_t id) {
         id ^= id >> 16;
@@ -227,6 +275,23 @@ private:
     // used to track (approx) how much ram is tied-up in this cache
     size_t  fMemoryUsed;
 
+    // The following are guarded by the owning SkGlyphCache_Globals' mutex.
+    // number of callers that have this strike from VisitCache/DetachCache
+    int32_t fUseCount;
+    // the value of fMemoryUsed last reported to SkGlyphCache_Globals
+    size_t  fMemoryAccounted;
+
+    // Keys for SkGlyphCache_Globals' descriptor hash
+    static const SkDescriptor& GetKey(const SkGlyphCache& cache) {
+        return *cache.fDesc;
+    }
+    static uint32_t Hash(const SkDescriptor& desc) {
+        return desc.getChecksum();
+    }
+    static bool Equal(const SkGlyphCache& cache, const SkDescriptor& desc) {
+        return cache.fDesc->equals(desc);
+    }
+
     struct AuxProcRec {
         AuxProcRec* fNext;
         void (*fProc)(void*);
@@ -9,6 +9,7 @@
 #define SkGlyphCache_Globals_DEFINED
 
 #include "SkGlyphCache.h"
+#include "SkTDynamicHash.h"
 #include "SkTLS.h"
 
 #ifndef SK_DEFAULT_FONT_CACHE_COUNT_LIMIT
@@ -80,12 +81,19 @@ public:
 
     void purgeAll(); // does not change budget
 
-    // call when a glyphcache is available for caching (i.e. not in use)
-    void attachCacheToHead(SkGlyphCache*);
+    // call when a caller is done with a glyphcache returned by VisitCache
+    void releaseCache(SkGlyphCache*);
 
     // can only be called when the mutex is already held
+    SkGlyphCache* internalFind(const SkDescriptor& desc) const {
+        return fHash.find(desc);
+    }
     void internalDetachCache(SkGlyphCache*);
     void internalAttachCacheToHead(SkGlyphCache*);
+    void internalMoveToHead(SkGlyphCache*);
+    // folds any growth of the cache since it was last accounted for into
+    // fTotalMemoryUsed.
+    void internalUpdateMemoryUsed(SkGlyphCache*);
 
     // can return NULL
     static SkGlyphCache_Globals* FindTLS() {
@@ -99,7 +107,14 @@ public:
     static void DeleteTLS() { SkTLS::Delete(CreateTLS); }
 
 private:
+    typedef SkTDynamicHash<SkGlyphCache, SkDescriptor,
+                           SkGlyphCache::GetKey,
+                           SkGlyphCache::Hash,
+                           SkGlyphCache::Equal> DescriptorHash;
+
     SkGlyphCache* fHead;
+    // every cache in the list, keyed by its descriptor
+    DescriptorHash fHash;
     size_t  fTotalMemoryUsed;
     size_t  fCacheSizeLimit;
     int32_t fCacheCountLimit;
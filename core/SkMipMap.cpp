@@ -8,33 +8,31 @@
 #include "SkMipMap.h"
 #include "SkBitmap.h"
 #include "SkColorPriv.h"
-
-static void downsampleby2_proc32(SkBitmap* dst, int x, int y,
-                                 const SkBitmap& src) {
-    x <<= 1;
-    y <<= 1;
-    const SkPMColor* p = src.getAddr32(x, y);
-    const SkPMColor* baseP = p;
-    SkPMColor c, ag, rb;
-
-    c = *p; ag = (c >> 8) & 0xFF00FF; rb = c & 0xFF00FF;
-    if (x < src.width() - 1) {
-        p += 1;
-    }
-    c = *p; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
-
-    p = baseP;
-    if (y < src.height() - 1) {
-        p += src.rowBytes() >> 2;
-    }
-    c = *p; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
-    if (x < src.width() - 1) {
-        p += 1;
+#include "SkMipMap_opts.h"
+#include "SkParallel.h"
+
+// Each of these writes count pixels of a level row, where pixel x is the
+// average of pixels 2x and 2x+1 of both src rows. A level is half the size of
+// the one above it, rounded down, so those pixels are always there.
+
+static void downsample_row32(void* dst, const void* src0, const void* src1,
+                             int count) {
+    const SkPMColor* p0 = static_cast<const SkPMColor*>(src0);
+    const SkPMColor* p1 = static_cast<const SkPMColor*>(src1);
+    SkPMColor* d = static_cast<SkPMColor*>(dst);
+
+    for (int x = 0; x < count; ++x) {
+        SkPMColor c, ag, rb;
+
+        c = p0[0]; ag = (c >> 8) & 0xFF00FF; rb = c & 0xFF00FF;
+        c = p0[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = p1[0]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = p1[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+
+        d[x] = ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
+        p0 += 2;
+        p1 += 2;
     }
-    c = *p; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
-
-    *dst->getAddr32(x >> 1, y >> 1) =
-    ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
 }
 
 static inline uint32_t expand16(U16CPU c) {
@@ -47,31 +45,19 @@ static inline U16CPU pack16(uint32_t c) {
     return (c & ~SK_G16_MASK_IN_PLACE) | ((c >> 16) & SK_G16_MASK_IN_PLACE);
 }
 
-static void downsampleby2_proc16(SkBitmap* dst, int x, int y,
-                                 const SkBitmap& src) {
-    x <<= 1;
-    y <<= 1;
-    const uint16_t* p = src.getAddr16(x, y);
-    const uint16_t* baseP = p;
-    SkPMColor       c;
-
-    c = expand16(*p);
-    if (x < src.width() - 1) {
-        p += 1;
-    }
-    c += expand16(*p);
-
-    p = baseP;
-    if (y < src.height() - 1) {
-        p += src.rowBytes() >> 1;
+static void downsample_row16(void* dst, const void* src0, const void* src1,
+                             int count) {
+    const uint16_t* p0 = static_cast<const uint16_t*>(src0);
+    const uint16_t* p1 = static_cast<const uint16_t*>(src1);
+    uint16_t* d = static_cast<uint16_t*>(dst);
+
+    for (int x = 0; x < count; ++x) {
+        uint32_t c = expand16(p0[0]) + expand16(p0[1]) +
+                     expand16(p1[0]) + expand16(p1[1]);
+        d[x] = (uint16_t)pack16(c >> 2);
+        p0 += 2;
+        p1 += 2;
     }
-    c += expand16(*p);
-    if (x < src.width() - 1) {
-        p += 1;
-    }
-    c += expand16(*p);
-
-    *dst->getAddr16(x >> 1, y >> 1) = (uint16_t)pack16(c >> 2);
 }
 
 static uint32_t expand4444(U16CPU c) {
@@ -82,31 +68,122 @@ static U16CPU collaps4444(uint32_t c) {
     return (c & 0xF0F) | ((c >> 12) & ~0xF0F);
 }
 
-static void downsampleby2_proc4444(SkBitmap* dst, int x, int y,
-                                   const SkBitmap& src) {
-    x <<= 1;
-    y <<= 1;
-    const uint16_t* p = src.getAddr16(x, y);
-    const uint16_t* baseP = p;
-    uint32_t        c;
-
-    c = expand4444(*p);
-    if (x < src.width() - 1) {
-        p += 1;
+static void downsample_row4444(void* dst, const void* src0, const void* src1,
+                               int count) {
+    const uint16_t* p0 = static_cast<const uint16_t*>(src0);
+    const uint16_t* p1 = static_cast<const uint16_t*>(src1);
+    uint16_t* d = static_cast<uint16_t*>(dst);
+
+    for (int x = 0; x < count; ++x) {
+        uint32_t c = expand4444(p0[0]) + expand4444(p0[1]) +
+                     expand4444(p1[0]) + expand4444(p1[1]);
+        d[x] = (uint16_t)collaps4444(c >> 2);
+        p0 += 2;
+        p1 += 2;
     }
-    c += expand4444(*p);
+}
+
+typedef void (*DownsampleRowProc)(void* dst, const void* src0, const void* src1,
+                                  int count);
 
-    p = baseP;
-    if (y < src.height() - 1) {
-        p += src.rowBytes() >> 1;
+struct DownsampleProcs {
+    DownsampleRowProc   fProc;
+    SkDownsampleRowProc fPlatformProc;  // may be NULL
+    int                 fBytesPerPixel;
+};
+
+static bool choose_procs(SkBitmap::Config config, DownsampleProcs* procs) {
+    switch (config) {
+        case SkBitmap::kARGB_8888_Config:
+            procs->fProc = downsample_row32;
+            procs->fPlatformProc = SkMipMapGetPlatformProc(k8888_SkMipMapProcType);
+            procs->fBytesPerPixel = 4;
+            return true;
+        case SkBitmap::kRGB_565_Config:
+            procs->fProc = downsample_row16;
+            procs->fPlatformProc = SkMipMapGetPlatformProc(k565_SkMipMapProcType);
+            procs->fBytesPerPixel = 2;
+            return true;
+        case SkBitmap::kARGB_4444_Config:
+            procs->fProc = downsample_row4444;
+            procs->fPlatformProc = SkMipMapGetPlatformProc(k4444_SkMipMapProcType);
+            procs->fBytesPerPixel = 2;
+            return true;
+        case SkBitmap::kIndex8_Config:
+        case SkBitmap::kA8_Config:
+        default:
+            return false; // don't build mipmaps for these configs
     }
-    c += expand4444(*p);
-    if (x < src.width() - 1) {
-        p += 1;
+}
+
+// Levels with fewer pixels than this are not worth splitting across threads.
+static const int kMinPixelsPerBand = 32 * 1024;
+
+struct DownsampleRec {
+    DownsampleProcs fProcs;
+    const uint8_t*  fSrc;
+    size_t          fSrcRowBytes;
+    uint8_t*        fDst;
+    size_t          fDstRowBytes;
+    int             fWidth;     // of dst
+};
+
+static void downsample_rows(void* context, int start, int stop) {
+    const DownsampleRec& rec = *static_cast<const DownsampleRec*>(context);
+    const int bpp = rec.fProcs.fBytesPerPixel;
+
+    for (int y = start; y < stop; ++y) {
+        const uint8_t* src0 = rec.fSrc + 2 * y * rec.fSrcRowBytes;
+        const uint8_t* src1 = src0 + rec.fSrcRowBytes;
+        uint8_t* dst = rec.fDst + y * rec.fDstRowBytes;
+
+        int done = 0;
+        if (rec.fProcs.fPlatformProc) {
+            done = rec.fProcs.fPlatformProc(dst, src0, src1, rec.fWidth);
+        }
+        if (done < rec.fWidth) {
+            rec.fProcs.fProc(dst + done * bpp, src0 + 2 * done * bpp,
+                             src1 + 2 * done * bpp, rec.fWidth - done);
+        }
+    }
+}
+
+// Computes levels [start, stop). The first of them is downsampled from src
+// if start is 0, and from levels[start - 1] otherwise. Returns false if src's
+// pixels were needed but could not be locked.
+static bool downsample_levels(const SkBitmap& src, const SkMipMap::Level levels[],
+                              int start, int stop) {
+    DownsampleRec rec;
+    SkAssertResult(choose_procs(src.config(), &rec.fProcs));
+
+    SkAutoLockPixels alp(src, 0 == start);
+    if (0 == start) {
+        if (!src.readyToDraw()) {
+            return false;
+        }
+        rec.fSrc = static_cast<const uint8_t*>(src.getPixels());
+        rec.fSrcRowBytes = src.rowBytes();
+    } else {
+        rec.fSrc = static_cast<const uint8_t*>(levels[start - 1].fPixels);
+        rec.fSrcRowBytes = levels[start - 1].fRowBytes;
     }
-    c += expand4444(*p);
 
-    *dst->getAddr16(x >> 1, y >> 1) = (uint16_t)collaps4444(c >> 2);
+    for (int i = start; i < stop; ++i) {
+        const SkMipMap::Level& level = levels[i];
+        rec.fDst = static_cast<uint8_t*>(level.fPixels);
+        rec.fDstRowBytes = level.fRowBytes;
+        rec.fWidth = level.fWidth;
+
+        // Each level is read by the next, so only the rows of one level are
+        // done in parallel.
+        SkParallel::ForRanges(level.fHeight,
+                              SkMax32(1, kMinPixelsPerBand / (int)level.fWidth),
+                              downsample_rows, &rec);
+
+        rec.fSrc = rec.fDst;
+        rec.fSrcRowBytes = rec.fDstRowBytes;
+    }
+    return true;
 }
 
 SkMipMap::Level* SkMipMap::AllocLevels(int levelCount, size_t pixelSize) {
@@ -120,24 +197,11 @@ SkMipMap::Level* SkMipMap::AllocLevels(int levelCount, size_t pixelSize) {
     return (Level*)sk_malloc_throw(sk_64_asS32(size));
 }
 
-SkMipMap* SkMipMap::Build(const SkBitmap& src) {
-    void (*proc)(SkBitmap* dst, int x, int y, const SkBitmap& src);
-
+SkMipMap* SkMipMap::Build(const SkBitmap& src, BuildMode mode) {
     const SkBitmap::Config config = src.config();
-    switch (config) {
-        case SkBitmap::kARGB_8888_Config:
-            proc = downsampleby2_proc32;
-            break;
-        case SkBitmap::kRGB_565_Config:
-            proc = downsampleby2_proc16;
-            break;
-        case SkBitmap::kARGB_4444_Config:
-            proc = downsampleby2_proc4444;
-            break;
-        case SkBitmap::kIndex8_Config:
-        case SkBitmap::kA8_Config:
-        default:
-            return NULL; // don't build mipmaps for these configs
+    DownsampleProcs procs;
+    if (!choose_procs(config, &procs)) {
+        return NULL;
     }
 
     SkAutoLockPixels alp(src);
@@ -175,7 +239,6 @@ SkMipMap* SkMipMap::Build(const SkBitmap& src) {
     int         width = src.width();
     int         height = src.height();
     uint32_t    rowBytes;
-    SkBitmap    srcBM(src);
 
     for (int i = 0; i < countLevels; ++i) {
         width >>= 1;
@@ -188,34 +251,29 @@ SkMipMap* SkMipMap::Build(const SkBitmap& src) {
         levels[i].fRowBytes = rowBytes;
         levels[i].fScale    = (float)width / src.width();
 
-        SkBitmap dstBM;
-        dstBM.setConfig(config, width, height, rowBytes);
-        dstBM.setPixels(addr);
-
-        srcBM.lockPixels();
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                proc(&dstBM, x, y, srcBM);
-            }
-        }
-        srcBM.unlockPixels();
-
-        srcBM = dstBM;
         addr += height * rowBytes;
     }
     SkASSERT(addr == baseAddr + size);
 
-    return SkNEW_ARGS(SkMipMap, (levels, countLevels, size));
+    if (kLazy_BuildMode == mode) {
+        return SkNEW_ARGS(SkMipMap, (levels, countLevels, size, &src));
+    }
+    SkAssertResult(downsample_levels(src, levels, 0, countLevels));
+    return SkNEW_ARGS(SkMipMap, (levels, countLevels, size, NULL));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 //static int gCounter;
 
-SkMipMap::SkMipMap(Level* levels, int count, size_t size)
-    : fSize(size), fLevels(levels), fCount(count) {
+SkMipMap::SkMipMap(Level* levels, int count, size_t size, const SkBitmap* lazySource)
+    : fSize(size), fLevels(levels), fCount(count)
+    , fLazy(lazySource != NULL), fBuiltCount(fLazy ? 0 : count) {
     SkASSERT(levels);
     SkASSERT(count > 0);
+    if (fLazy) {
+        fSource = *lazySource;
+    }
 //    SkDebugf("mips %d\n", ++gCounter);
 }
 
@@ -249,8 +307,26 @@ bool SkMipMap::extractLevel(SkScalar scale, Level* levelPtr) const {
     if (level > fCount) {
         level = fCount;
     }
+    if (fLazy && !this->buildLevels(level)) {
+        return false;
+    }
     if (levelPtr) {
         *levelPtr = fLevels[level - 1];
     }
     return true;
 }
+
+bool SkMipMap::buildLevels(int count) const {
+    SkASSERT(fLazy);
+    SkAutoMutexAcquire lock(fMutex);
+
+    if (count > fBuiltCount) {
+        if (!downsample_levels(fSource, fLevels, fBuiltCount, count)) {
+            return false;
+        }
+        fBuiltCount = count;
+        // Only the first level is made from the source.
+        fSource.reset();
+    }
+    return true;
+}
@@ -8,14 +8,29 @@
 #ifndef SkMipMap_DEFINED
 #define SkMipMap_DEFINED
 
+#include "SkBitmap.h"
 #include "SkRefCnt.h"
 #include "SkScalar.h"
-
-class SkBitmap;
+#include "SkThread.h"
 
 class SkMipMap : public SkRefCnt {
 public:
-    static SkMipMap* Build(const SkBitmap& src);
+    enum BuildMode {
+        /** Build() computes every level. */
+        kEager_BuildMode,
+        /** Build() only allocates the levels. A level is computed the first
+         *  time extractLevel() returns it (or a smaller one), and until the
+         *  first level is computed the mipmap holds a ref to src's pixels. */
+        kLazy_BuildMode
+    };
+
+    /** Returns NULL if src's config is not supported, its pixels can't be
+     *  locked, or it is too small to have any levels.
+     *
+     *  Big levels are split into bands of rows that are downsampled on the
+     *  threads SkParallel provides.
+     */
+    static SkMipMap* Build(const SkBitmap& src, BuildMode = kEager_BuildMode);
 
     struct Level {
         void*       fPixels;
@@ -32,12 +47,23 @@ private:
     size_t  fSize;
     Level*  fLevels;
     int     fCount;
+    bool    fLazy;
 
-    // we take ownership of levels, and will free it with sk_free()
-    SkMipMap(Level* levels, int count, size_t size);
+    // Only change for lazy mipmaps, under fMutex. fSource is empty once the
+    // first level is built.
+    mutable SkMutex     fMutex;
+    mutable SkBitmap    fSource;
+    mutable int         fBuiltCount;
+
+    // we take ownership of levels, and will free it with sk_free().
+    // lazySource is NULL if the levels are already built.
+    SkMipMap(Level* levels, int count, size_t size, const SkBitmap* lazySource);
     virtual ~SkMipMap();
 
     static Level* AllocLevels(int levelCount, size_t pixelSize);
+
+    // Makes sure the first count levels are built.
+    bool buildLevels(int count) const;
 };
 
 #endif
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkParallel.h"
+
+static SkParallel::Executor* gExecutor = NULL;
+
+void SkParallel::SetExecutor(Executor* executor) {
+    gExecutor = executor;
+}
+
+int SkParallel::Concurrency() {
+    return gExecutor ? SkMax32(1, gExecutor->concurrency()) : 1;
+}
+
+void SkParallel::For(int count, Proc proc, void* context) {
+    if (count <= 0) {
+        return;
+    }
+    if (1 == count || NULL == gExecutor) {
+        for (int i = 0; i < count; ++i) {
+            proc(context, i);
+        }
+        return;
+    }
+    gExecutor->parallelFor(count, proc, context);
+}
+
+namespace {
+
+struct RangeRec {
+    SkParallel::RangeProc   fProc;
+    void*                   fContext;
+    int                     fCount;
+    int                     fRangeCount;
+};
+
+}  // namespace
+
+static void run_range(void* context, int index) {
+    const RangeRec* rec = static_cast<const RangeRec*>(context);
+    // Spread the remainder over the first ranges so sizes differ by at most 1.
+    int64_t start = (int64_t)rec->fCount * index / rec->fRangeCount;
+    int64_t stop = (int64_t)rec->fCount * (index + 1) / rec->fRangeCount;
+    rec->fProc(rec->fContext, (int)start, (int)stop);
+}
+
+void SkParallel::ForRanges(int count, int minPerRange, RangeProc proc, void* context) {
+    if (count <= 0) {
+        return;
+    }
+    minPerRange = SkMax32(minPerRange, 1);
+
+    int rangeCount = SkMin32(Concurrency(), count / minPerRange);
+    if (rangeCount <= 1) {
+        proc(context, 0, count);
+        return;
+    }
+
+    RangeRec rec = { proc, context, count, rangeCount };
+    For(rangeCount, run_range, &rec);
+}
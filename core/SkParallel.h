@@ -0,0 +1,72 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkParallel_DEFINED
+#define SkParallel_DEFINED
+
+#include "SkTypes.h"
+
+/**
+ *  Lets core and effects code split independent work across threads without
+ *  depending on a particular thread pool.
+ *
+ *  Nothing is installed by default, in which case For() and ForRanges() just
+ *  run everything on the calling thread. An embedder that wants parallelism
+ *  installs an Executor (e.g. an SkWorkerPool from utils) at startup.
+ */
+class SkParallel {
+public:
+    typedef void (*Proc)(void* context, int index);
+    typedef void (*RangeProc)(void* context, int start, int stop);
+
+    class Executor {
+    public:
+        virtual ~Executor() {}
+
+        /**
+         *  Call proc(context, i) for every i in [0, count), possibly
+         *  concurrently, and return once all of them have finished. This may
+         *  be called from inside a proc, so an implementation must not block
+         *  waiting for work that only its own (busy) threads could start.
+         */
+        virtual void parallelFor(int count, Proc proc, void* context) = 0;
+
+        /**
+         *  The number of procs that can usefully run at once.
+         */
+        virtual int concurrency() const = 0;
+    };
+
+    /**
+     *  Install the executor used by For() and ForRanges(), or NULL to run
+     *  everything serially. The executor is not owned and must outlive any
+     *  call that might use it. This is not synchronized with in-flight
+     *  For() calls, so it should be done once at startup.
+     */
+    static void SetExecutor(Executor*);
+
+    /**
+     *  Returns how many procs may run at once: 1 when no executor is set.
+     */
+    static int Concurrency();
+
+    /**
+     *  Call proc(context, i) for every i in [0, count). Returns when all the
+     *  calls have finished.
+     */
+    static void For(int count, Proc proc, void* context);
+
+    /**
+     *  Split [0, count) into contiguous ranges of at least minPerRange items
+     *  (at most one range per available thread) and call
+     *  proc(context, start, stop) for each. Returns when all the calls have
+     *  finished. With no executor this is a single proc(context, 0, count).
+     */
+    static void ForRanges(int count, int minPerRange, RangeProc proc, void* context);
+};
+
+#endif
@@ -423,6 +423,9 @@ void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder) const {
 
     SkPictInfo header;
     this->createHeader(&header);
+#ifdef SK_PICTURE_ALIGNED_DATA
+    header.fFlags |= SkPictInfo::kAlignedData_Flag;
+#endif
     stream->write(&header, sizeof(header));
     if (playback) {
         stream->writeBool(true);
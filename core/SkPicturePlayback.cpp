@@ -317,6 +317,18 @@ static void write_tag_size(SkWStream* stream, uint32_t tag,  uint32_t size) {
     stream->write32(size);
 }
 
+#ifdef SK_PICTURE_ALIGNED_DATA
+// Writes a pad count byte followed by that many zeros, so that whatever is
+// written next starts 4-byte aligned in the stream.
+static void write_data_padding(SkWStream* stream) {
+    size_t padCount = (4 - ((stream->bytesWritten() + 1) & 3)) & 3;
+    stream->write8(padCount);
+    for (size_t i = 0; i < padCount; ++i) {
+        stream->write8(0);
+    }
+}
+#endif
+
 static size_t compute_chunk_size(SkFlattenable::Factory* array, int count) {
     size_t size = 4;  // for 'count'
 
@@ -403,6 +415,9 @@ void SkPicturePlayback::flattenToBuffer(SkWriteBuffer& buffer) const {
 void SkPicturePlayback::serialize(SkWStream* stream,
                                   SkPicture::EncodeBitmap encoder) const {
     write_tag_size(stream, SK_PICT_READER_TAG, fOpData->size());
+#ifdef SK_PICTURE_ALIGNED_DATA
+    write_data_padding(stream);
+#endif
     stream->write(fOpData->bytes(), fOpData->size());
 
     if (fPictureCount > 0) {
@@ -432,6 +447,9 @@ void SkPicturePlayback::serialize(SkWStream* stream,
         write_typefaces(stream, typefaceSet);
 
         write_tag_size(stream, SK_PICT_BUFFER_SIZE_TAG, buffer.bytesWritten());
+#ifdef SK_PICTURE_ALIGNED_DATA
+        write_data_padding(stream);
+#endif
         buffer.writeToStream(stream);
     }
 
@@ -479,6 +497,66 @@ static uint32_t pictInfoFlagsToReadBufferFlags(uint32_t pictInfoFlags) {
     return rbMask;
 }
 
+static bool skip_data_padding(SkStream* stream) {
+    size_t padCount = stream->readU8();
+    return padCount < 4 && stream->skip(padCount) == padCount;
+}
+
+static void unref_stream_proc(const void*, size_t, void* context) {
+    static_cast<SkStream*>(context)->unref();
+}
+
+// If the next size bytes of stream are in memory, 4-byte aligned, and can be
+// kept alive by a duplicate of the stream, returns them wrapped in an SkData
+// that holds that duplicate, and skips past them. Otherwise returns NULL and
+// leaves the stream untouched.
+static SkData* share_stream_data(SkStream* stream, size_t size) {
+    const char* base = static_cast<const char*>(stream->getMemoryBase());
+    if (NULL == base || !stream->hasPosition() || !stream->hasLength()) {
+        return NULL;
+    }
+    size_t position = stream->getPosition();
+    if (size > stream->getLength() - position || !SkIsAlign4((uintptr_t)(base + position))) {
+        return NULL;
+    }
+
+    // An SkMemoryStream (which is what SkStream::NewFromFile returns for a
+    // mapped file) shares its memory with its duplicates.
+    SkStream* owner = stream->duplicate();
+    if (NULL == owner) {
+        return NULL;
+    }
+    if (owner->getMemoryBase() != base) {
+        owner->unref();
+        return NULL;
+    }
+    if (stream->skip(size) != size) {
+        owner->unref();
+        return NULL;
+    }
+    return SkData::NewWithProc(base + position, size, unref_stream_proc, owner);
+}
+
+// Reads a block of picture data from stream, sharing the stream's memory
+// when share_stream_data() can and copying it otherwise.
+static SkData* read_stream_data(SkStream* stream, const SkPictInfo& info, size_t size) {
+    if (info.fFlags & SkPictInfo::kAlignedData_Flag) {
+        if (!skip_data_padding(stream)) {
+            return NULL;
+        }
+        SkData* data = share_stream_data(stream, size);
+        if (NULL != data) {
+            return data;
+        }
+    }
+
+    SkAutoMalloc storage(size);
+    if (stream->read(storage.get(), size) != size) {
+        return NULL;
+    }
+    return SkData::NewFromMalloc(storage.detach(), size);
+}
+
 bool SkPicturePlayback::parseStreamTag(SkStream* stream, const SkPictInfo& info, uint32_t tag,
                                        size_t size, SkPicture::InstallPixelRefProc proc) {
     /*
@@ -494,12 +572,11 @@ bool SkPicturePlayback::parseStreamTag(SkStream* stream, const SkPictInfo& info,
 
     switch (tag) {
         case SK_PICT_READER_TAG: {
-            SkAutoMalloc storage(size);
-            if (stream->read(storage.get(), size) != size) {
+            SkASSERT(NULL == fOpData);
+            fOpData = read_stream_data(stream, info, size);
+            if (NULL == fOpData) {
                 return false;
             }
-            SkASSERT(NULL == fOpData);
-            fOpData = SkData::NewFromMalloc(storage.detach(), size);
         } break;
         case SK_PICT_FACTORY_TAG: {
             SkASSERT(!haveBuffer);
@@ -562,12 +639,12 @@ bool SkPicturePlayback::parseStreamTag(SkStream* stream, const SkPictInfo& info,
             }
         } break;
         case SK_PICT_BUFFER_SIZE_TAG: {
-            SkAutoMalloc storage(size);
-            if (stream->read(storage.get(), size) != size) {
+            SkAutoTUnref<SkData> data(read_stream_data(stream, info, size));
+            if (NULL == data.get()) {
                 return false;
             }
 
-            SkReadBuffer buffer(storage.get(), size);
+            SkReadBuffer buffer(data->data(), size);
             buffer.setFlags(pictInfoFlagsToReadBufferFlags(info.fFlags));
 
             fFactoryPlayback->setupBuffer(buffer);
@@ -38,6 +38,10 @@ struct SkPictInfo {
         kCrossProcess_Flag      = 1 << 0,
         kScalarIsFloat_Flag     = 1 << 1,
         kPtrIs64Bit_Flag        = 1 << 2,
+        // The op data and the flattened buffer in a stream are padded so that
+        // they start 4-byte aligned, letting a memory-mapped stream be read in
+        // place. Only written when SK_PICTURE_ALIGNED_DATA is defined.
+        kAlignedData_Flag       = 1 << 3,
     };
 
     char        fMagic[8];
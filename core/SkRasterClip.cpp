@@ -6,6 +6,7 @@
  */
 
 #include "SkRasterClip.h"
+#include "SkAAClipCache.h"
 
 
 SkRasterClip::SkRasterClip() {
@@ -81,7 +82,12 @@ bool SkRasterClip::setPath(const SkPath& path, const SkRegion& clip, bool doAA)
         if (this->isBW()) {
             this->convertToAA();
         }
-        (void)fAA.setPath(path, &clip, doAA);
+        // The coverage of a path within a rect is the same as its whole mask
+        // intersected with the rect, so those can come from the cache.
+        if (!doAA || !clip.isRect() ||
+                !SkAAClipCache::SetPath(path, clip.getBounds(), &fAA)) {
+            (void)fAA.setPath(path, &clip, doAA);
+        }
     }
     return this->updateCacheAndReturnNonEmpty();
 }
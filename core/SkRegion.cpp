@@ -8,7 +8,9 @@
 
 
 #include "SkRegionPriv.h"
+#include "SkTDArray.h"
 #include "SkTemplates.h"
+#include "SkTSort.h"
 #include "SkThread.h"
 #include "SkUtils.h"
 
@@ -287,14 +289,20 @@ bool SkRegion::setRuns(RunType runs[], int count) {
 
     //  if we get here, we need to become a complex region
 
-    if (!this->isComplex() || fRunHead->fRunCount != count) {
+    if (this->isComplex() && 1 == fRunHead->fRefCnt) {
+        // We are the only owner, so resize our RunHead in place (realloc can
+        // usually grow or shrink the block without moving it) rather than
+        // freeing it and allocating another.
+        if (fRunHead->fRunCount != count) {
+            fRunHead = RunHead::Realloc(fRunHead, count);
+        }
+    } else {
+        // Sharing the buffer with another region would have ensureWritable()
+        // copy runs that are about to be overwritten, so start afresh.
         this->freeRuns();
         this->allocateRuns(count);
     }
-
-    // must call this before we can write directly into runs()
-    // in case we are sharing the buffer with another region (copy on write)
-    fRunHead = fRunHead->ensureWritable();
+    SkASSERT(1 == fRunHead->fRefCnt);
     memcpy(fRunHead->writable_runs(), runs, count * sizeof(RunType));
     fRunHead->computeRunBounds(&fBounds);
 
@@ -591,16 +599,101 @@ void SkRegion::translate(int dx, int dy, SkRegion* dst) const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+struct RectTopLessThan {
+    bool operator()(const SkIRect& a, const SkIRect& b) const {
+        return a.fTop < b.fTop;
+    }
+};
+
+/*  Unioning the rects one at a time costs an op() per rect, each walking
+    everything unioned so far. Instead, sweep down through the distinct tops
+    and bottoms, keeping the rects that cover the current band sorted by their
+    left edge, and merge their x-ranges into that band's intervals.
+ */
 bool SkRegion::setRects(const SkIRect rects[], int count) {
-    if (0 == count) {
-        this->setEmpty();
-    } else {
-        this->setRect(rects[0]);
-        for (int i = 1; i < count; i++) {
-            this->op(rects[i], kUnion_Op);
+    SkTDArray<SkIRect> sorted;
+    SkTDArray<RunType> ys;
+    sorted.setReserve(count);
+    ys.setReserve(count * 2);
+    for (int i = 0; i < count; i++) {
+        if (!rects[i].isEmpty()) {
+            *sorted.append() = rects[i];
+            *ys.append() = rects[i].fTop;
+            *ys.append() = rects[i].fBottom;
         }
     }
-    return !this->isEmpty();
+    if (0 == sorted.count()) {
+        return this->setEmpty();
+    }
+    if (1 == sorted.count()) {
+        return this->setRect(sorted[0]);
+    }
+    SkTQSort(sorted.begin(), sorted.end() - 1, RectTopLessThan());
+    SkTQSort(ys.begin(), ys.end() - 1);
+
+    SkTDArray<const SkIRect*> active;
+    SkTDArray<RunType> runs;
+    *runs.append() = ys[0];
+    int prevRow = -1;   // index of the last row's bottom in runs
+    int nextRect = 0;   // first rect in sorted that is not active yet
+
+    for (int i = 0; i + 1 < ys.count(); i++) {
+        const int top = ys[i];
+        const int bottom = ys[i + 1];
+        if (top == bottom) {
+            continue;
+        }
+
+        // drop the rects that ended above this band, and add the ones that
+        // start at its top (every top is in ys, so none can be skipped)
+        int kept = 0;
+        for (int j = 0; j < active.count(); j++) {
+            if (active[j]->fBottom > top) {
+                active[kept++] = active[j];
+            }
+        }
+        active.setCount(kept);
+        while (nextRect < sorted.count() && sorted[nextRect].fTop == top) {
+            const SkIRect* rect = &sorted[nextRect++];
+            int j = active.count();
+            active.append();
+            while (j > 0 && active[j - 1]->fLeft > rect->fLeft) {
+                active[j] = active[j - 1];
+                j -= 1;
+            }
+            active[j] = rect;
+        }
+
+        const int rowStart = runs.count();
+        *runs.append() = bottom;
+        *runs.append() = 0;     // interval count, filled in below
+        int intervals = 0;
+        for (int j = 0; j < active.count();) {
+            int left = active[j]->fLeft;
+            int rite = active[j]->fRight;
+            for (j++; j < active.count() && active[j]->fLeft <= rite; j++) {
+                rite = SkMax32(rite, active[j]->fRight);
+            }
+            *runs.append() = left;
+            *runs.append() = rite;
+            intervals += 1;
+        }
+        *runs.append() = kRunTypeSentinel;
+        runs[rowStart + 1] = intervals;
+
+        // a row with the same intervals as the one above just extends it
+        if (prevRow >= 0 && runs[prevRow + 1] == intervals &&
+                !memcmp(&runs[prevRow + 2], &runs[rowStart + 2],
+                        intervals * 2 * sizeof(RunType))) {
+            runs[prevRow] = bottom;
+            runs.setCount(rowStart);
+        } else {
+            prevRow = rowStart;
+        }
+    }
+    *runs.append() = kRunTypeSentinel;
+
+    return this->setRuns(runs.begin(), runs.count());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -710,6 +803,31 @@ struct spanRec {
     }
 };
 
+/*  Append the interval [left, rite) and the ones in runs[] (up to the
+    x-sentinel) to dst, joining any that touch the interval before it.
+ */
+static SkRegion::RunType* copy_intervals(int left, int rite,
+                                         const SkRegion::RunType runs[],
+                                         SkRegion::RunType dst[],
+                                         bool firstInterval) {
+    for (;;) {
+        if (left < rite) {
+            if (firstInterval || dst[-1] < left) {
+                *dst++ = (SkRegion::RunType)(left);
+                *dst++ = (SkRegion::RunType)(rite);
+                firstInterval = false;
+            } else {
+                dst[-1] = (SkRegion::RunType)(rite);
+            }
+        }
+        left = *runs++;
+        if (SkRegion::kRunTypeSentinel == left) {
+            return dst;
+        }
+        rite = *runs++;
+    }
+}
+
 static SkRegion::RunType* operate_on_span(const SkRegion::RunType a_runs[],
                                           const SkRegion::RunType b_runs[],
                                           SkRegion::RunType dst[],
@@ -720,6 +838,24 @@ static SkRegion::RunType* operate_on_span(const SkRegion::RunType a_runs[],
     rec.init(a_runs, b_runs);
 
     while (!rec.done()) {
+        // Once one side has run out of intervals, the rest of the other side
+        // is either kept or dropped as a whole, so copy it instead of taking
+        // it apart one step at a time.
+        if (SkRegion::kRunTypeSentinel == rec.fB_left) {
+            if ((unsigned)(1 - min) <= (unsigned)(max - min)) {
+                dst = copy_intervals(rec.fA_left, rec.fA_rite, rec.fA_runs,
+                                     dst, firstInterval);
+            }
+            break;
+        }
+        if (SkRegion::kRunTypeSentinel == rec.fA_left) {
+            if ((unsigned)(2 - min) <= (unsigned)(max - min)) {
+                dst = copy_intervals(rec.fB_left, rec.fB_rite, rec.fB_runs,
+                                     dst, firstInterval);
+            }
+            break;
+        }
+
         rec.next();
 
         int left = rec.fLeft;
@@ -84,6 +84,22 @@ public:
         return head;
     }
 
+    /**
+     *  Resize a RunHead that has no other owner to hold count runs, keeping
+     *  the values that fit. The interval and y-span counts must be filled in
+     *  again, as with Alloc(count).
+     */
+    static RunHead* Realloc(RunHead* head, int count) {
+        SkASSERT(1 == head->fRefCnt);
+        SkASSERT(count >= SkRegion::kRectRegionRuns);
+
+        head = (RunHead*)sk_realloc_throw(head, sizeof(RunHead) + count * sizeof(RunType));
+        head->fRunCount = count;
+        head->fYSpanCount = 0;
+        head->fIntervalCount = 0;
+        return head;
+    }
+
     SkRegion::RunType* writable_runs() {
         SkASSERT(fRefCnt == 1);
         return (SkRegion::RunType*)(this + 1);
@@ -10,8 +10,12 @@
 #include "SkOnce.h"
 #include "SkPixelRef.h"
 #include "SkRect.h"
+#include "SkThread.h"
 
-// This can be defined by the caller's build system
+// This can be defined by the caller's build system. The entries are then
+// allocated with SkDiscardableMemory::Create(), so with a shared backend
+// (e.g. ports/SkDiscardableMemory_memfd.cpp) the processes that use it share
+// one budget for decoded and scaled images.
 //#define SK_USE_DISCARDABLE_SCALEDIMAGECACHE
 
 #ifndef SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT
@@ -182,6 +186,7 @@ void SkScaledImageCache::init() {
     fBytesUsed = 0;
     fCount = 0;
     fAllocator = NULL;
+    fSharedBudget = NULL;
 
     // One of these should be explicit set by the caller after we return.
     fByteLimit = 0;
@@ -413,6 +418,22 @@ SkScaledImageCache::ID* SkScaledImageCache::findAndLockMip(const SkBitmap& orig,
     return rec_to_id(rec);
 }
 
+SkScaledImageCache::ID* SkScaledImageCache::findAndLockSubset(uint32_t genID,
+                                                              SkScalar scale,
+                                                              const SkIRect& subset,
+                                                              SkBitmap* bitmap) {
+    if (scale <= 0) {
+        // 0 is the key we use for mipmaps
+        return NULL;
+    }
+    Rec* rec = this->findAndLock(genID, scale, scale, subset);
+    if (rec) {
+        SkASSERT(NULL == rec->fMip);
+        SkASSERT(rec->fBitmap.pixelRef());
+        *bitmap = rec->fBitmap;
+    }
+    return rec_to_id(rec);
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 /**
@@ -437,7 +458,7 @@ SkScaledImageCache::ID* SkScaledImageCache::addAndLock(SkScaledImageCache::Rec*
     fHash->add(rec);
 #endif
     // We may (now) be overbudget, so see if we need to purge something.
-    this->purgeAsNeeded();
+    this->purgeAsNeeded(true);
     return rec_to_id(rec);
 }
 
@@ -478,6 +499,18 @@ SkScaledImageCache::ID* SkScaledImageCache::addAndLockMip(const SkBitmap& orig,
     return this->addAndLock(rec);
 }
 
+SkScaledImageCache::ID* SkScaledImageCache::addAndLockSubset(uint32_t genID,
+                                                             SkScalar scale,
+                                                             const SkIRect& subset,
+                                                             const SkBitmap& bitmap) {
+    if (scale <= 0 || subset.isEmpty()) {
+        return NULL;
+    }
+    Key key(genID, scale, scale, subset);
+    Rec* rec = SkNEW_ARGS(Rec, (key, bitmap));
+    return this->addAndLock(rec);
+}
+
 void SkScaledImageCache::unlock(SkScaledImageCache::ID* id) {
     SkASSERT(id);
 
@@ -506,7 +539,40 @@ void SkScaledImageCache::unlock(SkScaledImageCache::ID* id) {
     }
 }
 
-void SkScaledImageCache::purgeAsNeeded() {
+void SkScaledImageCache::setSharedBudget(SharedBudget* budget) {
+    if (fSharedBudget) {
+        sk_atomic_add(&fSharedBudget->fBytesUsed, -SkToS32(fBytesUsed));
+        sk_atomic_add(&fSharedBudget->fCount, -fCount);
+    }
+    fSharedBudget = budget;
+    if (fSharedBudget) {
+        sk_atomic_add(&fSharedBudget->fBytesUsed, SkToS32(fBytesUsed));
+        sk_atomic_add(&fSharedBudget->fCount, fCount);
+    }
+}
+
+bool SkScaledImageCache::isOverBudget(size_t bytesUsed, int countUsed,
+                                      size_t byteLimit, int countLimit,
+                                      bool justAdded) const {
+    if (NULL == fSharedBudget) {
+        return bytesUsed >= byteLimit || countUsed >= countLimit;
+    }
+    // The reads of the shared budget are deliberately racy: the group's limits
+    // are only enforced approximately.
+    if (countLimit < SK_MaxS32 && fSharedBudget->fCount >= countLimit) {
+        return true;
+    }
+    if (SK_MaxU32 == byteLimit ||
+        (size_t)fSharedBudget->fBytesUsed < fSharedBudget->fByteLimit) {
+        return false;
+    }
+    // The group is over its limit. Give back what we borrowed beyond our fair
+    // share, and if we just added an entry, pay for it even under our share,
+    // so that the caches that fill up last can not take the group over.
+    return justAdded || bytesUsed >= byteLimit;
+}
+
+void SkScaledImageCache::purgeAsNeeded(bool justAdded) {
     size_t byteLimit;
     int    countLimit;
 
@@ -523,7 +589,7 @@ void SkScaledImageCache::purgeAsNeeded() {
 
     Rec* rec = fTail;
     while (rec) {
-        if (bytesUsed < byteLimit && countUsed < countLimit) {
+        if (!this->isOverBudget(bytesUsed, countUsed, byteLimit, countLimit, justAdded)) {
             break;
         }
 
@@ -540,6 +606,10 @@ void SkScaledImageCache::purgeAsNeeded() {
 
             bytesUsed -= used;
             countUsed -= 1;
+            if (fSharedBudget) {
+                sk_atomic_add(&fSharedBudget->fBytesUsed, -SkToS32(used));
+                sk_atomic_dec(&fSharedBudget->fCount);
+            }
         }
         rec = prev;
     }
@@ -612,6 +682,10 @@ void SkScaledImageCache::addToHead(Rec* rec) {
     }
     fBytesUsed += rec->bytesUsed();
     fCount += 1;
+    if (fSharedBudget) {
+        sk_atomic_add(&fSharedBudget->fBytesUsed, SkToS32(rec->bytesUsed()));
+        sk_atomic_inc(&fSharedBudget->fCount);
+    }
 
     this->validate();
 }
@@ -680,35 +754,109 @@ void SkScaledImageCache::dump() const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-#include "SkThread.h"
+// The global cache is split into this many independent shards, selected by
+// hashing the pixel generation ID. Must be a power of 2.
+#ifndef SK_SCALED_IMAGE_CACHE_SHARD_COUNT
+    #define SK_SCALED_IMAGE_CACHE_SHARD_COUNT   16
+#endif
+
+namespace {
+
+struct Shard {
+    Shard() : fCache(NULL), fPending(0), fHits(0), fMisses(0), fContended(0) {}
+    ~Shard() { SkDELETE(fCache); }
+
+    SkMutex             fMutex;
+    SkScaledImageCache* fCache;
+    // number of threads holding or waiting for fMutex
+    int32_t             fPending;
+    // these are only written while holding fMutex, except for fContended
+    int32_t             fHits;
+    int32_t             fMisses;
+    int32_t             fContended;
+};
+
+/**
+ *  Holds a shard's mutex for the lifetime of the object, noting whether
+ *  some other thread already held or was waiting for it.
+ */
+class AutoShardLock : SkNoncopyable {
+public:
+    AutoShardLock(Shard* shard) : fShard(shard) {
+        if (sk_atomic_inc(&fShard->fPending) > 0) {
+            sk_atomic_inc(&fShard->fContended);
+        }
+        fShard->fMutex.acquire();
+    }
+    ~AutoShardLock() {
+        fShard->fMutex.release();
+        sk_atomic_dec(&fShard->fPending);
+    }
+
+private:
+    Shard* fShard;
+};
 
-SK_DECLARE_STATIC_MUTEX(gMutex);
-static SkScaledImageCache* gScaledImageCache = NULL;
-static void cleanup_gScaledImageCache() { SkDELETE(gScaledImageCache); }
+}
+
+static Shard* gShards = NULL;
+static SkScaledImageCache::SharedBudget gSharedBudget;
+
+static void cleanup_gShards() { SkDELETE_ARRAY(gShards); }
+
+static size_t fair_share(size_t byteLimit) {
+    return byteLimit / SK_SCALED_IMAGE_CACHE_SHARD_COUNT;
+}
 
 static void create_cache(int) {
+    SkASSERT(SkIsPow2(SK_SCALED_IMAGE_CACHE_SHARD_COUNT));
+
+    gSharedBudget.fBytesUsed = 0;
+    gSharedBudget.fCount = 0;
+    gSharedBudget.fByteLimit = SK_DEFAULT_IMAGE_CACHE_LIMIT;
+
+    gShards = SkNEW_ARRAY(Shard, SK_SCALED_IMAGE_CACHE_SHARD_COUNT);
+    for (int i = 0; i < SK_SCALED_IMAGE_CACHE_SHARD_COUNT; ++i) {
 #ifdef SK_USE_DISCARDABLE_SCALEDIMAGECACHE
-    gScaledImageCache = SkNEW_ARGS(SkScaledImageCache, (SkDiscardableMemory::Create));
+        gShards[i].fCache = SkNEW_ARGS(SkScaledImageCache, (SkDiscardableMemory::Create));
 #else
-    gScaledImageCache = SkNEW_ARGS(SkScaledImageCache, (SK_DEFAULT_IMAGE_CACHE_LIMIT));
+        gShards[i].fCache = SkNEW_ARGS(SkScaledImageCache,
+                                       (fair_share(SK_DEFAULT_IMAGE_CACHE_LIMIT)));
 #endif
+        gShards[i].fCache->setSharedBudget(&gSharedBudget);
+    }
 }
 
-static SkScaledImageCache* get_cache() {
+static Shard* get_shards() {
     SK_DECLARE_STATIC_ONCE(once);
-    SkOnce(&once, create_cache, 0, cleanup_gScaledImageCache);
-    SkASSERT(NULL != gScaledImageCache);
-    return gScaledImageCache;
+    SkOnce(&once, create_cache, 0, cleanup_gShards);
+    SkASSERT(NULL != gShards);
+    return gShards;
+}
+
+static Shard* get_shard(uint32_t genID) {
+    uint32_t index = compute_hash(&genID, 1) & (SK_SCALED_IMAGE_CACHE_SHARD_COUNT - 1);
+    return &get_shards()[index];
 }
 
+static SkScaledImageCache::ID* record_lookup(Shard* shard, SkScaledImageCache::ID* id) {
+    if (id) {
+        shard->fHits += 1;
+    } else {
+        shard->fMisses += 1;
+    }
+    return id;
+}
 
 SkScaledImageCache::ID* SkScaledImageCache::FindAndLock(
                                 uint32_t pixelGenerationID,
                                 int32_t width,
                                 int32_t height,
                                 SkBitmap* scaled) {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->findAndLock(pixelGenerationID, width, height, scaled);
+    Shard* shard = get_shard(pixelGenerationID);
+    AutoShardLock asl(shard);
+    return record_lookup(shard, shard->fCache->findAndLock(pixelGenerationID, width, height,
+                                                           scaled));
 }
 
 SkScaledImageCache::ID* SkScaledImageCache::AddAndLock(
@@ -716,8 +864,9 @@ SkScaledImageCache::ID* SkScaledImageCache::AddAndLock(
                                int32_t width,
                                int32_t height,
                                const SkBitmap& scaled) {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->addAndLock(pixelGenerationID, width, height, scaled);
+    Shard* shard = get_shard(pixelGenerationID);
+    AutoShardLock asl(shard);
+    return shard->fCache->addAndLock(pixelGenerationID, width, height, scaled);
 }
 
 
@@ -725,60 +874,125 @@ SkScaledImageCache::ID* SkScaledImageCache::FindAndLock(const SkBitmap& orig,
                                                         SkScalar scaleX,
                                                         SkScalar scaleY,
                                                         SkBitmap* scaled) {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->findAndLock(orig, scaleX, scaleY, scaled);
+    Shard* shard = get_shard(orig.getGenerationID());
+    AutoShardLock asl(shard);
+    return record_lookup(shard, shard->fCache->findAndLock(orig, scaleX, scaleY, scaled));
+}
+
+SkScaledImageCache::ID* SkScaledImageCache::FindAndLockSubset(uint32_t pixelGenerationID,
+                                                              SkScalar scale,
+                                                              const SkIRect& subset,
+                                                              SkBitmap* bitmap) {
+    Shard* shard = get_shard(pixelGenerationID);
+    AutoShardLock asl(shard);
+    return record_lookup(shard, shard->fCache->findAndLockSubset(pixelGenerationID, scale,
+                                                                 subset, bitmap));
 }
 
 SkScaledImageCache::ID* SkScaledImageCache::FindAndLockMip(const SkBitmap& orig,
                                                        SkMipMap const ** mip) {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->findAndLockMip(orig, mip);
+    Shard* shard = get_shard(orig.getGenerationID());
+    AutoShardLock asl(shard);
+    return record_lookup(shard, shard->fCache->findAndLockMip(orig, mip));
 }
 
 SkScaledImageCache::ID* SkScaledImageCache::AddAndLock(const SkBitmap& orig,
                                                        SkScalar scaleX,
                                                        SkScalar scaleY,
                                                        const SkBitmap& scaled) {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->addAndLock(orig, scaleX, scaleY, scaled);
+    Shard* shard = get_shard(orig.getGenerationID());
+    AutoShardLock asl(shard);
+    return shard->fCache->addAndLock(orig, scaleX, scaleY, scaled);
+}
+
+SkScaledImageCache::ID* SkScaledImageCache::AddAndLockSubset(uint32_t pixelGenerationID,
+                                                             SkScalar scale,
+                                                             const SkIRect& subset,
+                                                             const SkBitmap& bitmap) {
+    Shard* shard = get_shard(pixelGenerationID);
+    AutoShardLock asl(shard);
+    return shard->fCache->addAndLockSubset(pixelGenerationID, scale, subset, bitmap);
 }
 
 SkScaledImageCache::ID* SkScaledImageCache::AddAndLockMip(const SkBitmap& orig,
                                                           const SkMipMap* mip) {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->addAndLockMip(orig, mip);
+    Shard* shard = get_shard(orig.getGenerationID());
+    AutoShardLock asl(shard);
+    return shard->fCache->addAndLockMip(orig, mip);
 }
 
 void SkScaledImageCache::Unlock(SkScaledImageCache::ID* id) {
-    SkAutoMutexAcquire am(gMutex);
-    get_cache()->unlock(id);
+    // The rec's key is immutable once it is in the cache, so it is safe to
+    // read its genID before taking the shard's lock.
+    Shard* shard = get_shard(id_to_rec(id)->fKey.fGenID);
+    AutoShardLock asl(shard);
+    shard->fCache->unlock(id);
 
-//    get_cache()->dump();
+//    shard->fCache->dump();
 }
 
 size_t SkScaledImageCache::GetBytesUsed() {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->getBytesUsed();
+    Shard* shards = get_shards();
+    size_t bytesUsed = 0;
+    for (int i = 0; i < SK_SCALED_IMAGE_CACHE_SHARD_COUNT; ++i) {
+        AutoShardLock asl(&shards[i]);
+        bytesUsed += shards[i].fCache->getBytesUsed();
+    }
+    return bytesUsed;
 }
 
 size_t SkScaledImageCache::GetByteLimit() {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->getByteLimit();
+    get_shards();
+    return gSharedBudget.fByteLimit;
 }
 
 size_t SkScaledImageCache::SetByteLimit(size_t newLimit) {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->setByteLimit(newLimit);
+    // The shared budget is tracked with 32bit atomics.
+    newLimit = SkTMin<size_t>(newLimit, SK_MaxS32);
+
+    Shard* shards = get_shards();
+    size_t prevLimit = gSharedBudget.fByteLimit;
+    gSharedBudget.fByteLimit = newLimit;
+    for (int i = 0; i < SK_SCALED_IMAGE_CACHE_SHARD_COUNT; ++i) {
+        AutoShardLock asl(&shards[i]);
+        shards[i].fCache->setByteLimit(fair_share(newLimit));
+    }
+    return prevLimit;
 }
 
 SkBitmap::Allocator* SkScaledImageCache::GetAllocator() {
-    SkAutoMutexAcquire am(gMutex);
-    return get_cache()->allocator();
+    // All shards are created with the same DiscardableFactory, so their
+    // allocators are interchangeable.
+    Shard* shard = &get_shards()[0];
+    AutoShardLock asl(shard);
+    return shard->fCache->allocator();
 }
 
 void SkScaledImageCache::Dump() {
-    SkAutoMutexAcquire am(gMutex);
-    get_cache()->dump();
+    Shard* shards = get_shards();
+    for (int i = 0; i < SK_SCALED_IMAGE_CACHE_SHARD_COUNT; ++i) {
+        AutoShardLock asl(&shards[i]);
+        SkDebugf("shard %d: hits=%d misses=%d contended=%d\n", i,
+                 shards[i].fHits, shards[i].fMisses, shards[i].fContended);
+        shards[i].fCache->dump();
+    }
+}
+
+int SkScaledImageCache::GetShardCount() {
+    return SK_SCALED_IMAGE_CACHE_SHARD_COUNT;
+}
+
+void SkScaledImageCache::GetShardStats(int shardIndex, ShardStats* stats) {
+    SkASSERT((unsigned)shardIndex < SK_SCALED_IMAGE_CACHE_SHARD_COUNT);
+    SkASSERT(stats);
+
+    Shard* shard = &get_shards()[shardIndex];
+    AutoShardLock asl(shard);
+    stats->fHits = shard->fHits;
+    stats->fMisses = shard->fMisses;
+    stats->fContended = shard->fContended;
+    stats->fCount = shard->fCache->getCount();
+    stats->fBytesUsed = shard->fCache->getBytesUsed();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
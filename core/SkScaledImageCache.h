@@ -22,6 +22,10 @@ class SkMipMap;
  *
  *  As a convenience, a global instance is also defined, which can be safely
  *  access across threads via the static methods (e.g. FindAndLock, etc.).
+ *  The global instance is sharded by pixel generation ID: each shard is an
+ *  independent cache with its own mutex and LRU list, so that threads drawing
+ *  different images rarely contend with each other. The byte limit given to
+ *  SetByteLimit is shared by all of the shards, and is enforced approximately.
  */
 class SkScaledImageCache {
 public:
@@ -45,6 +49,9 @@ public:
 
     static ID* FindAndLock(const SkBitmap& original, SkScalar scaleX,
                            SkScalar scaleY, SkBitmap* returnedBitmap);
+    static ID* FindAndLockSubset(uint32_t pixelGenerationID, SkScalar scale,
+                                 const SkIRect& subset,
+                                 SkBitmap* returnedBitmap);
     static ID* FindAndLockMip(const SkBitmap& original,
                               SkMipMap const** returnedMipMap);
 
@@ -56,6 +63,8 @@ public:
 
     static ID* AddAndLock(const SkBitmap& original, SkScalar scaleX,
                           SkScalar scaleY, const SkBitmap& bitmap);
+    static ID* AddAndLockSubset(uint32_t pixelGenerationID, SkScalar scale,
+                                const SkIRect& subset, const SkBitmap& bitmap);
     static ID* AddAndLockMip(const SkBitmap& original, const SkMipMap* mipMap);
 
     static void Unlock(ID*);
@@ -71,6 +80,22 @@ public:
      */
     static void Dump();
 
+    /**
+     *  Counters for one shard of the global cache. fContended counts the
+     *  number of times a thread found another thread already holding (or
+     *  waiting for) the shard's mutex when it tried to acquire it.
+     */
+    struct ShardStats {
+        int32_t fHits;
+        int32_t fMisses;
+        int32_t fContended;
+        int     fCount;
+        size_t  fBytesUsed;
+    };
+
+    static int GetShardCount();
+    static void GetShardStats(int shardIndex, ShardStats*);
+
     ///////////////////////////////////////////////////////////////////////////
 
     /**
@@ -92,6 +117,31 @@ public:
 
     ~SkScaledImageCache();
 
+    /**
+     *  Accounting shared by several caches that split one budget between
+     *  them (e.g. the shards of the global cache). fBytesUsed and fCount are
+     *  updated atomically by each cache as it adds and purges entries.
+     */
+    struct SharedBudget {
+        int32_t fBytesUsed;
+        int32_t fCount;
+        size_t  fByteLimit;
+    };
+
+    /**
+     *  Make this cache one member of a group sharing the specified budget. In
+     *  this mode, the cache's own byteLimit is treated as its fair share. While
+     *  the group as a whole is over the shared limit, a cache over its share
+     *  purges down to it, and a cache that adds an entry purges its own
+     *  unlocked entries until the group is back under the limit, even when
+     *  it is under its share. This lets a busy cache borrow the budget of
+     *  idle ones, without the group going over the limit.
+     *  In discardable mode, the entry count limit applies to the whole group.
+     *  The budget must outlive the cache. Pass NULL to go back to a private
+     *  budget.
+     */
+    void setSharedBudget(SharedBudget*);
+
     /**
      *  Search the cache for a matching bitmap (using generationID,
      *  width, and height as a search key). If found, return it in
@@ -122,19 +172,35 @@ public:
     ID* findAndLockMip(const SkBitmap& original,
                        SkMipMap const** returnedMipMap);
 
+    /**
+     *  Search the cache for a bitmap decoded from part of an image (using
+     *  generationID, scale, and the subset of the image, in unscaled
+     *  coordinates, as a search key). This is used by decoders that can
+     *  produce a scaled subset of an image directly, so that the whole
+     *  image never has to be decoded. The scale must be greater than 0.
+     *
+     *  If a match is not found, returnedBitmap will be unmodifed, and
+     *  NULL will be returned.
+     */
+    ID* findAndLockSubset(uint32_t pixelGenerationID, SkScalar scale,
+                          const SkIRect& subset, SkBitmap* returnedBitmap);
+
     /**
      *  To add a new bitmap (or mipMap) to the cache, call
      *  AddAndLock. Use the returned ptr to unlock the cache when you
      *  are done using scaled.
      *
      *  Use (generationID, width, and height) or (original, scaleX,
-     *  scaleY) or (original) as a search key
+     *  scaleY) or (original) or (generationID, scale, and subset) as a
+     *  search key
      */
     ID* addAndLock(uint32_t pixelGenerationID, int32_t width, int32_t height,
                    const SkBitmap& bitmap);
     ID* addAndLock(const SkBitmap& original, SkScalar scaleX,
                    SkScalar scaleY, const SkBitmap& bitmap);
     ID* addAndLockMip(const SkBitmap& original, const SkMipMap* mipMap);
+    ID* addAndLockSubset(uint32_t pixelGenerationID, SkScalar scale,
+                         const SkIRect& subset, const SkBitmap& bitmap);
 
     /**
      *  Given a non-null ID ptr returned by either findAndLock or addAndLock,
@@ -146,6 +212,7 @@ public:
 
     size_t getBytesUsed() const { return fBytesUsed; }
     size_t getByteLimit() const { return fByteLimit; }
+    int getCount() const { return fCount; }
 
     /**
      *  Set the maximum number of bytes available to this cache. If the current
@@ -179,13 +246,19 @@ private:
     size_t  fByteLimit;
     int     fCount;
 
+    SharedBudget* fSharedBudget;
+
     Rec* findAndLock(uint32_t generationID, SkScalar sx, SkScalar sy,
                      const SkIRect& bounds);
     Rec* findAndLock(const Key& key);
     ID* addAndLock(Rec* rec);
 
     void purgeRec(Rec*);
-    void purgeAsNeeded();
+    // justAdded is true when called because an entry was added, which (with
+    // a shared budget) makes this cache pay for the group going over it.
+    void purgeAsNeeded(bool justAdded = false);
+    bool isOverBudget(size_t bytesUsed, int countUsed,
+                      size_t byteLimit, int countLimit, bool justAdded) const;
 
     // linklist management
     void moveToHead(Rec*);
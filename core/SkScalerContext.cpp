@@ -795,6 +795,36 @@ void SkScalerContext::getImage(const SkGlyph& origGlyph) {
     }
 }
 
+void SkScalerContext::getImages(const SkGlyph* glyphs[], int count) {
+    // Only glyphs that getImage() would just pass to our own generateImage()
+    // can be batched.
+    if (fMaskFilter || fGenerateImageFromPath) {
+        for (int i = 0; i < count; ++i) {
+            this->getImage(*glyphs[i]);
+        }
+        return;
+    }
+
+    SkAutoSTMalloc<64, const SkGlyph*> batch(count);
+    int batchCount = 0;
+    for (int i = 0; i < count; ++i) {
+        if (this->getGlyphContext(*glyphs[i]) == this) {
+            batch[batchCount++] = glyphs[i];
+        } else {
+            this->getImage(*glyphs[i]);
+        }
+    }
+    if (batchCount > 0) {
+        this->generateImages(batch.get(), batchCount);
+    }
+}
+
+void SkScalerContext::generateImages(const SkGlyph* glyphs[], int count) {
+    for (int i = 0; i < count; ++i) {
+        this->generateImage(*glyphs[i]);
+    }
+}
+
 void SkScalerContext::getPath(const SkGlyph& glyph, SkPath* path) {
     this->internalGetPath(glyph, NULL, path, NULL);
 }
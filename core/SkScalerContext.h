@@ -181,6 +181,10 @@ public:
     void        getAdvance(SkGlyph*);
     void        getMetrics(SkGlyph*);
     void        getImage(const SkGlyph&);
+    /** Same as calling getImage() on each glyph, but lets the subclass
+        rasterize them together (see generateImages()).
+    */
+    void        getImages(const SkGlyph* glyphs[], int count);
     void        getPath(const SkGlyph&, SkPath*);
     void        getFontMetrics(SkPaint::FontMetrics*);
 
@@ -225,6 +229,12 @@ protected:
      */
     virtual void generateImage(const SkGlyph& glyph) = 0;
 
+    /** Same as calling generateImage() on each of the count glyphs, which
+     *  are all distinct. Subclasses that can rasterize several glyphs faster
+     *  together (e.g. on several threads) override this.
+     */
+    virtual void generateImages(const SkGlyph* glyphs[], int count);
+
     /** Sets the passed path to the glyph outline.
      *  If this cannot be done the path is set to empty;
      *  this is indistinguishable from a glyph with an empty path.
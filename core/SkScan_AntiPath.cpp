@@ -13,6 +13,7 @@
 #include "SkBlitter.h"
 #include "SkRegion.h"
 #include "SkAntiRun.h"
+#include "SkScanAA_opts.h"
 
 #define SHIFT   2
 #define SCALE   (1 << SHIFT)
@@ -100,7 +101,13 @@ BaseSuperBlitter::BaseSuperBlitter(SkBlitter* realBlitter, const SkIRect& ir,
     SkDEBUGCODE(fCurrX = -1;)
 }
 
-/// Run-length-encoded supersampling antialiased blitter.
+/** Run-length-encoded supersampling antialiased blitter.
+
+    If the platform provides wide coverage procs (see SkScanAA_opts.h), the
+    supersampled rows are instead accumulated into a dense coverage row, with
+    whole spans added at once, and the row is only run-length-encoded when it
+    is flushed. The blitted coverage is identical in both modes.
+ */
 class SuperBlitter : public BaseSuperBlitter {
 public:
     SuperBlitter(SkBlitter* realBlitter, const SkIRect& ir,
@@ -109,6 +116,7 @@ public:
     virtual ~SuperBlitter() {
         this->flush();
         sk_free(fRuns.fRuns);
+        sk_free(fCoverage);
     }
 
     /// Once fRuns contains a complete supersampled row, flush() blits
@@ -125,6 +133,18 @@ public:
 private:
     SkAlphaRuns fRuns;
     int         fOffsetX;
+
+    // Dense mode: NULL unless we have platform procs.
+    uint8_t*            fCoverage;
+    // range of fCoverage touched since the last flush
+    int                 fDirtyLeft;
+    int                 fDirtyRight;
+    SkCoverageAddProc   fCoverageAddProc;
+    SkCoverageRunProc   fCoverageRunProc;
+
+    void addDense(int ix, U8CPU startAlpha, int middleCount, U8CPU stopAlpha,
+                  U8CPU maxValue);
+    void flushDense();
 };
 
 SuperBlitter::SuperBlitter(SkBlitter* realBlitter, const SkIRect& ir,
@@ -138,11 +158,78 @@ SuperBlitter::SuperBlitter(SkBlitter* realBlitter, const SkIRect& ir,
     fRuns.reset(width);
 
     fOffsetX = 0;
+
+    fCoverage = NULL;
+    if (width > 0 && SkScanAAGetPlatformProcs(&fCoverageAddProc, &fCoverageRunProc)) {
+        fCoverage = (uint8_t*)sk_calloc_throw(width);
+        fDirtyLeft = width;
+        fDirtyRight = 0;
+    }
+}
+
+/** Same as SkAlphaRuns::add(), but into the dense row. */
+void SuperBlitter::addDense(int ix, U8CPU startAlpha, int middleCount,
+                            U8CPU stopAlpha, U8CPU maxValue) {
+    SkASSERT(ix >= 0 && ix + (startAlpha != 0) + middleCount + (stopAlpha != 0) <= fWidth);
+
+    uint8_t* alpha = fCoverage + ix;
+    if (startAlpha) {
+        // see SkAlphaRuns::add() for why we subtract (tmp >> 8)
+        unsigned tmp = alpha[0] + startAlpha;
+        SkASSERT(tmp <= 256);
+        alpha[0] = SkToU8(tmp - (tmp >> 8));
+        alpha += 1;
+    }
+    if (middleCount) {
+        fCoverageAddProc(alpha, maxValue, middleCount);
+        alpha += middleCount;
+    }
+    if (stopAlpha) {
+        alpha[0] = SkToU8(alpha[0] + stopAlpha);
+        alpha += 1;
+    }
+
+    fDirtyLeft = SkMin32(fDirtyLeft, ix);
+    fDirtyRight = SkMax32(fDirtyRight, SkToS32(alpha - fCoverage));
+}
+
+/** Run-length-encode the dirty part of the dense row into fRuns, blit it,
+    and clear it for the next row.
+ */
+void SuperBlitter::flushDense() {
+    if (fDirtyLeft >= fDirtyRight) {
+        return;
+    }
+
+    const int count = fDirtyRight - fDirtyLeft;
+    const uint8_t* coverage = fCoverage + fDirtyLeft;
+    int16_t* runs = fRuns.fRuns;
+    uint8_t* alpha = fRuns.fAlpha;
+
+    int i = 0;
+    while (i < count) {
+        int n = fCoverageRunProc(coverage + i, count - i);
+        SkASSERT(n > 0 && n <= count - i);
+        runs[i] = SkToS16(n);
+        alpha[i] = coverage[i];
+        i += n;
+    }
+    runs[count] = 0;
+
+    fRealBlitter->blitAntiH(fLeft + fDirtyLeft, fCurrIY, alpha, runs);
+
+    memset(fCoverage + fDirtyLeft, 0, count);
+    fDirtyLeft = fWidth;
+    fDirtyRight = 0;
 }
 
 void SuperBlitter::flush() {
     if (fCurrIY >= fTop) {
-        if (!fRuns.empty()) {
+        if (fCoverage) {
+            this->flushDense();
+            fRuns.reset(fWidth);
+            fOffsetX = 0;
+        } else if (!fRuns.empty()) {
         //  SkDEBUGCODE(fRuns.dump();)
             fRealBlitter->blitAntiH(fLeft, fCurrIY, fRuns.fAlpha, fRuns.fRuns);
             fRuns.reset(fWidth);
@@ -224,6 +311,16 @@ void SuperBlitter::blitH(int x, int y, int width) {
         }
     }
 
+    if (fCoverage) {
+        this->addDense(x >> SHIFT, coverage_to_partial_alpha(fb),
+                       n, coverage_to_partial_alpha(fe),
+                       (1 << (8 - SHIFT)) - (((y & MASK) + 1) >> SHIFT));
+#ifdef SK_DEBUG
+        fCurrX = x + width;
+#endif
+        return;
+    }
+
     fOffsetX = fRuns.add(x >> SHIFT, coverage_to_partial_alpha(fb),
                          n, coverage_to_partial_alpha(fe),
                          (1 << (8 - SHIFT)) - (((y & MASK) + 1) >> SHIFT),
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScratchAlloc.h"
+#include "SkTDArray.h"
+#include "SkTLS.h"
+
+// Size of the first block of a new arena.
+#define MIN_SCRATCH_BLOCK_SIZE      (16 * 1024)
+// Larger blocks are freed rather than kept for the next draw.
+#define MAX_RETAINED_BLOCK_SIZE     (512 * 1024)
+// Arenas kept per thread, enough for the usual nesting depth.
+#define MAX_RETAINED_ARENAS         4
+
+struct SkScratchAlloc::Arena {
+    struct Block {
+        Block*  fNext;
+        size_t  fSize;
+        // data follows (Block is padded to 8 bytes on 32 bit builds)
+        char* startOfData() {
+            return reinterpret_cast<char*>(this) + SkAlign8(sizeof(Block));
+        }
+    };
+
+    Block*  fBlock;     // the block being allocated from, followed by older ones
+    char*   fFreePtr;
+    size_t  fFreeSize;
+
+    Arena() : fBlock(NULL), fFreePtr(NULL), fFreeSize(0) {}
+
+    ~Arena() {
+        FreeChain(fBlock);
+    }
+
+    static void FreeChain(Block* block) {
+        while (block) {
+            Block* next = block->fNext;
+            sk_free(block);
+            block = next;
+        }
+    }
+
+    void* alloc(size_t bytes) {
+        bytes = SkAlign8(bytes);
+        if (bytes > fFreeSize) {
+            // Grow geometrically so a big path ends up in a few blocks, and
+            // the one kept by rewind() is big enough next time.
+            size_t size = fBlock ? fBlock->fSize + (fBlock->fSize >> 1)
+                                 : MIN_SCRATCH_BLOCK_SIZE;
+            if (size < bytes) {
+                size = bytes;
+            }
+            Block* block = (Block*)sk_malloc_flags(SkAlign8(sizeof(Block)) + size, 0);
+            if (NULL == block) {
+                return NULL;
+            }
+            block->fNext = fBlock;
+            block->fSize = size;
+            fBlock = block;
+            fFreePtr = block->startOfData();
+            fFreeSize = size;
+        }
+        void* ptr = fFreePtr;
+        fFreePtr += bytes;
+        fFreeSize -= bytes;
+        return ptr;
+    }
+
+    // Drop all allocations, keeping only the newest (largest) block, and
+    // only if it is not unusually large.
+    void rewind() {
+        if (NULL == fBlock) {
+            return;
+        }
+        FreeChain(fBlock->fNext);
+        fBlock->fNext = NULL;
+        if (fBlock->fSize > MAX_RETAINED_BLOCK_SIZE) {
+            sk_free(fBlock);
+            fBlock = NULL;
+            fFreePtr = NULL;
+            fFreeSize = 0;
+        } else {
+            fFreePtr = fBlock->startOfData();
+            fFreeSize = fBlock->fSize;
+        }
+    }
+};
+
+namespace {
+
+// The arenas not currently borrowed by an SkScratchAlloc on this thread.
+struct ArenaPool {
+    SkTDArray<SkScratchAlloc::Arena*> fFree;
+
+    ~ArenaPool() {
+        fFree.deleteAll();
+    }
+};
+
+}  // namespace
+
+static void* create_arena_pool() {
+    return SkNEW(ArenaPool);
+}
+
+static void delete_arena_pool(void* pool) {
+    SkDELETE(static_cast<ArenaPool*>(pool));
+}
+
+static ArenaPool* get_arena_pool() {
+    return static_cast<ArenaPool*>(SkTLS::Get(create_arena_pool, delete_arena_pool));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkScratchAlloc::SkScratchAlloc() {
+    ArenaPool* pool = get_arena_pool();
+    if (pool->fFree.count() > 0) {
+        pool->fFree.pop(&fArena);
+    } else {
+        fArena = SkNEW(Arena);
+    }
+}
+
+SkScratchAlloc::~SkScratchAlloc() {
+    ArenaPool* pool = get_arena_pool();
+    if (pool->fFree.count() < MAX_RETAINED_ARENAS) {
+        fArena->rewind();
+        *pool->fFree.append() = fArena;
+    } else {
+        SkDELETE(fArena);
+    }
+}
+
+void SkScratchAlloc::reset() {
+    fArena->rewind();
+}
+
+void* SkScratchAlloc::alloc(size_t bytes) {
+    return fArena->alloc(bytes);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkScratchAlloc_DEFINED
+#define SkScratchAlloc_DEFINED
+
+#include "SkTypes.h"
+
+/**
+ *  Bump allocator for the transient geometry a single draw builds (edges,
+ *  run buffers, ...), with the same alloc/allocThrow/reset interface as
+ *  SkChunkAlloc.
+ *
+ *  The blocks come from a small per-thread pool, and are handed back to it
+ *  (not freed) by reset() and the destructor, so steady-state drawing does
+ *  not touch the heap, and threads rasterizing concurrently do not contend
+ *  in malloc. Each SkScratchAlloc borrows its own arena, so they may nest.
+ *
+ *  Must be used and destroyed on the thread that created it.
+ */
+class SkScratchAlloc : SkNoncopyable {
+public:
+    SkScratchAlloc();
+    ~SkScratchAlloc();
+
+    /**
+     *  Release everything allocated so far. The memory stays with the arena.
+     */
+    void reset();
+
+    /**
+     *  Returns bytes of storage aligned for any pointer or scalar type, or
+     *  NULL if it could not be allocated. Valid until reset() or the
+     *  destructor.
+     */
+    void* alloc(size_t bytes);
+
+    /**
+     *  Like alloc(), but calls sk_throw() instead of returning NULL.
+     */
+    void* allocThrow(size_t bytes) {
+        void* ptr = this->alloc(bytes);
+        if (NULL == ptr) {
+            sk_throw();
+        }
+        return ptr;
+    }
+
+    struct Arena;
+
+private:
+    Arena*  fArena;
+};
+
+#endif
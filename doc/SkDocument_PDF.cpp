@@ -6,8 +6,8 @@
  */
 
 #include "SkDocument.h"
-#include "SkPDFDocument.h"
 #include "SkPDFDeviceFlattener.h"
+#include "SkPDFStreamingDocument.h"
 
 class SkDocument_PDF : public SkDocument {
 public:
@@ -17,7 +17,7 @@ public:
             : SkDocument(stream, doneProc)
             , fEncoder(encoder)
             , fRasterDpi(rasterDpi) {
-        fDoc = SkNEW(SkPDFDocument);
+        fDoc = SkNEW_ARGS(SkPDFStreamingDocument, (stream));
         fCanvas = NULL;
         fDevice = NULL;
     }
@@ -65,7 +65,7 @@ protected:
         SkASSERT(NULL == fCanvas);
         SkASSERT(NULL == fDevice);
 
-        bool success = fDoc->emitPDF(stream);
+        bool success = fDoc->close();
         SkDELETE(fDoc);
         fDoc = NULL;
         return success;
@@ -77,7 +77,7 @@ protected:
     }
 
 private:
-    SkPDFDocument*  fDoc;
+    SkPDFStreamingDocument* fDoc;
     SkPDFDeviceFlattener* fDevice;
     SkCanvas*       fCanvas;
     SkPicture::EncodeBitmap fEncoder;
@@ -12,6 +12,7 @@
 #include "SkWriteBuffer.h"
 #include "SkGpuBlurUtils.h"
 #include "SkBlurImage_opts.h"
+#include "SkParallel.h"
 #if SK_SUPPORT_GPU
 #include "GrContext.h"
 #endif
@@ -71,14 +72,14 @@ enum BlurDirection {
  */
 
 template<BlurDirection srcDirection, BlurDirection dstDirection>
-static void boxBlur(const SkPMColor* src, int srcStride, SkPMColor* dst, int kernelSize,
-                    int leftOffset, int rightOffset, int width, int height)
+static void boxBlur(const SkPMColor* src, int srcStride, SkPMColor* dst, int dstStride,
+                    int kernelSize, int leftOffset, int rightOffset, int width, int height)
 {
     int rightBorder = SkMin32(rightOffset + 1, width);
     int srcStrideX = srcDirection == kX ? 1 : srcStride;
-    int dstStrideX = dstDirection == kX ? 1 : height;
+    int dstStrideX = dstDirection == kX ? 1 : dstStride;
     int srcStrideY = srcDirection == kX ? srcStride : 1;
-    int dstStrideY = dstDirection == kX ? width : 1;
+    int dstStrideY = dstDirection == kX ? dstStride : 1;
     uint32_t scale = (1 << 24) / kernelSize;
     uint32_t half = 1 << 23;
     for (int y = 0; y < height; ++y) {
@@ -124,6 +125,56 @@ static void boxBlur(const SkPMColor* src, int srcStride, SkPMColor* dst, int ker
     }
 }
 
+// Below this many pixels per band, handing a band to another thread costs
+// more than blurring it.
+static const int kMinPixelsPerBand = 64 * 1024;
+
+namespace {
+
+struct BlurPass {
+    SkBoxBlurProc       fProc;
+    const SkPMColor*    fSrc;
+    int                 fSrcStride;
+    int                 fSrcStrideY;
+    SkPMColor*          fDst;
+    int                 fDstStride;
+    int                 fDstStrideY;
+    int                 fKernelSize;
+    int                 fLeftOffset;
+    int                 fRightOffset;
+    int                 fWidth;
+};
+
+}  // namespace
+
+static void blur_band(void* context, int start, int stop) {
+    const BlurPass* pass = static_cast<const BlurPass*>(context);
+    pass->fProc(pass->fSrc + start * pass->fSrcStrideY, pass->fSrcStride,
+                pass->fDst + start * pass->fDstStrideY, pass->fDstStride,
+                pass->fKernelSize, pass->fLeftOffset, pass->fRightOffset,
+                pass->fWidth, stop - start);
+}
+
+/**
+ *  Runs one box blur pass, splitting its rows into bands that are blurred in
+ *  parallel when an SkParallel executor is installed. Each row only reads
+ *  its own source row and writes its own destination row (or column), so the
+ *  bands are independent.
+ */
+template<BlurDirection srcDirection, BlurDirection dstDirection>
+static void boxBlurBands(SkBoxBlurProc proc, const SkPMColor* src, int srcStride,
+                         SkPMColor* dst, int kernelSize, int leftOffset, int rightOffset,
+                         int width, int height) {
+    int dstStride = dstDirection == kX ? width : height;
+    BlurPass pass = {
+        proc,
+        src, srcStride, srcDirection == kX ? srcStride : 1,
+        dst, dstStride, dstDirection == kX ? dstStride : 1,
+        kernelSize, leftOffset, rightOffset, width
+    };
+    SkParallel::ForRanges(height, kMinPixelsPerBand / SkMax32(width, 1), blur_band, &pass);
+}
+
 static void getBox3Params(SkScalar s, int *kernelSize, int* kernelSize3, int *lowOffset,
                           int *highOffset)
 {
@@ -213,20 +264,20 @@ bool SkBlurImageFilter::onFilterImage(Proxy* proxy,
     }
 
     if (kernelSizeX > 0 && kernelSizeY > 0) {
-        boxBlurX(s,  sw, t, kernelSizeX,  lowOffsetX,  highOffsetX, w, h);
-        boxBlurX(t,  w,  d, kernelSizeX,  highOffsetX, lowOffsetX,  w, h);
-        boxBlurXY(d, w,  t, kernelSizeX3, highOffsetX, highOffsetX, w, h);
-        boxBlurX(t,  h,  d, kernelSizeY,  lowOffsetY,  highOffsetY, h, w);
-        boxBlurX(d,  h,  t, kernelSizeY,  highOffsetY, lowOffsetY,  h, w);
-        boxBlurXY(t, h,  d, kernelSizeY3, highOffsetY, highOffsetY, h, w);
+        boxBlurBands<kX, kX>(boxBlurX,  s, sw, t, kernelSizeX,  lowOffsetX,  highOffsetX, w, h);
+        boxBlurBands<kX, kX>(boxBlurX,  t, w,  d, kernelSizeX,  highOffsetX, lowOffsetX,  w, h);
+        boxBlurBands<kX, kY>(boxBlurXY, d, w,  t, kernelSizeX3, highOffsetX, highOffsetX, w, h);
+        boxBlurBands<kX, kX>(boxBlurX,  t, h,  d, kernelSizeY,  lowOffsetY,  highOffsetY, h, w);
+        boxBlurBands<kX, kX>(boxBlurX,  d, h,  t, kernelSizeY,  highOffsetY, lowOffsetY,  h, w);
+        boxBlurBands<kX, kY>(boxBlurXY, t, h,  d, kernelSizeY3, highOffsetY, highOffsetY, h, w);
     } else if (kernelSizeX > 0) {
-        boxBlurX(s,  sw, d, kernelSizeX,  lowOffsetX,  highOffsetX, w, h);
-        boxBlurX(d,  w,  t, kernelSizeX,  highOffsetX, lowOffsetX,  w, h);
-        boxBlurX(t,  w,  d, kernelSizeX3, highOffsetX, highOffsetX, w, h);
+        boxBlurBands<kX, kX>(boxBlurX,  s, sw, d, kernelSizeX,  lowOffsetX,  highOffsetX, w, h);
+        boxBlurBands<kX, kX>(boxBlurX,  d, w,  t, kernelSizeX,  highOffsetX, lowOffsetX,  w, h);
+        boxBlurBands<kX, kX>(boxBlurX,  t, w,  d, kernelSizeX3, highOffsetX, highOffsetX, w, h);
     } else if (kernelSizeY > 0) {
-        boxBlurYX(s, sw, d, kernelSizeY,  lowOffsetY,  highOffsetY, h, w);
-        boxBlurX(d,  h,  t, kernelSizeY,  highOffsetY, lowOffsetY,  h, w);
-        boxBlurXY(t, h,  d, kernelSizeY3, highOffsetY, highOffsetY, h, w);
+        boxBlurBands<kY, kX>(boxBlurYX, s, sw, d, kernelSizeY,  lowOffsetY,  highOffsetY, h, w);
+        boxBlurBands<kX, kX>(boxBlurX,  d, h,  t, kernelSizeY,  highOffsetY, lowOffsetY,  h, w);
+        boxBlurBands<kX, kY>(boxBlurXY, t, h,  d, kernelSizeY3, highOffsetY, highOffsetY, h, w);
     }
     return true;
 }
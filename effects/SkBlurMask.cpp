@@ -9,6 +9,7 @@
 
 #include "SkBlurMask.h"
 #include "SkMath.h"
+#include "SkParallel.h"
 #include "SkTemplates.h"
 #include "SkEndian.h"
 
@@ -33,7 +34,8 @@ SkScalar SkBlurMask::ConvertRadiusToSigma(SkScalar radius) {
  * "transpose" parameter is true, it will transpose the pixels on write,
  * such that X and Y are swapped. Reads are always performed from contiguous
  * memory in X, for speed. The destination buffer (dst) must be at least
- * (width + leftRadius + rightRadius) * height bytes in size.
+ * (width + leftRadius + rightRadius) * height bytes in size. Only rows
+ * [startY, stopY) are blurred; each row is independent of the others.
  *
  * This is what the inner loop looks like before unrolling, and with the two
  * cases broken out separately (width < diameter, width >= diameter):
@@ -72,9 +74,9 @@ SkScalar SkBlurMask::ConvertRadiusToSigma(SkScalar radius) {
  *          }
  *      }
  */
-static int boxBlur(const uint8_t* src, int src_y_stride, uint8_t* dst,
-                   int leftRadius, int rightRadius, int width, int height,
-                   bool transpose)
+static int boxBlurRows(const uint8_t* src, int src_y_stride, uint8_t* dst,
+                       int leftRadius, int rightRadius, int width, int height,
+                       bool transpose, int startY, int stopY)
 {
     int diameter = leftRadius + rightRadius;
     int kernelSize = diameter + 1;
@@ -84,7 +86,7 @@ static int boxBlur(const uint8_t* src, int src_y_stride, uint8_t* dst,
     int dst_x_stride = transpose ? height : 1;
     int dst_y_stride = transpose ? 1 : new_width;
     uint32_t half = 1 << 23;
-    for (int y = 0; y < height; ++y) {
+    for (int y = startY; y < stopY; ++y) {
         uint32_t sum = 0;
         uint8_t* dptr = dst + y * dst_y_stride;
         const uint8_t* right = src + y * src_y_stride;
@@ -274,9 +276,10 @@ static int boxBlur(const uint8_t* src, int src_y_stride, uint8_t* dst,
  *  return new_width;
  */
 
-static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst,
-                         int radius, int width, int height,
-                         bool transpose, uint8_t outer_weight)
+static int boxBlurInterpRows(const uint8_t* src, int src_y_stride, uint8_t* dst,
+                             int radius, int width, int height,
+                             bool transpose, uint8_t outer_weight,
+                             int startY, int stopY)
 {
     int diameter = radius * 2;
     int kernelSize = diameter + 1;
@@ -290,7 +293,7 @@ static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst,
     int new_width = width + diameter;
     int dst_x_stride = transpose ? height : 1;
     int dst_y_stride = transpose ? 1 : new_width;
-    for (int y = 0; y < height; ++y) {
+    for (int y = startY; y < stopY; ++y) {
         uint32_t outer_sum = 0, inner_sum = 0;
         uint8_t* dptr = dst + y * dst_y_stride;
         const uint8_t* right = src + y * src_y_stride;
@@ -402,6 +405,66 @@ static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst,
     return new_width;
 }
 
+// Below this many mask bytes per band, handing a band to another thread costs
+// more than blurring it.
+static const int kMinPixelsPerBand = 128 * 1024;
+
+namespace {
+
+struct BoxBlurPass {
+    const uint8_t*  fSrc;
+    int             fSrcYStride;
+    uint8_t*        fDst;
+    int             fLeftRadius;
+    int             fRightRadius;
+    int             fWidth;
+    int             fHeight;
+    bool            fTranspose;
+    uint8_t         fOuterWeight;   // only used by boxBlurInterp
+};
+
+}  // namespace
+
+static void box_blur_band(void* context, int startY, int stopY) {
+    const BoxBlurPass* pass = static_cast<const BoxBlurPass*>(context);
+    boxBlurRows(pass->fSrc, pass->fSrcYStride, pass->fDst,
+                pass->fLeftRadius, pass->fRightRadius, pass->fWidth, pass->fHeight,
+                pass->fTranspose, startY, stopY);
+}
+
+static void box_blur_interp_band(void* context, int startY, int stopY) {
+    const BoxBlurPass* pass = static_cast<const BoxBlurPass*>(context);
+    boxBlurInterpRows(pass->fSrc, pass->fSrcYStride, pass->fDst,
+                      pass->fLeftRadius, pass->fWidth, pass->fHeight,
+                      pass->fTranspose, pass->fOuterWeight, startY, stopY);
+}
+
+/**
+ * These run a whole pass, splitting its rows into bands that are blurred in
+ * parallel when an SkParallel executor is installed. They return the width
+ * of the blurred rows, like the per-row functions above.
+ */
+static int boxBlur(const uint8_t* src, int src_y_stride, uint8_t* dst,
+                   int leftRadius, int rightRadius, int width, int height,
+                   bool transpose)
+{
+    BoxBlurPass pass = { src, src_y_stride, dst, leftRadius, rightRadius,
+                         width, height, transpose, 0 };
+    SkParallel::ForRanges(height, kMinPixelsPerBand / SkMax32(width, 1), box_blur_band, &pass);
+    return width + SkMax32(leftRadius, rightRadius) * 2;
+}
+
+static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst,
+                         int radius, int width, int height,
+                         bool transpose, uint8_t outer_weight)
+{
+    BoxBlurPass pass = { src, src_y_stride, dst, radius, radius,
+                         width, height, transpose, outer_weight };
+    SkParallel::ForRanges(height, kMinPixelsPerBand / SkMax32(width, 1),
+                          box_blur_interp_band, &pass);
+    return width + radius * 2;
+}
+
 static void get_adjusted_radii(SkScalar passRadius, int *loRadius, int *hiRadius)
 {
     *loRadius = *hiRadius = SkScalarCeilToInt(passRadius);
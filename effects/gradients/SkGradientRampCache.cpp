@@ -0,0 +1,144 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGradientRampCache.h"
+#include "SkChecksum.h"
+#include "SkTDynamicHash.h"
+#include "SkTInternalLList.h"
+#include "SkThread.h"
+
+namespace {
+
+struct RampKey {
+    const int32_t*  fWords;
+    int             fCount;
+    uint32_t        fHash;
+
+    RampKey(const int32_t words[], int count)
+        : fWords(words)
+        , fCount(count)
+        , fHash(SkChecksum::Compute(reinterpret_cast<const uint32_t*>(words),
+                                    count * sizeof(int32_t))) {}
+
+    bool operator==(const RampKey& other) const {
+        return fHash == other.fHash && fCount == other.fCount &&
+               !memcmp(fWords, other.fWords, fCount * sizeof(int32_t));
+    }
+};
+
+struct Rec {
+    SK_DECLARE_INTERNAL_LLIST_INTERFACE(Rec);
+
+    Rec(const RampKey& key, SkRefCnt* value, size_t bytes)
+        : fKey(key)
+        , fValue(SkRef(value))
+        , fBytes(bytes) {
+        // key points at the caller's words, so keep a copy
+        int32_t* words = (int32_t*)sk_malloc_throw(key.fCount * sizeof(int32_t));
+        memcpy(words, key.fWords, key.fCount * sizeof(int32_t));
+        fKey.fWords = words;
+    }
+
+    ~Rec() {
+        sk_free(const_cast<int32_t*>(fKey.fWords));
+        fValue->unref();
+    }
+
+    static const RampKey& GetKey(const Rec& rec) { return rec.fKey; }
+    static uint32_t Hash(const RampKey& key) { return key.fHash; }
+    static bool Equal(const Rec& rec, const RampKey& key) { return rec.fKey == key; }
+
+    RampKey     fKey;
+    SkRefCnt*   fValue;
+    size_t      fBytes;
+};
+
+typedef SkTDynamicHash<Rec, RampKey, Rec::GetKey, Rec::Hash, Rec::Equal> RecHash;
+
+// Most recently used at the head.
+struct RampCache {
+    RecHash                 fHash;
+    SkTInternalLList<Rec>   fLRU;
+    size_t                  fBytesUsed;
+    size_t                  fByteLimit;
+
+    RampCache() : fBytesUsed(0), fByteLimit(SK_DEFAULT_GRADIENT_RAMP_CACHE_LIMIT) {}
+
+    void purgeAsNeeded() {
+        while (fBytesUsed > fByteLimit) {
+            Rec* rec = fLRU.tail();
+            if (NULL == rec) {
+                break;
+            }
+            fLRU.remove(rec);
+            fHash.remove(rec->fKey);
+            fBytesUsed -= rec->fBytes;
+            SkDELETE(rec);
+        }
+    }
+};
+
+}  // namespace
+
+SK_DECLARE_STATIC_MUTEX(gMutex);
+static RampCache* gCache;
+
+// Must be called with gMutex held.
+static RampCache* get_cache() {
+    if (NULL == gCache) {
+        gCache = SkNEW(RampCache);
+    }
+    return gCache;
+}
+
+SkRefCnt* SkGradientRampCache::Find(const int32_t key[], int count) {
+    RampKey rampKey(key, count);
+    SkAutoMutexAcquire ama(gMutex);
+    RampCache* cache = get_cache();
+
+    Rec* rec = cache->fHash.find(rampKey);
+    if (NULL == rec) {
+        return NULL;
+    }
+    cache->fLRU.remove(rec);
+    cache->fLRU.addToHead(rec);
+    return SkRef(rec->fValue);
+}
+
+void SkGradientRampCache::Add(const int32_t key[], int count, SkRefCnt* value, size_t bytes) {
+    RampKey rampKey(key, count);
+    SkAutoMutexAcquire ama(gMutex);
+    RampCache* cache = get_cache();
+
+    if (NULL != cache->fHash.find(rampKey)) {
+        return;
+    }
+    Rec* rec = SkNEW_ARGS(Rec, (rampKey, value, bytes));
+    cache->fHash.add(rec);
+    cache->fLRU.addToHead(rec);
+    cache->fBytesUsed += bytes;
+    cache->purgeAsNeeded();
+}
+
+size_t SkGradientRampCache::GetByteLimit() {
+    SkAutoMutexAcquire ama(gMutex);
+    return get_cache()->fByteLimit;
+}
+
+size_t SkGradientRampCache::SetByteLimit(size_t newLimit) {
+    SkAutoMutexAcquire ama(gMutex);
+    RampCache* cache = get_cache();
+    size_t prevLimit = cache->fByteLimit;
+    cache->fByteLimit = newLimit;
+    cache->purgeAsNeeded();
+    return prevLimit;
+}
+
+size_t SkGradientRampCache::GetBytesUsed() {
+    SkAutoMutexAcquire ama(gMutex);
+    return get_cache()->fBytesUsed;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradientRampCache_DEFINED
+#define SkGradientRampCache_DEFINED
+
+#include "SkRefCnt.h"
+
+#ifndef SK_DEFAULT_GRADIENT_RAMP_CACHE_LIMIT
+    #define SK_DEFAULT_GRADIENT_RAMP_CACHE_LIMIT    (512 * 1024)
+#endif
+
+/**
+ *  Process-wide cache of the color ramps built by SkGradientShaderBase, so
+ *  that gradients with the same colors, positions, flags (and alpha, for the
+ *  32bit ramp) share one table instead of each building their own.
+ *
+ *  Keys are arrays of 32bit words, which the caller makes unique across the
+ *  kinds of ramp it stores. Values are immutable ref-counted objects (an
+ *  SkPixelRef or SkData). The cache holds a ref to each, and purges the least
+ *  recently used ones once their total size goes over the limit. Safe to use
+ *  from any thread.
+ */
+class SkGradientRampCache {
+public:
+    /**
+     *  Returns the value stored for the key, with a ref that the caller must
+     *  release, or NULL.
+     */
+    static SkRefCnt* Find(const int32_t key[], int count);
+
+    /**
+     *  Stores value (taking a ref) for the key, charging bytes against the
+     *  limit. If a value was added for the same key in the meantime, it is
+     *  kept and this one is not stored.
+     */
+    static void Add(const int32_t key[], int count, SkRefCnt* value, size_t bytes);
+
+    static size_t GetByteLimit();
+    static size_t SetByteLimit(size_t newLimit);
+    static size_t GetBytesUsed();
+};
+
+#endif
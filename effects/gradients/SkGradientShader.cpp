@@ -6,6 +6,8 @@
  */
 
 #include "SkGradientShaderPriv.h"
+#include "SkData.h"
+#include "SkGradientRampCache.h"
 #include "SkLinearGradient.h"
 #include "SkRadialGradient.h"
 #include "SkTwoPointRadialGradient.h"
@@ -26,7 +28,8 @@ SkGradientShaderBase::SkGradientShaderBase(const Descriptor& desc) {
     fTileMode = desc.fTileMode;
     fTileProc = gTileProcs[desc.fTileMode];
 
-    fCache16 = fCache16Storage = NULL;
+    fCache16 = NULL;
+    fCache16Data = NULL;
     fCache32 = NULL;
     fCache32PixelRef = NULL;
 
@@ -148,7 +151,8 @@ SkGradientShaderBase::SkGradientShaderBase(SkReadBuffer& buffer) : INHERITED(buf
 
     fMapper = buffer.readUnitMapper();
 
-    fCache16 = fCache16Storage = NULL;
+    fCache16 = NULL;
+    fCache16Data = NULL;
     fCache32 = NULL;
     fCache32PixelRef = NULL;
 
@@ -186,9 +190,7 @@ SkGradientShaderBase::SkGradientShaderBase(SkReadBuffer& buffer) : INHERITED(buf
 }
 
 SkGradientShaderBase::~SkGradientShaderBase() {
-    if (fCache16Storage) {
-        sk_free(fCache16Storage);
-    }
+    SkSafeUnref(fCache16Data);
     SkSafeUnref(fCache32PixelRef);
     if (fOrigColors != fStorage) {
         sk_free(fOrigColors);
@@ -258,14 +260,12 @@ void SkGradientShaderBase::setCacheAlpha(U8CPU alpha) const {
     // if the new alpha differs from the previous time we were called, inval our cache
     // this will trigger the cache to be rebuilt.
     // we don't care about the first time, since the cache ptrs will already be NULL
+    // The 16bit cache ignores alpha, so it stays valid.
     if (fCacheAlpha != alpha) {
-        fCache16 = NULL;            // inval the cache
         fCache32 = NULL;            // inval the cache
         fCacheAlpha = alpha;        // record the new alpha
-        // inform our subclasses
-        if (fCache32PixelRef) {
-            fCache32PixelRef->notifyPixelsChanged();
-        }
+        // The pixelref may be shared, so it is replaced rather than rebuilt in place.
+        SkSafeSetNull(fCache32PixelRef);
     }
 }
 
@@ -468,45 +468,92 @@ static inline U16CPU bitsTo16(unsigned x, const unsigned bits) {
     return 0;
 }
 
+// Key for SkGradientRampCache: [kind + alpha, numColors, colors[], {positions[]}, flags]
+int SkGradientShaderBase::rampKeyCount() const {
+    int count = 1 + 1 + fColorCount + 1;
+    if (fColorCount > 2) {
+        count += fColorCount - 1;    // fRecs[].fPos
+    }
+    return count;
+}
+
+void SkGradientShaderBase::writeRampKey(int32_t key[]) const {
+    // key[0] is left to the caller
+    int32_t* buffer = key + 1;
+    *buffer++ = fColorCount;
+    memcpy(buffer, fOrigColors, fColorCount * sizeof(SkColor));
+    buffer += fColorCount;
+    if (fColorCount > 2) {
+        for (int i = 1; i < fColorCount; i++) {
+            *buffer++ = fRecs[i].fPos;
+        }
+    }
+    *buffer++ = fGradFlags;
+    SkASSERT(buffer - key == this->rampKeyCount());
+}
+
+// Distinguishes the 16 and 32 bit ramps in the shared cache. The 32 bit key also holds the alpha
+// in its low bits.
+static const int32_t kCache16Kind = 1 << 16;
+static const int32_t kCache32Kind = 2 << 16;
+
 const uint16_t* SkGradientShaderBase::getCache16() const {
     if (fCache16 == NULL) {
         // double the count for dither entries
         const int entryCount = kCache16Count * 2;
         const size_t allocSize = sizeof(uint16_t) * entryCount;
 
-        if (fCache16Storage == NULL) { // set the storage and our working ptr
-            fCache16Storage = (uint16_t*)sk_malloc_throw(allocSize);
+        // don't have a way to put the mapper into the key
+        SkAutoSTMalloc<16, int32_t> key;
+        SkData* data = NULL;
+        if (NULL == fMapper) {
+            key.reset(this->rampKeyCount());
+            key[0] = kCache16Kind;
+            this->writeRampKey(key.get());
+            data = static_cast<SkData*>(SkGradientRampCache::Find(key.get(),
+                                                                  this->rampKeyCount()));
         }
-        fCache16 = fCache16Storage;
-        if (fColorCount == 2) {
-            Build16bitCache(fCache16, fOrigColors[0], fOrigColors[1],
-                            kCache16Count);
-        } else {
-            Rec* rec = fRecs;
-            int prevIndex = 0;
-            for (int i = 1; i < fColorCount; i++) {
-                int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache16Shift;
-                SkASSERT(nextIndex < kCache16Count);
-
-                if (nextIndex > prevIndex)
-                    Build16bitCache(fCache16 + prevIndex, fOrigColors[i-1], fOrigColors[i], nextIndex - prevIndex + 1);
-                prevIndex = nextIndex;
+
+        if (NULL == data) {
+            uint16_t* cache = (uint16_t*)sk_malloc_throw(allocSize);
+            if (fColorCount == 2) {
+                Build16bitCache(cache, fOrigColors[0], fOrigColors[1],
+                                kCache16Count);
+            } else {
+                Rec* rec = fRecs;
+                int prevIndex = 0;
+                for (int i = 1; i < fColorCount; i++) {
+                    int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache16Shift;
+                    SkASSERT(nextIndex < kCache16Count);
+
+                    if (nextIndex > prevIndex)
+                        Build16bitCache(cache + prevIndex, fOrigColors[i-1], fOrigColors[i], nextIndex - prevIndex + 1);
+                    prevIndex = nextIndex;
+                }
             }
-        }
 
-        if (fMapper) {
-            fCache16Storage = (uint16_t*)sk_malloc_throw(allocSize);
-            uint16_t* linear = fCache16;         // just computed linear data
-            uint16_t* mapped = fCache16Storage;  // storage for mapped data
-            SkUnitMapper* map = fMapper;
-            for (int i = 0; i < kCache16Count; i++) {
-                int index = map->mapUnit16(bitsTo16(i, kCache16Bits)) >> kCache16Shift;
-                mapped[i] = linear[index];
-                mapped[i + kCache16Count] = linear[index + kCache16Count];
+            if (fMapper) {
+                uint16_t* linear = cache;        // just computed linear data
+                uint16_t* mapped = (uint16_t*)sk_malloc_throw(allocSize);  // storage for mapped data
+                SkUnitMapper* map = fMapper;
+                for (int i = 0; i < kCache16Count; i++) {
+                    int index = map->mapUnit16(bitsTo16(i, kCache16Bits)) >> kCache16Shift;
+                    mapped[i] = linear[index];
+                    mapped[i + kCache16Count] = linear[index + kCache16Count];
+                }
+                sk_free(linear);
+                cache = mapped;
+            }
+
+            data = SkData::NewFromMalloc(cache, allocSize);
+            if (NULL == fMapper) {
+                SkGradientRampCache::Add(key.get(), this->rampKeyCount(), data, allocSize);
             }
-            sk_free(fCache16);
-            fCache16 = fCache16Storage;
         }
+
+        SkSafeUnref(fCache16Data);
+        fCache16Data = data;
+        fCache16 = static_cast<const uint16_t*>(data->data());
     }
     return fCache16;
 }
@@ -519,44 +566,64 @@ const SkPMColor* SkGradientShaderBase::getCache32() const {
         info.fAlphaType = kPremul_SkAlphaType;
         info.fColorType = kPMColor_SkColorType;
 
-        if (NULL == fCache32PixelRef) {
-            fCache32PixelRef = SkMallocPixelRef::NewAllocate(info, 0, NULL);
+        // don't have a way to put the mapper into the key
+        SkAutoSTMalloc<16, int32_t> key;
+        SkMallocPixelRef* pixelRef = NULL;
+        if (NULL == fMapper) {
+            key.reset(this->rampKeyCount());
+            key[0] = kCache32Kind | fCacheAlpha;
+            this->writeRampKey(key.get());
+            pixelRef = static_cast<SkMallocPixelRef*>(
+                    SkGradientRampCache::Find(key.get(), this->rampKeyCount()));
         }
-        fCache32 = (SkPMColor*)fCache32PixelRef->getAddr();
-        if (fColorCount == 2) {
-            Build32bitCache(fCache32, fOrigColors[0], fOrigColors[1],
-                            kCache32Count, fCacheAlpha, fGradFlags);
-        } else {
-            Rec* rec = fRecs;
-            int prevIndex = 0;
-            for (int i = 1; i < fColorCount; i++) {
-                int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache32Shift;
-                SkASSERT(nextIndex < kCache32Count);
-
-                if (nextIndex > prevIndex)
-                    Build32bitCache(fCache32 + prevIndex, fOrigColors[i-1],
-                                    fOrigColors[i], nextIndex - prevIndex + 1,
-                                    fCacheAlpha, fGradFlags);
-                prevIndex = nextIndex;
+
+        if (NULL == pixelRef) {
+            pixelRef = SkMallocPixelRef::NewAllocate(info, 0, NULL);
+            SkPMColor* cache = (SkPMColor*)pixelRef->getAddr();
+            if (fColorCount == 2) {
+                Build32bitCache(cache, fOrigColors[0], fOrigColors[1],
+                                kCache32Count, fCacheAlpha, fGradFlags);
+            } else {
+                Rec* rec = fRecs;
+                int prevIndex = 0;
+                for (int i = 1; i < fColorCount; i++) {
+                    int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache32Shift;
+                    SkASSERT(nextIndex < kCache32Count);
+
+                    if (nextIndex > prevIndex)
+                        Build32bitCache(cache + prevIndex, fOrigColors[i-1],
+                                        fOrigColors[i], nextIndex - prevIndex + 1,
+                                        fCacheAlpha, fGradFlags);
+                    prevIndex = nextIndex;
+                }
             }
-        }
 
-        if (fMapper) {
-            SkMallocPixelRef* newPR = SkMallocPixelRef::NewAllocate(info, 0, NULL);
-            SkPMColor* linear = fCache32;           // just computed linear data
-            SkPMColor* mapped = (SkPMColor*)newPR->getAddr();    // storage for mapped data
-            SkUnitMapper* map = fMapper;
-            for (int i = 0; i < kCache32Count; i++) {
-                int index = map->mapUnit16((i << 8) | i) >> 8;
-                mapped[i + kCache32Count*0] = linear[index + kCache32Count*0];
-                mapped[i + kCache32Count*1] = linear[index + kCache32Count*1];
-                mapped[i + kCache32Count*2] = linear[index + kCache32Count*2];
-                mapped[i + kCache32Count*3] = linear[index + kCache32Count*3];
+            if (fMapper) {
+                SkMallocPixelRef* newPR = SkMallocPixelRef::NewAllocate(info, 0, NULL);
+                SkPMColor* linear = cache;              // just computed linear data
+                SkPMColor* mapped = (SkPMColor*)newPR->getAddr();    // storage for mapped data
+                SkUnitMapper* map = fMapper;
+                for (int i = 0; i < kCache32Count; i++) {
+                    int index = map->mapUnit16((i << 8) | i) >> 8;
+                    mapped[i + kCache32Count*0] = linear[index + kCache32Count*0];
+                    mapped[i + kCache32Count*1] = linear[index + kCache32Count*1];
+                    mapped[i + kCache32Count*2] = linear[index + kCache32Count*2];
+                    mapped[i + kCache32Count*3] = linear[index + kCache32Count*3];
+                }
+                pixelRef->unref();
+                pixelRef = newPR;
+            }
+
+            pixelRef->setImmutable();
+            if (NULL == fMapper) {
+                SkGradientRampCache::Add(key.get(), this->rampKeyCount(), pixelRef,
+                                         kCache32Count * 4 * sizeof(SkPMColor));
             }
-            fCache32PixelRef->unref();
-            fCache32PixelRef = newPR;
-            fCache32 = (SkPMColor*)newPR->getAddr();
         }
+
+        SkSafeUnref(fCache32PixelRef);
+        fCache32PixelRef = pixelRef;
+        fCache32 = (const SkPMColor*)pixelRef->getAddr();
     }
     return fCache32;
 }
@@ -583,25 +650,11 @@ void SkGradientShaderBase::getGradientTableBitmap(SkBitmap* bitmap) const {
         return;
     }
 
-    // build our key: [numColors + colors[] + {positions[]} + flags ]
-    int count = 1 + fColorCount + 1;
-    if (fColorCount > 2) {
-        count += fColorCount - 1;    // fRecs[].fPos
-    }
-
+    // build our key: [0 + numColors + colors[] + {positions[]} + flags ]
+    int count = this->rampKeyCount();
     SkAutoSTMalloc<16, int32_t> storage(count);
-    int32_t* buffer = storage.get();
-
-    *buffer++ = fColorCount;
-    memcpy(buffer, fOrigColors, fColorCount * sizeof(SkColor));
-    buffer += fColorCount;
-    if (fColorCount > 2) {
-        for (int i = 1; i < fColorCount; i++) {
-            *buffer++ = fRecs[i].fPos;
-        }
-    }
-    *buffer++ = fGradFlags;
-    SkASSERT(buffer - storage.get() == count);
+    storage[0] = 0;
+    this->writeRampKey(storage.get());
 
     ///////////////////////////////////
 
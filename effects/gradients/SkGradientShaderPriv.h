@@ -20,6 +20,8 @@
 #include "SkBitmapCache.h"
 #include "SkShader.h"
 
+class SkData;
+
 static inline void sk_memset32_dither(uint32_t dst[], uint32_t v0, uint32_t v1,
                                int count) {
     if (count > 0) {
@@ -166,10 +168,12 @@ private:
     SkColor*    fOrigColors; // original colors, before modulation by paint in setContext
     bool        fColorsAreOpaque;
 
-    mutable uint16_t*   fCache16;   // working ptr. If this is NULL, we need to recompute the cache values
-    mutable SkPMColor*  fCache32;   // working ptr. If this is NULL, we need to recompute the cache values
+    mutable const uint16_t*  fCache16;   // working ptr. If this is NULL, we need to recompute the cache values
+    mutable const SkPMColor* fCache32;   // working ptr. If this is NULL, we need to recompute the cache values
 
-    mutable uint16_t*   fCache16Storage;    // storage for fCache16, allocated on demand
+    // The tables are immutable once built, and shared through SkGradientRampCache with other
+    // gradients that have the same colors, positions and flags (and alpha, for fCache32).
+    mutable SkData*     fCache16Data;       // storage for fCache16, allocated on demand
     mutable SkMallocPixelRef* fCache32PixelRef;
     mutable unsigned    fCacheAlpha;        // the alpha value we used when we computed the cache. larger than 8bits so we can store uninitialized value
 
@@ -177,6 +181,8 @@ private:
     static void Build32bitCache(SkPMColor[], SkColor c0, SkColor c1, int count,
                                 U8CPU alpha, uint32_t gradFlags);
     void setCacheAlpha(U8CPU alpha) const;
+    int rampKeyCount() const;
+    void writeRampKey(int32_t key[]) const;
     void initCommon();
 
     typedef SkShader INHERITED;
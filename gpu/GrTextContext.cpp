@@ -69,8 +69,12 @@ GrFontScaler* GrTextContext::GetGrFontScaler(SkGlyphCache* cache) {
         scaler = (GrFontScaler*)auxData;
     }
     if (NULL == scaler) {
-        scaler = SkNEW_ARGS(SkGrFontScaler, (cache));
-        cache->setAuxProc(GlyphCacheAuxProc, scaler);
+        GrFontScaler* newScaler = SkNEW_ARGS(SkGrFontScaler, (cache));
+        scaler = (GrFontScaler*)cache->setAuxProc(GlyphCacheAuxProc, newScaler);
+        if (scaler != newScaler) {
+            // another thread got there first, so use its scaler
+            newScaler->unref();
+        }
     }
 
     return scaler;
@@ -21,6 +21,11 @@ static const GrGLint kDefaultMaxVertexAttribs = 8;
 // the OpenGLES 2.0 spec says this must be >= 8
 static const GrGLint kDefaultMaxVaryingVectors = 8;
 
+// Returned by GetProgramBinary for every program. The format is an arbitrary value that no real
+// driver uses.
+static const GrGLenum kNoOpProgramBinaryFormat = 0x4E554C4C;
+static const char kNoOpProgramBinary[] = { 'n', 'u', 'l', 'l' };
+
 static const char* kExtensions[] = {
     "GL_ARB_framebuffer_object",
     "GL_ARB_blend_func_extended",
@@ -511,6 +516,12 @@ GrGLvoid GR_GL_FUNCTION_TYPE noOpGLGetIntegerv(GrGLenum pname, GrGLint* params)
         case GR_GL_NUM_EXTENSIONS:
             *params = GR_ARRAY_COUNT(kExtensions);
             break;
+        case GR_GL_NUM_PROGRAM_BINARY_FORMATS:
+            *params = 1;
+            break;
+        case GR_GL_PROGRAM_BINARY_FORMATS:
+            *params = kNoOpProgramBinaryFormat;
+            break;
         default:
             GrCrash("Unexpected pname to GetIntegerv");
    }
@@ -539,6 +550,9 @@ GrGLvoid GR_GL_FUNCTION_TYPE noOpGLGetShaderOrProgramiv(GrGLuint program,
         case GR_GL_INFO_LOG_LENGTH:
             *params = 0;
             break;
+        case GR_GL_PROGRAM_BINARY_LENGTH:
+            *params = sizeof(kNoOpProgramBinary);
+            break;
         // we don't expect any other pnames
         default:
             GrCrash("Unexpected pname to GetProgramiv");
@@ -546,6 +560,30 @@ GrGLvoid GR_GL_FUNCTION_TYPE noOpGLGetShaderOrProgramiv(GrGLuint program,
    }
 }
 
+GrGLvoid GR_GL_FUNCTION_TYPE noOpGLGetProgramBinary(GrGLuint program,
+                                                   GrGLsizei bufsize,
+                                                   GrGLsizei* length,
+                                                   GrGLenum* binaryFormat,
+                                                   GrGLvoid* binary) {
+    GrGLsizei size = SkMin32(bufsize, sizeof(kNoOpProgramBinary));
+    memcpy(binary, kNoOpProgramBinary, size);
+    if (length) {
+        *length = size;
+    }
+    *binaryFormat = kNoOpProgramBinaryFormat;
+}
+
+GrGLvoid GR_GL_FUNCTION_TYPE noOpGLProgramBinary(GrGLuint program,
+                                                GrGLenum binaryFormat,
+                                                const GrGLvoid* binary,
+                                                GrGLsizei length) {
+}
+
+GrGLvoid GR_GL_FUNCTION_TYPE noOpGLProgramParameteri(GrGLuint program,
+                                                    GrGLenum pname,
+                                                    GrGLint value) {
+}
+
 namespace {
 template <typename T>
 void query_result(GrGLenum GLtarget, GrGLenum pname, T *params) {
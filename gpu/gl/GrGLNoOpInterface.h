@@ -339,6 +339,23 @@ GrGLvoid GR_GL_FUNCTION_TYPE noOpGLGetShaderOrProgramiv(GrGLuint program,
                                                         GrGLenum pname,
                                                         GrGLint* params);
 
+// Program binaries are a fixed placeholder blob, so that GrGLProgramBinaryCache can be exercised
+// on the null and debug interfaces (they are not part of GrGLInterface, see that class).
+GrGLvoid GR_GL_FUNCTION_TYPE noOpGLGetProgramBinary(GrGLuint program,
+                                                   GrGLsizei bufsize,
+                                                   GrGLsizei* length,
+                                                   GrGLenum* binaryFormat,
+                                                   GrGLvoid* binary);
+
+GrGLvoid GR_GL_FUNCTION_TYPE noOpGLProgramBinary(GrGLuint program,
+                                                GrGLenum binaryFormat,
+                                                const GrGLvoid* binary,
+                                                GrGLsizei length);
+
+GrGLvoid GR_GL_FUNCTION_TYPE noOpGLProgramParameteri(GrGLuint program,
+                                                    GrGLenum pname,
+                                                    GrGLint value);
+
 // Queries on bogus GLs just don't do anything at all. We could potentially make the timers work.
 GrGLvoid GR_GL_FUNCTION_TYPE noOpGLGetQueryiv(GrGLenum GLtarget,
                                               GrGLenum pname,
@@ -0,0 +1,272 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "GrGLProgramBinaryCache.h"
+
+#include "GrGLContext.h"
+#include "GrGLProgramDesc.h"
+#include "GrGLUtil.h"
+#include "SkData.h"
+#include "SkOSFile.h"
+#include "SkStream.h"
+
+#include <stdlib.h>
+
+#define GL_CALL(X) GR_GL_CALL(fContext.interface(), X)
+
+static const char kFileExtension[] = ".glprog";
+
+static SkString* gDirectory;
+static GrGLProgramBinaryCache::Procs gProcs;
+
+namespace {
+
+// A cache file is this header, followed by the driver string (padded to 4 bytes), the program
+// desc's key and the program binary.
+struct FileHeader {
+    enum {
+        kMagic = SkSetFourByteTag('g', 'p', 'b', 'c'),
+        // Bump when the file layout changes.
+        kVersion = 1,
+    };
+
+    uint32_t    fMagic;
+    uint32_t    fVersion;
+    uint32_t    fDriverLength;
+    uint32_t    fKeyLength;
+    uint32_t    fBinaryFormat;
+    uint32_t    fBinaryLength;
+};
+
+struct ParsedFile {
+    const FileHeader*   fHeader;
+    const char*         fDriver;
+    const uint32_t*     fKey;
+    const void*         fBinary;
+};
+
+}  // namespace
+
+// Returns false if data is not a complete cache file.
+static bool parse_file(const SkData* data, ParsedFile* file) {
+    size_t size = data->size();
+    if (size < sizeof(FileHeader)) {
+        return false;
+    }
+    const FileHeader* header = static_cast<const FileHeader*>(data->data());
+    if (FileHeader::kMagic != header->fMagic || FileHeader::kVersion != header->fVersion) {
+        return false;
+    }
+
+    size_t driverSize = SkAlign4(header->fDriverLength);
+    size_t keySize = header->fKeyLength;
+    size_t binarySize = header->fBinaryLength;
+    size -= sizeof(FileHeader);
+    // Compare piecewise so that corrupt lengths can't overflow.
+    if (driverSize > size || keySize > size - driverSize ||
+        binarySize != size - driverSize - keySize || !SkIsAlign4(keySize)) {
+        return false;
+    }
+
+    const char* ptr = reinterpret_cast<const char*>(header + 1);
+    file->fHeader = header;
+    file->fDriver = ptr;
+    file->fKey = reinterpret_cast<const uint32_t*>(ptr + driverSize);
+    file->fBinary = ptr + driverSize + keySize;
+    return true;
+}
+
+static bool driver_matches(const ParsedFile& file, const SkString& driver) {
+    return file.fHeader->fDriverLength == driver.size() &&
+           0 == memcmp(file.fDriver, driver.c_str(), driver.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GrGLProgramBinaryCache::SetDirectory(const char dir[], const Procs& procs) {
+    SkDELETE(gDirectory);
+    gDirectory = NULL;
+    if (NULL != dir && NULL != procs.fGetProgramBinary && NULL != procs.fProgramBinary) {
+        gDirectory = SkNEW_ARGS(SkString, (dir));
+        gProcs = procs;
+    }
+}
+
+GrGLProgramBinaryCache* GrGLProgramBinaryCache::Create(const GrGLContext& ctx) {
+    if (NULL == gDirectory) {
+        return NULL;
+    }
+    const GrGLInterface* gl = ctx.interface();
+    // Locations bound with BindUniformLocation before linking would not be restored by a binary,
+    // and Chromium's command buffer doesn't expose program binaries to clients anyway.
+    if (NULL != gl->fFunctions.fBindUniformLocation || ctx.isChromium()) {
+        return NULL;
+    }
+
+    GrGLint formatCount = 0;
+    GR_GL_GetIntegerv(gl, GR_GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0) {
+        return NULL;
+    }
+
+    SkString driver;
+    static const GrGLenum kDriverStrings[] = { GR_GL_VENDOR, GR_GL_RENDERER, GR_GL_VERSION };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(kDriverStrings); ++i) {
+        const GrGLubyte* str;
+        GR_GL_CALL_RET(gl, str, GetString(kDriverStrings[i]));
+        if (NULL != str) {
+            driver.append(reinterpret_cast<const char*>(str));
+        }
+        driver.append("\n");
+    }
+
+    GrGLProgramBinaryCache* cache = SkNEW_ARGS(GrGLProgramBinaryCache, (ctx, driver));
+    cache->loadDirectory();
+    return cache;
+}
+
+GrGLProgramBinaryCache::GrGLProgramBinaryCache(const GrGLContext& ctx, const SkString& driver)
+    : fContext(ctx)
+    , fDir(*gDirectory)
+    , fProcs(gProcs)
+    , fDriver(driver) {
+}
+
+GrGLProgramBinaryCache::~GrGLProgramBinaryCache() {
+    for (int i = 0; i < fEntries.count(); ++i) {
+        fEntries[i].fData->unref();
+    }
+}
+
+SkString GrGLProgramBinaryCache::pathFor(uint32_t checksum) const {
+    SkString path(fDir);
+    if (!path.isEmpty() && !path.endsWith(SkPATH_SEPARATOR)) {
+        path.appendUnichar(SkPATH_SEPARATOR);
+    }
+    path.appendf("%08x%s", checksum, kFileExtension);
+    return path;
+}
+
+void GrGLProgramBinaryCache::loadDirectory() {
+    SkOSFile::Iter iter(fDir.c_str(), kFileExtension);
+    SkString name;
+    while (iter.next(&name)) {
+        char* end;
+        uint32_t checksum = (uint32_t)strtoul(name.c_str(), &end, 16);
+        if (end != name.c_str() + 8 || 0 != strcmp(end, kFileExtension)) {
+            continue;
+        }
+        // The file is mapped, so programs that are never used cost no reads.
+        SkData* data = SkData::NewFromFileName(this->pathFor(checksum).c_str());
+        ParsedFile file;
+        if (NULL != data && parse_file(data, &file) && driver_matches(file, fDriver)) {
+            this->setEntry(checksum, data);
+        } else {
+            SkSafeUnref(data);
+        }
+    }
+}
+
+int GrGLProgramBinaryCache::find(const GrGLProgramDesc& desc) const {
+    uint32_t checksum = desc.getChecksum();
+    for (int i = 0; i < fEntries.count(); ++i) {
+        if (fEntries[i].fChecksum != checksum) {
+            continue;
+        }
+        ParsedFile file;
+        SkAssertResult(parse_file(fEntries[i].fData, &file));
+        if (file.fHeader->fKeyLength == desc.keyLength() &&
+            0 == memcmp(file.fKey, desc.asKey(), desc.keyLength())) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void GrGLProgramBinaryCache::setEntry(uint32_t checksum, SkData* data) {
+    for (int i = 0; i < fEntries.count(); ++i) {
+        if (fEntries[i].fChecksum == checksum) {
+            fEntries[i].fData->unref();
+            fEntries[i].fData = data;
+            return;
+        }
+    }
+    Entry* entry = fEntries.append();
+    entry->fChecksum = checksum;
+    entry->fData = data;
+}
+
+void GrGLProgramBinaryCache::removeEntry(int index) {
+    fEntries[index].fData->unref();
+    fEntries.removeShuffle(index);
+}
+
+bool GrGLProgramBinaryCache::loadProgram(GrGLuint programID, const GrGLProgramDesc& desc) {
+    int index = this->find(desc);
+    if (index < 0) {
+        return false;
+    }
+    ParsedFile file;
+    SkAssertResult(parse_file(fEntries[index].fData, &file));
+
+    fProcs.fProgramBinary(programID, file.fHeader->fBinaryFormat, file.fBinary,
+                          file.fHeader->fBinaryLength);
+
+    // Drivers reject binaries after an update or for other reasons of their own, so this is
+    // always checked (unlike the link status of a program built from source).
+    GrGLint linked = GR_GL_INIT_ZERO;
+    GL_CALL(GetProgramiv(programID, GR_GL_LINK_STATUS, &linked));
+    if (!linked) {
+        this->removeEntry(index);
+        return false;
+    }
+    return true;
+}
+
+void GrGLProgramBinaryCache::prepareToLink(GrGLuint programID) {
+    if (NULL != fProcs.fProgramParameteri) {
+        fProcs.fProgramParameteri(programID, GR_GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GR_GL_TRUE);
+    }
+}
+
+void GrGLProgramBinaryCache::storeProgram(GrGLuint programID, const GrGLProgramDesc& desc) {
+    GrGLint length = GR_GL_INIT_ZERO;
+    GL_CALL(GetProgramiv(programID, GR_GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0) {
+        return;
+    }
+    SkAutoMalloc binary(length);
+    GrGLsizei binaryLength = GR_GL_INIT_ZERO;
+    GrGLenum binaryFormat = GR_GL_INIT_ZERO;
+    fProcs.fGetProgramBinary(programID, length, &binaryLength, &binaryFormat, binary.get());
+    if (binaryLength <= 0) {
+        return;
+    }
+
+    FileHeader header;
+    header.fMagic = FileHeader::kMagic;
+    header.fVersion = FileHeader::kVersion;
+    header.fDriverLength = SkToU32(fDriver.size());
+    header.fKeyLength = desc.keyLength();
+    header.fBinaryFormat = binaryFormat;
+    header.fBinaryLength = binaryLength;
+
+    SkDynamicMemoryWStream stream;
+    stream.write(&header, sizeof(header));
+    stream.write(fDriver.c_str(), fDriver.size());
+    stream.padToAlign4();
+    stream.write(desc.asKey(), desc.keyLength());
+    stream.write(binary.get(), binaryLength);
+    SkData* data = stream.copyToData();
+
+    uint32_t checksum = desc.getChecksum();
+    SkFILEWStream file(this->pathFor(checksum).c_str());
+    if (file.isValid()) {
+        file.write(data->data(), data->size());
+    }
+    this->setEntry(checksum, data);
+}
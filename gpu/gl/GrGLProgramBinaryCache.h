@@ -0,0 +1,112 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef GrGLProgramBinaryCache_DEFINED
+#define GrGLProgramBinaryCache_DEFINED
+
+#include "gl/GrGLFunctions.h"
+#include "SkString.h"
+#include "SkTDArray.h"
+
+class GrGLContext;
+class GrGLProgramDesc;
+class SkData;
+
+/**
+ * Opt-in, on-disk cache of linked program binaries, keyed by GrGLProgramDesc. It lets a new
+ * process skip the shader compile and link for programs an earlier run already built. The shader
+ * code is still generated, since that also sets up the GrGLEffects that feed the uniforms.
+ *
+ * Each program is stored as "<dir>/<desc checksum>.glprog". The files found at startup are read
+ * into memory when the GrGpuGL is created. A file is only used if it was written by the same
+ * GL_VENDOR/GL_RENDERER/GL_VERSION and its stored key matches the desc exactly. If the driver
+ * rejects a binary anyway, the program is compiled from source and the file is replaced.
+ *
+ * The key does not capture the shader generation code itself, so the directory should be
+ * cleared (or made version specific) when Skia is updated.
+ */
+class GrGLProgramBinaryCache : public SkNoncopyable {
+public:
+    // glGetProgramBinary and friends are not part of GrGLInterface, so they are supplied here.
+    typedef GrGLvoid (GR_GL_FUNCTION_TYPE* GetProgramBinaryProc)(GrGLuint program,
+                                                                 GrGLsizei bufSize,
+                                                                 GrGLsizei* length,
+                                                                 GrGLenum* binaryFormat,
+                                                                 GrGLvoid* binary);
+    typedef GrGLvoid (GR_GL_FUNCTION_TYPE* ProgramBinaryProc)(GrGLuint program,
+                                                              GrGLenum binaryFormat,
+                                                              const GrGLvoid* binary,
+                                                              GrGLsizei length);
+    typedef GrGLvoid (GR_GL_FUNCTION_TYPE* ProgramParameteriProc)(GrGLuint program,
+                                                                  GrGLenum pname,
+                                                                  GrGLint value);
+
+    struct Procs {
+        GetProgramBinaryProc    fGetProgramBinary;
+        ProgramBinaryProc       fProgramBinary;
+        ProgramParameteriProc   fProgramParameteri;  // optional, sets the retrievable hint
+    };
+
+    /**
+     * Enables the cache for GrGpuGLs created after this call, storing programs in dir (which
+     * must exist). Passing NULL disables it. This is not synchronized with GrGpuGL creation,
+     * so it should be done once at startup.
+     */
+    static void SetDirectory(const char dir[], const Procs& procs);
+
+    /**
+     * Returns a new cache for the context, or NULL if the cache is disabled or the context can't
+     * use it (no binary formats, or uniform locations that are bound before linking).
+     */
+    static GrGLProgramBinaryCache* Create(const GrGLContext&);
+
+    ~GrGLProgramBinaryCache();
+
+    /**
+     * Returns true if there is a binary for desc.
+     */
+    bool hasProgram(const GrGLProgramDesc& desc) const { return this->find(desc) >= 0; }
+
+    /**
+     * Loads the cached binary for desc into programID, a newly created program. Returns true if
+     * the program is linked and ready to use. Otherwise the driver rejected the binary, which is
+     * then dropped, and programID may not be usable any more.
+     */
+    bool loadProgram(GrGLuint programID, const GrGLProgramDesc& desc);
+
+    /**
+     * Must be called before linking a program that will be passed to storeProgram().
+     */
+    void prepareToLink(GrGLuint programID);
+
+    /**
+     * Saves the binary of a successfully linked program.
+     */
+    void storeProgram(GrGLuint programID, const GrGLProgramDesc& desc);
+
+private:
+    struct Entry {
+        uint32_t    fChecksum;
+        SkData*     fData;      // whole file, already validated against fDriver
+    };
+
+    GrGLProgramBinaryCache(const GrGLContext&, const SkString& driver);
+
+    void loadDirectory();
+    int find(const GrGLProgramDesc&) const;
+    void setEntry(uint32_t checksum, SkData*);  // takes ownership
+    void removeEntry(int index);
+    SkString pathFor(uint32_t checksum) const;
+
+    const GrGLContext&  fContext;
+    SkString            fDir;
+    Procs               fProcs;
+    SkString            fDriver;    // vendor, renderer and version strings
+    SkTDArray<Entry>    fEntries;
+};
+
+#endif
@@ -7,6 +7,7 @@
 
 #include "gl/GrGLShaderBuilder.h"
 #include "gl/GrGLProgram.h"
+#include "gl/GrGLProgramBinaryCache.h"
 #include "gl/GrGLUniformHandle.h"
 #include "GrCoordTransform.h"
 #include "GrDrawEffect.h"
@@ -576,6 +577,22 @@ bool GrGLShaderBuilder::finish(GrGLuint* outProgramId) {
         return false;
     }
 
+    GrGLProgramBinaryCache* binaryCache = fGpu->programBinaryCache();
+    if (NULL != binaryCache && binaryCache->hasProgram(fDesc)) {
+        if (binaryCache->loadProgram(programId, fDesc)) {
+            // Attribute and output locations are part of the binary.
+            fUniformManager.getUniformLocations(programId, fUniforms);
+            *outProgramId = programId;
+            return true;
+        }
+        // The driver rejected the binary, build the program from source in a fresh object.
+        GL_CALL(DeleteProgram(programId));
+        GL_CALL_RET(programId, CreateProgram());
+        if (!programId) {
+            return false;
+        }
+    }
+
     SkTDArray<GrGLuint> shadersToDelete;
 
     if (!this->compileAndAttachShaders(programId, &shadersToDelete)) {
@@ -588,6 +605,9 @@ bool GrGLShaderBuilder::finish(GrGLuint* outProgramId) {
       fUniformManager.getUniformLocations(programId, fUniforms);
     }
 
+    if (NULL != binaryCache) {
+        binaryCache->prepareToLink(programId);
+    }
     GL_CALL(LinkProgram(programId));
 
     // Calling GetProgramiv is expensive in Chromium. Assume success in release builds.
@@ -626,6 +646,10 @@ bool GrGLShaderBuilder::finish(GrGLuint* outProgramId) {
       GL_CALL(DeleteShader(shadersToDelete[i]));
     }
 
+    if (NULL != binaryCache) {
+        binaryCache->storeProgram(programId, fDesc);
+    }
+
     *outProgramId = programId;
     return true;
 }
@@ -9,6 +9,7 @@
 #include "GrGpuGL.h"
 #include "GrGLStencilBuffer.h"
 #include "GrGLPath.h"
+#include "GrGLProgramBinaryCache.h"
 #include "GrGLShaderBuilder.h"
 #include "GrTemplates.h"
 #include "GrTypes.h"
@@ -144,6 +145,7 @@ GrGpuGL::GrGpuGL(const GrGLContext& ctx, GrContext* context)
     }
 
     fProgramCache = SkNEW_ARGS(ProgramCache, (this));
+    fProgramBinaryCache = GrGLProgramBinaryCache::Create(fGLContext);
 
     SkASSERT(this->glCaps().maxVertexAttributes() >= GrDrawState::kMaxVertexAttribCnt);
 
@@ -160,6 +162,7 @@ GrGpuGL::~GrGpuGL() {
     }
 
     delete fProgramCache;
+    SkDELETE(fProgramBinaryCache);
 
     // This must be called by before the GrDrawTarget destructor
     this->releaseGeometry();
@@ -26,6 +26,8 @@
 #define PROGRAM_CACHE_STATS
 #endif
 
+class GrGLProgramBinaryCache;
+
 class GrGpuGL : public GrGpu {
 public:
     GrGpuGL(const GrGLContext& ctx, GrContext* context);
@@ -58,6 +60,9 @@ public:
                this->glCaps().pathRenderingSupport();
     }
 
+    // Used by GrGLShaderBuilder. NULL unless the on-disk program cache is enabled.
+    GrGLProgramBinaryCache* programBinaryCache() const { return fProgramBinaryCache; }
+
     bool programUnitTest(int maxStages);
 
     // GrGpu overrides
@@ -271,6 +276,7 @@ private:
 
     // GL program-related state
     ProgramCache*               fProgramCache;
+    GrGLProgramBinaryCache*     fProgramBinaryCache;    // NULL unless enabled
     SkAutoTUnref<GrGLProgram>   fCurrentProgram;
 
     ///////////////////////////////////////////////////////////////////////////
@@ -11,9 +11,13 @@
 #include "SkImageInfo.h"
 #include "SkImageGenerator.h"
 #include "SkImagePriv.h"
+#include "SkScaledImageCache.h"
 #include "SkStream.h"
 #include "SkUtils.h"
 
+// Defined in SkPixelRef.cpp.
+int32_t SkNextPixelRefGenerationID();
+
 static bool equal_modulo_alpha(const SkImageInfo& a, const SkImageInfo& b) {
     return a.width() == b.width() && a.height() == b.height() &&
            a.colorType() == b.colorType();
@@ -76,6 +80,50 @@ inline bool check_alpha(SkAlphaType reported, SkAlphaType actual) {
 }
 #endif  // SK_DEBUG
 
+// Returns the largest power of two sample size, up to 8, that keeps at least
+// scale of the image's width and height.
+int subset_sample_size(SkScalar scale) {
+    int sampleSize = 1;
+    while (sampleSize < 8 && scale * (2 * sampleSize) <= SK_Scalar1) {
+        sampleSize <<= 1;
+    }
+    return sampleSize;
+}
+
+// Maps subset of a width x height image onto bitmap, which holds the whole
+// image decoded at sampleSize. If the decoder did sample by sampleSize (so
+// that bitmap is width / sampleSize wide, rounded either way), a subset
+// whose edges are on whole samples maps onto whole pixels exactly.
+// Otherwise the subset is scaled to bitmap and rounded out.
+SkIRect scale_subset(const SkIRect& subset, int width, int height, int sampleSize,
+                     const SkBitmap& bitmap) {
+    const int w = bitmap.width();
+    const int h = bitmap.height();
+    if (w >= width / sampleSize && w <= (width + sampleSize - 1) / sampleSize &&
+        h >= height / sampleSize && h <= (height + sampleSize - 1) / sampleSize) {
+        return SkIRect::MakeLTRB(subset.fLeft / sampleSize,
+                                 subset.fTop / sampleSize,
+                                 SkTMin((subset.fRight + sampleSize - 1) / sampleSize, w),
+                                 SkTMin((subset.fBottom + sampleSize - 1) / sampleSize, h));
+    }
+    return SkIRect::MakeLTRB(SkToS32(subset.fLeft * (int64_t)w / width),
+                             SkToS32(subset.fTop * (int64_t)h / height),
+                             SkToS32((subset.fRight * (int64_t)w + width - 1) / width),
+                             SkToS32((subset.fBottom * (int64_t)h + height - 1) / height));
+}
+
+bool convert_to_color_type(SkBitmap* bitmap, SkColorType colorType) {
+    if (bitmap->colorType() == colorType) {
+        return true;
+    }
+    SkBitmap converted;
+    if (!bitmap->copyTo(&converted, colorType)) {
+        return false;
+    }
+    bitmap->swap(converted);
+    return true;
+}
+
 }  // namespace
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -90,6 +138,8 @@ SkDecodingImageGenerator::SkDecodingImageGenerator(
     , fInfo(info)
     , fSampleSize(sampleSize)
     , fDitherImage(ditherImage)
+    , fUniqueID(SkNextPixelRefGenerationID())
+    , fTriedTileDecoder(false)
 {
     SkASSERT(stream != NULL);
     SkSafeRef(fData);  // may be NULL.
@@ -180,7 +230,128 @@ bool SkDecodingImageGenerator::getPixels(const SkImageInfo& info,
     return true;
 }
 
-SkImageGenerator* SkDecodingImageGenerator::Create(
+SkScaledImageCache::ID* SkDecodingImageGenerator::lockSubset(const SkIRect& subset,
+                                                             SkScalar scale,
+                                                             SkBitmap* bitmap) {
+    SkASSERT(bitmap != NULL);
+    const SkIRect bounds = SkIRect::MakeWH(fInfo.width(), fInfo.height());
+    SkIRect clipped = subset;
+    if (scale <= 0 || !clipped.intersect(bounds)) {
+        return NULL;
+    }
+    const int sampleSize = subset_sample_size(scale);
+    // Entries are keyed by the scale they were decoded at, rather than the
+    // one asked for, so that nearby scales share them.
+    const SkScalar keyScale = SK_Scalar1 / sampleSize;
+
+    SkScaledImageCache::ID* id =
+        SkScaledImageCache::FindAndLockSubset(fUniqueID, keyScale, clipped, bitmap);
+    if (id != NULL) {
+        return id;
+    }
+    if (clipped == bounds) {
+        return this->decodeWhole(keyScale, sampleSize, bitmap);
+    }
+
+    SkBitmap whole;
+    id = SkScaledImageCache::FindAndLockSubset(fUniqueID, keyScale, bounds, &whole);
+    if (NULL == id) {
+        SkImageDecoder* decoder = this->getTileDecoder();
+        if (decoder != NULL) {
+            // The tile index is in the coordinates of the encoded image.
+            SkIRect region = clipped;
+            if (fSampleSize > 1) {
+                region.set(region.fLeft * fSampleSize, region.fTop * fSampleSize,
+                           region.fRight * fSampleSize, region.fBottom * fSampleSize);
+            }
+            decoder->setSampleSize(fSampleSize * sampleSize);
+            SkBitmap::Config legacyConfig = SkColorTypeToBitmapConfig(fInfo.colorType());
+            SkBitmap decoded;
+            if (decoder->decodeSubset(&decoded, region, legacyConfig) &&
+                convert_to_color_type(&decoded, fInfo.colorType())) {
+                id = SkScaledImageCache::AddAndLockSubset(fUniqueID, keyScale,
+                                                          clipped, decoded);
+                if (id != NULL) {
+                    *bitmap = decoded;
+                }
+                return id;
+            }
+        }
+        id = this->decodeWhole(keyScale, sampleSize, &whole);
+        if (NULL == id) {
+            return NULL;
+        }
+    }
+
+    SkIRect scaledSubset = scale_subset(clipped, fInfo.width(), fInfo.height(),
+                                         sampleSize, whole);
+    if (!whole.extractSubset(bitmap, scaledSubset)) {
+        SkScaledImageCache::Unlock(id);
+        return NULL;
+    }
+    return id;
+}
+
+SkImageDecoder* SkDecodingImageGenerator::getTileDecoder() {
+    if (fTriedTileDecoder) {
+        return fTileDecoder.get();
+    }
+    fTriedTileDecoder = true;
+
+    // The decoder reads from its stream each time it decodes a tile, so it
+    // needs one of its own.
+    SkAutoTUnref<SkStreamRewindable> stream(fStream->duplicate());
+    if (NULL == stream.get()) {
+        return NULL;
+    }
+    SkAutoTDelete<SkImageDecoder> decoder(SkImageDecoder::Factory(stream));
+    if (NULL == decoder.get()) {
+        return NULL;
+    }
+    decoder->setDitherImage(fDitherImage);
+    // Most decoders cannot build a tile index.
+    if (!decoder->buildTileIndex(stream, NULL, NULL)) {
+        return NULL;
+    }
+    fTileDecoder.reset(decoder.detach());
+    return fTileDecoder.get();
+}
+
+SkScaledImageCache::ID* SkDecodingImageGenerator::decodeWhole(SkScalar keyScale,
+                                                              int sampleSize,
+                                                              SkBitmap* bitmap) {
+    const SkIRect bounds = SkIRect::MakeWH(fInfo.width(), fInfo.height());
+    SkScaledImageCache::ID* id =
+        SkScaledImageCache::FindAndLockSubset(fUniqueID, keyScale, bounds, bitmap);
+    if (id != NULL) {
+        return id;
+    }
+
+    SkAssertResult(fStream->rewind());
+    SkAutoTDelete<SkImageDecoder> decoder(SkImageDecoder::Factory(fStream));
+    if (NULL == decoder.get()) {
+        return NULL;
+    }
+    decoder->setDitherImage(fDitherImage);
+    decoder->setSampleSize(fSampleSize * sampleSize);
+    decoder->setAllocator(SkScaledImageCache::GetAllocator());
+
+    SkBitmap decoded;
+    SkBitmap::Config legacyConfig = SkColorTypeToBitmapConfig(fInfo.colorType());
+    bool success = decoder->decode(fStream, &decoded, legacyConfig,
+                                   SkImageDecoder::kDecodePixels_Mode);
+    decoder->setAllocator(NULL);
+    if (!success || !convert_to_color_type(&decoded, fInfo.colorType())) {
+        return NULL;
+    }
+    id = SkScaledImageCache::AddAndLockSubset(fUniqueID, keyScale, bounds, decoded);
+    if (id != NULL) {
+        *bitmap = decoded;
+    }
+    return id;
+}
+
+SkDecodingImageGenerator* SkDecodingImageGenerator::Create(
         SkData* data,
         const SkDecodingImageGenerator::Options& opts) {
     SkASSERT(data != NULL);
@@ -193,7 +364,7 @@ SkImageGenerator* SkDecodingImageGenerator::Create(
     return SkDecodingImageGenerator::Create(data, stream, opts);
 }
 
-SkImageGenerator* SkDecodingImageGenerator::Create(
+SkDecodingImageGenerator* SkDecodingImageGenerator::Create(
         SkStreamRewindable* stream,
         const SkDecodingImageGenerator::Options& opts) {
     SkASSERT(stream != NULL);
@@ -206,9 +377,9 @@ SkImageGenerator* SkDecodingImageGenerator::Create(
 }
 
 // A contructor-type function that returns NULL on failure.  This
-// prevents the returned SkImageGenerator from ever being in a bad
+// prevents the returned SkDecodingImageGenerator from ever being in a bad
 // state.  Called by both Create() functions
-SkImageGenerator* SkDecodingImageGenerator::Create(
+SkDecodingImageGenerator* SkDecodingImageGenerator::Create(
         SkData* data,
         SkStreamRewindable* stream,
         const SkDecodingImageGenerator::Options& opts) {
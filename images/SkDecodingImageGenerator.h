@@ -10,8 +10,11 @@
 
 #include "SkBitmap.h"
 #include "SkImageGenerator.h"
+#include "SkScaledImageCache.h"
+#include "SkTemplates.h"
 
 class SkData;
+class SkImageDecoder;
 class SkStreamRewindable;
 
 /**
@@ -27,6 +30,35 @@ public:
     virtual bool getPixels(const SkImageInfo& info,
                            void* pixels,
                            size_t rowBytes) SK_OVERRIDE;
+
+    /**
+     *  Decode only the part of the image that is needed to draw subset
+     *  (in the coordinates of getInfo()) at scale, and keep the result in
+     *  the global SkScaledImageCache, so that drawing it again does not
+     *  decode again.
+     *
+     *  The image is decoded at the smallest power of two sample size (no
+     *  more than 8, the smallest scale a JPEG decoder can produce
+     *  directly from the DCT coefficients) that still has at least scale
+     *  times as many pixels as the image.  If the decoder can build a
+     *  tile index, only subset is decoded; otherwise the whole image is
+     *  decoded and cached at that sample size, and later subsets at the
+     *  same scale come from it.
+     *
+     *  A subset whose edges are on whole samples (or the image's edges)
+     *  maps exactly onto the decoded pixels; others are rounded out.
+     *
+     *  On success, bitmap holds the subset at the decoded scale, and the
+     *  returned ID must be passed to SkScaledImageCache::Unlock() when
+     *  the caller is done with bitmap.  Returns NULL on failure.
+     *
+     *  Like getPixels(), this may not be called on more than one thread
+     *  at a time.
+     */
+    SkScaledImageCache::ID* lockSubset(const SkIRect& subset,
+                                       SkScalar scale,
+                                       SkBitmap* bitmap);
+
     /**
      *  These options will be passed on to the image decoder.  The
      *  defaults are sensible.
@@ -72,8 +104,12 @@ public:
     };
 
     /**
-     *  These two functions return a SkImageGenerator that calls into
-     *  SkImageDecoder.  They return NULL on failure.
+     *  These two functions return a SkDecodingImageGenerator, which
+     *  calls into SkImageDecoder.  They return NULL on failure.
+     *
+     *  Passing the result to SkCachingPixelRef::Install() (rather than as
+     *  a plain SkImageGenerator) lets drawing use lockSubset(), so that a
+     *  downscaled draw decodes only at the scale it needs.
      *
      *  The SkData version of this function is preferred.  If the stream
      *  has an underlying SkData (such as a SkMemoryStream) pass that in.
@@ -87,7 +123,7 @@ public:
      *  For example:
      *    SkStreamRewindable* stream;
      *    ...
-     *    SkImageGenerator* gen
+     *    SkDecodingImageGenerator* gen
      *        = SkDecodingImageGenerator::Create(
      *            stream->duplicate(), SkDecodingImageGenerator::Options());
      *    ...
@@ -95,17 +131,17 @@ public:
      *
      *  @param Options (see above)
      *
-     *  @return NULL on failure, a new SkImageGenerator on success.
+     *  @return NULL on failure, a new SkDecodingImageGenerator on success.
      */
-    static SkImageGenerator* Create(SkStreamRewindable* stream,
-                                    const Options& opt);
+    static SkDecodingImageGenerator* Create(SkStreamRewindable* stream,
+                                            const Options& opt);
 
     /**
      *  @param data Contains the encoded image data that will be used by
      *         the SkDecodingImageGenerator.  Will be ref()ed by the
      *         SkImageGenerator constructor and and unref()ed on deletion.
      */
-    static SkImageGenerator* Create(SkData* data, const Options& opt);
+    static SkDecodingImageGenerator* Create(SkData* data, const Options& opt);
 
 private:
     SkData*                fData;
@@ -113,14 +149,23 @@ private:
     const SkImageInfo      fInfo;
     const int              fSampleSize;
     const bool             fDitherImage;
+    // Cache key for lockSubset(), from the same ID space as pixel refs.
+    const uint32_t         fUniqueID;
+    // Built the first time lockSubset() is called, if the decoder can.
+    SkAutoTDelete<SkImageDecoder> fTileDecoder;
+    bool                   fTriedTileDecoder;
+
+    SkImageDecoder* getTileDecoder();
+    SkScaledImageCache::ID* decodeWhole(SkScalar scale, int sampleSize,
+                                        SkBitmap* bitmap);
 
     SkDecodingImageGenerator(SkData* data,
                              SkStreamRewindable* stream,
                              const SkImageInfo& info,
                              int sampleSize,
                              bool ditherImage);
-    static SkImageGenerator* Create(SkData*, SkStreamRewindable*,
-                                    const Options&);
+    static SkDecodingImageGenerator* Create(SkData*, SkStreamRewindable*,
+                                            const Options&);
     typedef SkImageGenerator INHERITED;
 };
 
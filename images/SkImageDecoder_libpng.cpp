@@ -13,6 +13,7 @@
 #include "SkColorPriv.h"
 #include "SkDither.h"
 #include "SkMath.h"
+#include "SkParallel.h"
 #include "SkRTConf.h"
 #include "SkScaledBitmapSampler.h"
 #include "SkStream.h"
@@ -216,6 +217,126 @@ void do_nothing_warning_fn(png_structp, png_const_charp) {
     /* do nothing */
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+// When there are threads to spare, non-interlaced images are decoded in
+// batches of rows: while the sampler converts one batch into the bitmap
+// (split into slices across the threads), libpng inflates and unfilters the
+// next one.
+static const int kRowsPerDecodeBatch = 32;
+static const int kMaxDecodeSlices = 8;
+
+namespace {
+
+struct DecodePipeline {
+    png_structp                  fPng;
+    const SkScaledBitmapSampler* fSampler;
+    size_t                       fSrcRowBytes;
+    uint8_t*                     fSkipRow;
+    uint8_t*                     fBatches[2];
+
+    // Output rows [fReadY, fReadY + fReadCount) are read into
+    // fBatches[fReadBatch] while [fConvertY, fConvertY + fConvertCount) are
+    // converted from the other batch.
+    int                          fReadBatch;
+    int                          fReadY;
+    int                          fReadCount;
+    bool                         fReadFailed;
+    int                          fConvertY;
+    int                          fConvertCount;
+    int                          fSliceCount;
+    bool                         fSliceHadAlpha[kMaxDecodeSlices];
+};
+
+}  // namespace
+
+static void read_batch(DecodePipeline* pipe) {
+    png_structp png_ptr = pipe->fPng;
+    // This may not run on the decoding thread, and libpng reports errors by
+    // longjmp, so catch them here. decode_pipelined()'s caller must set its
+    // own handler again afterwards.
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        pipe->fReadFailed = true;
+        return;
+    }
+    uint8_t* row = pipe->fBatches[pipe->fReadBatch];
+    for (int i = 0; i < pipe->fReadCount; i++) {
+        if (pipe->fReadY + i > 0) {
+            skip_src_rows(png_ptr, pipe->fSkipRow, pipe->fSampler->srcDY() - 1);
+        }
+        uint8_t* tmp = row;
+        png_read_rows(png_ptr, &tmp, png_bytepp_NULL, 1);
+        row += pipe->fSrcRowBytes;
+    }
+}
+
+static void convert_slice(DecodePipeline* pipe, int slice) {
+    const int start = pipe->fConvertCount * slice / pipe->fSliceCount;
+    const int stop = pipe->fConvertCount * (slice + 1) / pipe->fSliceCount;
+    const uint8_t* row = pipe->fBatches[pipe->fReadBatch ^ 1] + start * pipe->fSrcRowBytes;
+    bool hadAlpha = false;
+    for (int i = start; i < stop; i++) {
+        hadAlpha |= pipe->fSampler->sampleRow(row, pipe->fConvertY + i);
+        row += pipe->fSrcRowBytes;
+    }
+    pipe->fSliceHadAlpha[slice] = hadAlpha;
+}
+
+static void run_decode_stage(void* context, int index) {
+    DecodePipeline* pipe = static_cast<DecodePipeline*>(context);
+    if (0 == index) {
+        read_batch(pipe);
+    } else {
+        convert_slice(pipe, index - 1);
+    }
+}
+
+/*  Reads and samples the rows of a non-interlaced image, starting at the
+    sampler's first source row. Returns false if libpng reported an error.
+    Either way, libpng's error handler is left pointing at a stack frame that
+    no longer exists, so the caller must call setjmp again before using
+    png_ptr.
+ */
+static bool decode_pipelined(png_structp png_ptr, const SkScaledBitmapSampler& sampler,
+                             size_t srcRowBytes, int height, bool* reallyHasAlpha) {
+    SkAutoMalloc storage(srcRowBytes * (2 * kRowsPerDecodeBatch + 1));
+
+    DecodePipeline pipe;
+    pipe.fPng = png_ptr;
+    pipe.fSampler = &sampler;
+    pipe.fSrcRowBytes = srcRowBytes;
+    pipe.fSkipRow = (uint8_t*)storage.get();
+    pipe.fBatches[0] = pipe.fSkipRow + srcRowBytes;
+    pipe.fBatches[1] = pipe.fBatches[0] + kRowsPerDecodeBatch * srcRowBytes;
+    pipe.fReadBatch = 0;
+    pipe.fReadY = 0;
+    pipe.fReadCount = SkMin32(kRowsPerDecodeBatch, height);
+    pipe.fReadFailed = false;
+    pipe.fConvertY = 0;
+    pipe.fConvertCount = 0;
+    pipe.fSliceCount = SkPin32(SkParallel::Concurrency() - 1, 1, kMaxDecodeSlices);
+
+    while (pipe.fReadCount > 0 || pipe.fConvertCount > 0) {
+        const int slices = pipe.fConvertCount > 0 ? pipe.fSliceCount : 0;
+        SkParallel::For(1 + slices, run_decode_stage, &pipe);
+        if (pipe.fReadFailed) {
+            return false;
+        }
+        for (int i = 0; i < slices; i++) {
+            *reallyHasAlpha |= pipe.fSliceHadAlpha[i];
+        }
+
+        // Convert the batch that was just read while reading the next one
+        // into the other buffer.
+        pipe.fConvertY = pipe.fReadY;
+        pipe.fConvertCount = pipe.fReadCount;
+        pipe.fReadY += pipe.fReadCount;
+        pipe.fReadCount = SkMin32(kRowsPerDecodeBatch, height - pipe.fReadY);
+        pipe.fReadBatch ^= 1;
+    }
+    return true;
+}
+
 bool SkPNGImageDecoder::onDecodeInit(SkStream* sk_stream, png_structp *png_ptrp,
                                      png_infop *info_ptrp) {
     /* Create and initialize the png_struct with the desired error handler
@@ -444,12 +565,22 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
             uint8_t* srcRow = (uint8_t*)storage.get();
             skip_src_rows(png_ptr, srcRow, sampler.srcY0());
 
-            for (int y = 0; y < height; y++) {
-                uint8_t* tmp = srcRow;
-                png_read_rows(png_ptr, &tmp, png_bytepp_NULL, 1);
-                reallyHasAlpha |= sampler.next(srcRow);
-                if (y < height - 1) {
-                    skip_src_rows(png_ptr, srcRow, sampler.srcDY() - 1);
+            if (SkParallel::Concurrency() > 1 && height >= 2 * kRowsPerDecodeBatch) {
+                if (!decode_pipelined(png_ptr, sampler, origWidth * srcBytesPerPixel,
+                                      height, &reallyHasAlpha)) {
+                    return false;
+                }
+                if (setjmp(png_jmpbuf(png_ptr))) {
+                    return false;
+                }
+            } else {
+                for (int y = 0; y < height; y++) {
+                    uint8_t* tmp = srcRow;
+                    png_read_rows(png_ptr, &tmp, png_bytepp_NULL, 1);
+                    reallyHasAlpha |= sampler.next(srcRow);
+                    if (y < height - 1) {
+                        skip_src_rows(png_ptr, srcRow, sampler.srcDY() - 1);
+                    }
                 }
             }
 
@@ -1105,6 +1236,193 @@ static inline int pack_palette(SkColorTable* ctable,
     return num_trans;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+// When there are threads to spare, tall images are filtered and deflated in
+// bands of this many rows. Each band is an independent raw deflate stream
+// (all but the last ending in a full flush), so the bands can simply be
+// concatenated into the image's zlib stream. The band size is fixed, so the
+// output does not depend on the number of threads.
+static const int kRowsPerEncodeBand = 64;
+
+namespace {
+
+struct EncodeBand {
+    SkAutoMalloc fStorage;
+    size_t       fSize;      // compressed bytes in fStorage
+    uLong        fAdler;     // of the band's filtered rows
+    uLong        fFilteredSize;
+    bool         fSucceeded;
+};
+
+struct EncodeRec {
+    const SkBitmap*         fBitmap;
+    transform_scanline_proc fProc;
+    size_t                  fRowBytes;   // of the transformed rows
+    int                     fBytesPerPixel;
+    int                     fLastFilter; // filters tried: NONE up to this
+    EncodeBand*             fBands;
+    int                     fBandCount;
+};
+
+}  // namespace
+
+static inline uint8_t paeth_predictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = SkAbs32(p - a);
+    int pb = SkAbs32(p - b);
+    int pc = SkAbs32(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+/*  Writes row filtered with each PNG filter up to lastFilter into out (each
+    one preceded by its filter type byte) and returns the one with the
+    smallest sum of absolute (signed) differences, the same heuristic libpng
+    uses.
+ */
+static const uint8_t* filter_row(const uint8_t* row, const uint8_t* prior,
+                                 size_t rowBytes, int bpp, int lastFilter,
+                                 uint8_t* out) {
+    const uint8_t* best = NULL;
+    uint32_t bestSum = 0;
+    for (int type = PNG_FILTER_VALUE_NONE; type <= lastFilter; type++) {
+        uint8_t* dst = out + type * (rowBytes + 1);
+        dst[0] = type;
+        uint32_t sum = 0;
+        for (size_t i = 0; i < rowBytes; i++) {
+            int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+            int b = prior[i];
+            int c = i >= (size_t)bpp ? prior[i - bpp] : 0;
+            int predicted;
+            switch (type) {
+                case PNG_FILTER_VALUE_SUB:   predicted = a; break;
+                case PNG_FILTER_VALUE_UP:    predicted = b; break;
+                case PNG_FILTER_VALUE_AVG:   predicted = (a + b) >> 1; break;
+                case PNG_FILTER_VALUE_PAETH: predicted = paeth_predictor(a, b, c); break;
+                default:                     predicted = 0; break;
+            }
+            uint8_t v = (uint8_t)(row[i] - predicted);
+            dst[i + 1] = v;
+            sum += SkAbs32((int8_t)v);
+        }
+        if (NULL == best || sum < bestSum) {
+            best = dst;
+            bestSum = sum;
+        }
+    }
+    return best;
+}
+
+static void encode_band(void* context, int index) {
+    EncodeRec* rec = static_cast<EncodeRec*>(context);
+    EncodeBand* band = &rec->fBands[index];
+    const SkBitmap& bitmap = *rec->fBitmap;
+    const size_t rowBytes = rec->fRowBytes;
+    const int startY = index * kRowsPerEncodeBand;
+    const int stopY = SkMin32(startY + kRowsPerEncodeBand, bitmap.height());
+    const bool isLast = index == rec->fBandCount - 1;
+    band->fSucceeded = false;
+
+    // Two transformed rows, the five filtered versions of a row, and the
+    // filtered band.
+    band->fFilteredSize = (stopY - startY) * (rowBytes + 1);
+    SkAutoMalloc storage(2 * rowBytes + 5 * (rowBytes + 1) + band->fFilteredSize);
+    uint8_t* prior = (uint8_t*)storage.get();
+    uint8_t* row = prior + rowBytes;
+    uint8_t* candidates = row + rowBytes;
+    uint8_t* filtered = candidates + 5 * (rowBytes + 1);
+
+    // The first row of a band is filtered against the last row of the band
+    // before it.
+    if (0 == startY) {
+        memset(prior, 0, rowBytes);
+    } else {
+        rec->fProc((const char*)bitmap.getAddr(0, startY - 1), bitmap.width(), (char*)prior);
+    }
+    uint8_t* dst = filtered;
+    for (int y = startY; y < stopY; y++) {
+        rec->fProc((const char*)bitmap.getAddr(0, y), bitmap.width(), (char*)row);
+        memcpy(dst, filter_row(row, prior, rowBytes, rec->fBytesPerPixel,
+                                   rec->fLastFilter, candidates),
+               rowBytes + 1);
+        dst += rowBytes + 1;
+        SkTSwap(prior, row);
+    }
+    band->fAdler = adler32(adler32(0L, Z_NULL, 0), filtered, band->fFilteredSize);
+
+    z_stream zstream;
+    memset(&zstream, 0, sizeof(zstream));
+    if (Z_OK != deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                             8, Z_FILTERED)) {
+        return;
+    }
+    // Leave room for the zlib header in the first band and the checksum in
+    // the last; a full flush adds at most a few bytes to deflateBound().
+    const size_t header = 0 == index ? 2 : 0;
+    const size_t capacity = deflateBound(&zstream, band->fFilteredSize) + 16;
+    uint8_t* out = (uint8_t*)band->fStorage.reset(header + capacity + 4);
+    zstream.next_in = filtered;
+    zstream.avail_in = band->fFilteredSize;
+    zstream.next_out = out + header;
+    zstream.avail_out = capacity;
+    int result = deflate(&zstream, isLast ? Z_FINISH : Z_FULL_FLUSH);
+    band->fSucceeded = (isLast ? Z_STREAM_END == result : Z_OK == result) &&
+                       0 == zstream.avail_in && zstream.avail_out > 0;
+    band->fSize = header + zstream.total_out;
+    deflateEnd(&zstream);
+}
+
+/*  Writes the image data of bitmap as IDAT chunks, one per band, followed
+    by the IEND chunk, in place of png_write_rows() and png_write_end().
+ */
+static bool write_parallel_idat(png_structp png_ptr, const SkBitmap& bitmap,
+                                transform_scanline_proc proc, int bytesPerPixel) {
+    EncodeRec rec;
+    rec.fBitmap = &bitmap;
+    rec.fProc = proc;
+    rec.fBytesPerPixel = bytesPerPixel;
+    // Like libpng, only filter images that are not palette based.
+    rec.fLastFilter = 1 == bytesPerPixel ? PNG_FILTER_VALUE_NONE : PNG_FILTER_VALUE_PAETH;
+    rec.fRowBytes = bitmap.width() * bytesPerPixel;
+    rec.fBandCount = (bitmap.height() + kRowsPerEncodeBand - 1) / kRowsPerEncodeBand;
+    SkAutoTArray<EncodeBand> bands(rec.fBandCount);
+    rec.fBands = bands.get();
+
+    SkParallel::For(rec.fBandCount, encode_band, &rec);
+
+    uLong adler = 0;
+    for (int i = 0; i < rec.fBandCount; i++) {
+        if (!bands[i].fSucceeded) {
+            return false;
+        }
+        adler = 0 == i ? bands[i].fAdler
+                       : adler32_combine(adler, bands[i].fAdler,
+                                         (z_off_t)bands[i].fFilteredSize);
+    }
+
+    // zlib header: deflate with a 32K window and the default level.
+    uint8_t* first = (uint8_t*)bands[0].fStorage.get();
+    first[0] = 0x78;
+    first[1] = 0x9C;
+    EncodeBand& last = bands[rec.fBandCount - 1];
+    uint8_t* trailer = (uint8_t*)last.fStorage.get() + last.fSize;
+    trailer[0] = (uint8_t)(adler >> 24);
+    trailer[1] = (uint8_t)(adler >> 16);
+    trailer[2] = (uint8_t)(adler >> 8);
+    trailer[3] = (uint8_t)adler;
+    last.fSize += 4;
+
+    for (int i = 0; i < rec.fBandCount; i++) {
+        png_write_chunk(png_ptr, (png_bytep)"IDAT",
+                        (png_bytep)bands[i].fStorage.get(), bands[i].fSize);
+    }
+    png_write_chunk(png_ptr, (png_bytep)"IEND", NULL, 0);
+    return true;
+}
+
 class SkPNGImageEncoder : public SkImageEncoder {
 protected:
     virtual bool onEncode(SkWStream* stream, const SkBitmap& bm, int quality) SK_OVERRIDE;
@@ -1240,19 +1558,29 @@ bool SkPNGImageEncoder::doEncode(SkWStream* stream, const SkBitmap& bitmap,
     png_set_sBIT(png_ptr, info_ptr, &sig_bit);
     png_write_info(png_ptr, info_ptr);
 
-    const char* srcImage = (const char*)bitmap.getPixels();
-    SkAutoSMalloc<1024> rowStorage(bitmap.width() << 2);
-    char* storage = (char*)rowStorage.get();
     transform_scanline_proc proc = choose_proc(config, hasAlpha);
 
-    for (int y = 0; y < bitmap.height(); y++) {
-        png_bytep row_ptr = (png_bytep)storage;
-        proc(srcImage, bitmap.width(), storage);
-        png_write_rows(png_ptr, &row_ptr, 1);
-        srcImage += bitmap.rowBytes();
-    }
+    if (SkParallel::Concurrency() > 1 && bitmap.height() >= 2 * kRowsPerEncodeBand) {
+        int bytesPerPixel = (colorType & PNG_COLOR_MASK_PALETTE) ? 1 :
+                            (colorType & PNG_COLOR_MASK_ALPHA) ? 4 : 3;
+        if (!write_parallel_idat(png_ptr, bitmap, proc, bytesPerPixel)) {
+            png_destroy_write_struct(&png_ptr, &info_ptr);
+            return false;
+        }
+    } else {
+        const char* srcImage = (const char*)bitmap.getPixels();
+        SkAutoSMalloc<1024> rowStorage(bitmap.width() << 2);
+        char* storage = (char*)rowStorage.get();
+
+        for (int y = 0; y < bitmap.height(); y++) {
+            png_bytep row_ptr = (png_bytep)storage;
+            proc(srcImage, bitmap.width(), storage);
+            png_write_rows(png_ptr, &row_ptr, 1);
+            srcImage += bitmap.rowBytes();
+        }
 
-    png_write_end(png_ptr, info_ptr);
+        png_write_end(png_ptr, info_ptr);
+    }
 
     /* clean up after the write, and free any memory allocated */
     png_destroy_write_struct(&png_ptr, &info_ptr);
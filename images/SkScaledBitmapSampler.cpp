@@ -7,6 +7,7 @@
 
 
 #include "SkScaledBitmapSampler.h"
+#include "SkScaledBitmapSampler_opts.h"
 #include "SkBitmap.h"
 #include "SkColorPriv.h"
 #include "SkDither.h"
@@ -566,6 +567,26 @@ static SkScaledBitmapSampler::RowProc get_gray_to_A8_proc(const SkImageDecoder&
 }
 
 typedef SkScaledBitmapSampler::RowProc (*RowProcChooser)(const SkImageDecoder& decoder);
+
+// Returns the platform's version of proc, if it has one, for rows in which
+// every pixel is sampled.
+static SkScaledBitmapSampler::RowProc get_platform_proc(SkScaledBitmapSampler::RowProc proc,
+                                                        int srcPixelSize) {
+    SkSamplerProcType type;
+    if (Sample_Gray_D8888 == proc) {
+        type = kGray_D8888_SkSamplerProcType;
+    } else if (Sample_RGBx_D8888 == proc) {
+        type = 3 == srcPixelSize ? kRGB_D8888_SkSamplerProcType
+                                 : kRGBX_D8888_SkSamplerProcType;
+    } else if (Sample_RGBA_D8888 == proc) {
+        type = kRGBA_D8888_SkSamplerProcType;
+    } else if (Sample_RGBA_D8888_Unpremul == proc) {
+        type = kRGBA_D8888_Unpremul_SkSamplerProcType;
+    } else {
+        return NULL;
+    }
+    return SkScaledBitmapSamplerGetPlatformProc(type);
+}
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SkScaledBitmapSampler.h"
@@ -575,6 +596,7 @@ SkScaledBitmapSampler::SkScaledBitmapSampler(int width, int height,
     fCTable = NULL;
     fDstRow = NULL;
     fRowProc = NULL;
+    fSampleRowProc = NULL;
 
     if (width <= 0 || height <= 0) {
         sk_throw();
@@ -710,6 +732,13 @@ bool SkScaledBitmapSampler::begin(SkBitmap* dst, SrcConfig sc,
     } else {
         fRowProc = chooser(decoder);
     }
+    fSampleRowProc = fRowProc;
+    if (fRowProc != NULL && 1 == fDX) {
+        RowProc platformProc = get_platform_proc(fRowProc, fSrcPixelSize);
+        if (platformProc != NULL) {
+            fSampleRowProc = platformProc;
+        }
+    }
     fDstRow = (char*)dst->getPixels();
     fDstRowBytes = dst->rowBytes();
     fCurrY = 0;
@@ -721,8 +750,8 @@ bool SkScaledBitmapSampler::next(const uint8_t* SK_RESTRICT src) {
     SkDEBUGCODE(fSampleMode = kConsecutive_SampleMode);
     SkASSERT((unsigned)fCurrY < (unsigned)fScaledHeight);
 
-    bool hadAlpha = fRowProc(fDstRow, src + fX0 * fSrcPixelSize, fScaledWidth,
-                             fDX * fSrcPixelSize, fCurrY, fCTable);
+    bool hadAlpha = fSampleRowProc(fDstRow, src + fX0 * fSrcPixelSize, fScaledWidth,
+                                   fDX * fSrcPixelSize, fCurrY, fCTable);
     fDstRow += fDstRowBytes;
     fCurrY += 1;
     return hadAlpha;
@@ -745,10 +774,15 @@ bool SkScaledBitmapSampler::sampleInterlaced(const uint8_t* SK_RESTRICT src, int
     // of the destination bitmap's pixels, which is used to calculate the destination row
     // each time this function is called.
     const int dstY = srcYMinusY0 / fDY;
-    SkASSERT(dstY < fScaledHeight);
+    return this->sampleRow(src, dstY);
+}
+
+bool SkScaledBitmapSampler::sampleRow(const uint8_t* SK_RESTRICT src, int dstY) const {
+    SkASSERT(kConsecutive_SampleMode != fSampleMode);
+    SkASSERT((unsigned)dstY < (unsigned)fScaledHeight);
     char* dstRow = fDstRow + dstY * fDstRowBytes;
-    return fRowProc(dstRow, src + fX0 * fSrcPixelSize, fScaledWidth,
-                    fDX * fSrcPixelSize, dstY, fCTable);
+    return fSampleRowProc(dstRow, src + fX0 * fSrcPixelSize, fScaledWidth,
+                          fDX * fSrcPixelSize, dstY, fCTable);
 }
 
 #ifdef SK_DEBUG
@@ -849,4 +883,57 @@ void test_row_proc_choice() {
     }
     SkASSERT(SK_ARRAY_COUNT(gTestProcs) == procCounter);
 }
+
+// Checks that each platform row proc gives the same pixels and the same
+// return value as the portable proc it replaces, for every alpha and color
+// value pair and for widths that exercise each proc's leftover pixels.
+void test_platform_row_procs();
+void test_platform_row_procs() {
+    static const struct {
+        SkSamplerProcType               fType;
+        SkScaledBitmapSampler::RowProc  fPortable;
+        int                             fSrcPixelSize;
+    } gProcs[] = {
+        { kGray_D8888_SkSamplerProcType,          Sample_Gray_D8888,          1 },
+        { kRGB_D8888_SkSamplerProcType,           Sample_RGBx_D8888,          3 },
+        { kRGBX_D8888_SkSamplerProcType,          Sample_RGBx_D8888,          4 },
+        { kRGBA_D8888_SkSamplerProcType,          Sample_RGBA_D8888,          4 },
+        { kRGBA_D8888_Unpremul_SkSamplerProcType, Sample_RGBA_D8888_Unpremul, 4 },
+    };
+    static const int kWidth = 256;
+    uint8_t src[kWidth * 4];
+    SkPMColor expected[kWidth];
+    SkPMColor actual[kWidth];
+
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gProcs); ++i) {
+        SkScaledBitmapSampler::RowProc platformProc =
+            SkScaledBitmapSamplerGetPlatformProc(gProcs[i].fType);
+        if (NULL == platformProc) {
+            continue;
+        }
+        const int srcPixelSize = gProcs[i].fSrcPixelSize;
+        for (int a = 0; a < 256; ++a) {
+            // One row has every color value with alpha a; in the other,
+            // the first pixels are opaque, so only the last one has alpha.
+            for (int opaqueRow = 0; opaqueRow <= 1; ++opaqueRow) {
+                for (int x = 0; x < kWidth; ++x) {
+                    uint8_t* p = src + x * srcPixelSize;
+                    for (int c = 0; c < srcPixelSize; ++c) {
+                        p[c] = SkToU8(x + c * 85);
+                    }
+                    if (4 == srcPixelSize) {
+                        p[3] = (opaqueRow && x < kWidth - 1) ? 0xFF : SkToU8(a);
+                    }
+                }
+                for (int width = 1; width <= kWidth; width += (width < 40 ? 1 : 37)) {
+                    bool expectedAlpha = gProcs[i].fPortable(expected, src, width,
+                                                             srcPixelSize, 0, NULL);
+                    bool actualAlpha = platformProc(actual, src, width, srcPixelSize, 0, NULL);
+                    SkASSERT(expectedAlpha == actualAlpha);
+                    SkASSERT(0 == memcmp(expected, actual, width * sizeof(SkPMColor)));
+                }
+            }
+        }
+    }
+}
 #endif // SK_DEBUG
@@ -49,6 +49,12 @@ public:
     // be called for one SkScaledBitmapSampler.
     bool sampleInterlaced(const uint8_t* SK_RESTRICT src, int srcY);
 
+    // Writes row dstY of the output from the given row of src pixels.
+    // Unlike next(), this does not change the sampler, so different rows
+    // may be sampled on different threads at the same time. Must not be
+    // mixed with next() for one SkScaledBitmapSampler.
+    bool sampleRow(const uint8_t* SK_RESTRICT src, int dstY) const;
+
     typedef bool (*RowProc)(void* SK_RESTRICT dstRow,
                             const uint8_t* SK_RESTRICT src,
                             int width, int deltaSrc, int y,
@@ -81,6 +87,9 @@ private:
     int     fCurrY; // used for dithering
     int     fSrcPixelSize;  // 1, 3, 4
     RowProc fRowProc;
+    // The proc rows are sampled with: fRowProc, or a platform version of it
+    // when every pixel of the row is sampled.
+    RowProc fSampleRowProc;
 
     // optional reference to the src colors if the src is a palette model
     const SkPMColor* fCTable;
@@ -6,6 +6,7 @@
  */
 
 #include "SkCachingPixelRef.h"
+#include "SkDecodingImageGenerator.h"
 #include "SkScaledImageCache.h"
 
 bool SkCachingPixelRef::Install(SkImageGenerator* generator,
@@ -24,11 +25,21 @@ bool SkCachingPixelRef::Install(SkImageGenerator* generator,
     return true;
 }
 
+bool SkCachingPixelRef::Install(SkDecodingImageGenerator* generator,
+                                SkBitmap* dst) {
+    if (!SkCachingPixelRef::Install(static_cast<SkImageGenerator*>(generator), dst)) {
+        return false;
+    }
+    static_cast<SkCachingPixelRef*>(dst->pixelRef())->fDecodingGenerator = generator;
+    return true;
+}
+
 SkCachingPixelRef::SkCachingPixelRef(const SkImageInfo& info,
                                      SkImageGenerator* generator,
                                      size_t rowBytes)
     : INHERITED(info)
     , fImageGenerator(generator)
+    , fDecodingGenerator(NULL)
     , fErrorInDecoding(false)
     , fScaledCacheId(NULL)
     , fRowBytes(rowBytes) {
@@ -95,3 +106,40 @@ void SkCachingPixelRef::onUnlockPixels() {
     SkScaledImageCache::Unlock( static_cast<SkScaledImageCache::ID*>(fScaledCacheId));
     fScaledCacheId = NULL;
 }
+
+bool SkCachingPixelRef::onImplementsDecodeInto() {
+    return fDecodingGenerator != NULL;
+}
+
+/**
+ *  SkBitmapProcState passes in the bitmap being drawn, rounded out to whole
+ *  samples, so its pixelRefOrigin() and size give the part of the image
+ *  that is needed.
+ */
+bool SkCachingPixelRef::onDecodeInto(int pow2, SkBitmap* bitmap) {
+    if (NULL == fDecodingGenerator || fErrorInDecoding) {
+        return false;
+    }
+    SkIRect subset = SkIRect::MakeXYWH(bitmap->pixelRefOrigin().fX,
+                                       bitmap->pixelRefOrigin().fY,
+                                       bitmap->width(), bitmap->height());
+    SkScalar scale = SkScalarInvert(SkIntToScalar(1 << pow2));
+
+    SkBitmap decoded;
+    SkScaledImageCache::ID* id;
+    {
+        // The generator shares its stream with getPixels(), which is
+        // called with this mutex held.
+        SkAutoMutexAcquire ac(this->mutex());
+        id = fDecodingGenerator->lockSubset(subset, scale, &decoded);
+    }
+    if (NULL == id) {
+        return false;
+    }
+    // The caller keeps decoded's pixels locked; that and its ref on the
+    // pixel ref keep them alive after the cache entry is unlocked.
+    *bitmap = decoded;
+    bitmap->lockPixels();
+    SkScaledImageCache::Unlock(id);
+    return bitmap->getPixels() != NULL;
+}
@@ -13,6 +13,7 @@
 #include "SkPixelRef.h"
 
 class SkColorTable;
+class SkDecodingImageGenerator;
 
 /**
  *  PixelRef which defers decoding until SkBitmap::lockPixels() is
@@ -21,6 +22,10 @@ class SkColorTable;
  *  or be destroyed before the next lock.  If so, onLockPixels will
  *  attempt to re-decode.
  *
+ *  If the cache is built with SK_USE_DISCARDABLE_SCALEDIMAGECACHE, the
+ *  pixels live in SkDiscardableMemory, and so count against whatever
+ *  budget that port keeps (which may be shared between processes).
+ *
  *  Decoding is handled by the SkImageGenerator
  */
 class SkCachingPixelRef : public SkPixelRef {
@@ -39,11 +44,21 @@ public:
      */
     static bool Install(SkImageGenerator* gen, SkBitmap* dst);
 
+    /**
+     *  Same as above, but the pixel ref also implements decodeInto(), so
+     *  that SkBitmapProcState can have a downscaled draw decode only the
+     *  part of the image it needs, at the nearest power of two scale (see
+     *  SkDecodingImageGenerator::lockSubset()).
+     */
+    static bool Install(SkDecodingImageGenerator* gen, SkBitmap* dst);
+
 protected:
     virtual ~SkCachingPixelRef();
     virtual bool onNewLockPixels(LockRec*) SK_OVERRIDE;
     virtual void onUnlockPixels() SK_OVERRIDE;
     virtual bool onLockPixelsAreWritable() const SK_OVERRIDE { return false; }
+    virtual bool onImplementsDecodeInto() SK_OVERRIDE;
+    virtual bool onDecodeInto(int pow2, SkBitmap* bitmap) SK_OVERRIDE;
 
     virtual SkData* onRefEncodedData() SK_OVERRIDE {
         return fImageGenerator->refEncodedData();
@@ -57,6 +72,8 @@ protected:
 
 private:
     SkImageGenerator* const fImageGenerator;
+    // Same object as fImageGenerator, if it was installed as one.
+    SkDecodingImageGenerator* fDecodingGenerator;
     bool                    fErrorInDecoding;
     void*                   fScaledCacheId;
     const size_t            fRowBytes;
@@ -0,0 +1,317 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapFilter_opts_AVX2.h"
+
+#include <immintrin.h>
+
+// These follow convolveHorizontally_SSE2 and friends closely; see those for
+// more detailed comments. The integer math is the same, so the results are
+// identical.
+
+// Loads 8 filter coefficients and splats them for accumulate8(): lane 0 of
+// |coeff01| is [16] c1 c1 c1 c1 c0 c0 c0 c0 and lane 1 is the same with c5
+// and c4. |coeff23| holds c3 and c2, and c7 and c6.
+static inline void load_coefficients8(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                                      __m256i* coeff01, __m256i* coeff23) {
+    // [16] c7 c6 c5 c4 c3 c2 c1 c0
+    __m128i coeff = _mm_loadu_si128(reinterpret_cast<const __m128i*>(filter_values));
+    // [16] c7 c6 c5 c4 c7 c6 c5 c4 | c3 c2 c1 c0 c3 c2 c1 c0
+    __m256i coeff2 = _mm256_permute4x64_epi64(_mm256_castsi128_si256(coeff),
+                                              _MM_SHUFFLE(1, 1, 0, 0));
+    *coeff01 = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(coeff2, _MM_SHUFFLE(0, 0, 0, 0)),
+                                      _MM_SHUFFLE(1, 1, 1, 1));
+    *coeff23 = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(coeff2, _MM_SHUFFLE(2, 2, 2, 2)),
+                                      _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+// Multiplies 8 pixels with their coefficients and adds the products to
+// |accum|, which holds 32 bits per channel of one pixel in each lane: lane 0
+// sums pixels 0-3 and lane 1 sums pixels 4-7.
+static inline __m256i accumulate8(const unsigned char* src,
+                                  __m256i coeff01, __m256i coeff23,
+                                  __m256i accum) {
+    const __m256i zero = _mm256_setzero_si256();
+
+    // [8] p7 p6 p5 p4 | p3 p2 p1 p0
+    __m256i src8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+
+    // [16] p5 p4 | p1 p0
+    __m256i src16 = _mm256_unpacklo_epi8(src8, zero);
+    __m256i mul_hi = _mm256_mulhi_epi16(src16, coeff01);
+    __m256i mul_lo = _mm256_mullo_epi16(src16, coeff01);
+    accum = _mm256_add_epi32(accum, _mm256_unpacklo_epi16(mul_lo, mul_hi));
+    accum = _mm256_add_epi32(accum, _mm256_unpackhi_epi16(mul_lo, mul_hi));
+
+    // [16] p7 p6 | p3 p2
+    src16 = _mm256_unpackhi_epi8(src8, zero);
+    mul_hi = _mm256_mulhi_epi16(src16, coeff23);
+    mul_lo = _mm256_mullo_epi16(src16, coeff23);
+    accum = _mm256_add_epi32(accum, _mm256_unpacklo_epi16(mul_lo, mul_hi));
+    accum = _mm256_add_epi32(accum, _mm256_unpackhi_epi16(mul_lo, mul_hi));
+    return accum;
+}
+
+// The 4 coefficient version of accumulate8(), for the last taps of a filter.
+// |coeff| holds the coefficients in its low 64 bits.
+static inline __m128i accumulate4(const unsigned char* src, __m128i coeff,
+                                  __m128i accum) {
+    const __m128i zero = _mm_setzero_si128();
+
+    // [16] c1 c1 c1 c1 c0 c0 c0 c0
+    __m128i coeff16 = _mm_shufflelo_epi16(coeff, _MM_SHUFFLE(1, 1, 0, 0));
+    coeff16 = _mm_unpacklo_epi16(coeff16, coeff16);
+
+    // [8] p3 p2 p1 p0
+    __m128i src8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i src16 = _mm_unpacklo_epi8(src8, zero);
+    __m128i mul_hi = _mm_mulhi_epi16(src16, coeff16);
+    __m128i mul_lo = _mm_mullo_epi16(src16, coeff16);
+    accum = _mm_add_epi32(accum, _mm_unpacklo_epi16(mul_lo, mul_hi));
+    accum = _mm_add_epi32(accum, _mm_unpackhi_epi16(mul_lo, mul_hi));
+
+    // [16] c3 c3 c3 c3 c2 c2 c2 c2
+    coeff16 = _mm_shufflelo_epi16(coeff, _MM_SHUFFLE(3, 3, 2, 2));
+    coeff16 = _mm_unpacklo_epi16(coeff16, coeff16);
+    src16 = _mm_unpackhi_epi8(src8, zero);
+    mul_hi = _mm_mulhi_epi16(src16, coeff16);
+    mul_lo = _mm_mullo_epi16(src16, coeff16);
+    accum = _mm_add_epi32(accum, _mm_unpacklo_epi16(mul_lo, mul_hi));
+    accum = _mm_add_epi32(accum, _mm_unpackhi_epi16(mul_lo, mul_hi));
+    return accum;
+}
+
+static inline __m128i add_lanes(__m256i accum) {
+    return _mm_add_epi32(_mm256_castsi256_si128(accum),
+                         _mm256_extracti128_si256(accum, 1));
+}
+
+// Loads the (up to 4) coefficients left after |filter_x|, masking out the
+// ones past the end of the filter.
+// Note: filter_values must be padded (see applySIMDPadding_SSE2).
+static inline __m128i load_last_coefficients(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                                             int remaining) {
+    static const int16_t kMasks[4][4] = {
+        {  0,  0,  0,  0 },
+        { -1,  0,  0,  0 },
+        { -1, -1,  0,  0 },
+        { -1, -1, -1,  0 },
+    };
+    __m128i coeff = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(filter_values));
+    if (remaining < 4) {
+        __m128i mask = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(kMasks[remaining]));
+        coeff = _mm_and_si128(coeff, mask);
+    }
+    return coeff;
+}
+
+static inline int pack_pixel(__m128i accum) {
+    const __m128i zero = _mm_setzero_si128();
+    accum = _mm_srai_epi32(accum, SkConvolutionFilter1D::kShiftBits);
+    accum = _mm_packs_epi32(accum, zero);
+    accum = _mm_packus_epi16(accum, zero);
+    return _mm_cvtsi128_si32(accum);
+}
+
+void convolveHorizontally_AVX2(const unsigned char* src_data,
+                               const SkConvolutionFilter1D& filter,
+                               unsigned char* out_row,
+                               bool /*has_alpha*/) {
+    int num_values = filter.numValues();
+    int filter_offset, filter_length;
+
+    // Output one pixel each iteration, calculating all channels (RGBA) together.
+    for (int out_x = 0; out_x < num_values; out_x++) {
+        const SkConvolutionFilter1D::ConvolutionFixed* filter_values =
+            filter.FilterForValue(out_x, &filter_offset, &filter_length);
+        const unsigned char* row_to_filter = &src_data[filter_offset << 2];
+
+        // Eight coefficients per iteration.
+        __m256i accum8 = _mm256_setzero_si256();
+        int filter_x = 0;
+        for (; filter_x + 8 <= filter_length; filter_x += 8) {
+            __m256i coeff01, coeff23;
+            load_coefficients8(filter_values + filter_x, &coeff01, &coeff23);
+            accum8 = accumulate8(row_to_filter + (filter_x << 2), coeff01, coeff23, accum8);
+        }
+        __m128i accum = add_lanes(accum8);
+
+        // Then up to two steps of four. The last one may load up to 3 pixels
+        // past the end of the filter, like the SSE2 version.
+        for (; filter_x < filter_length; filter_x += 4) {
+            __m128i coeff = load_last_coefficients(filter_values + filter_x,
+                                                   filter_length - filter_x);
+            accum = accumulate4(row_to_filter + (filter_x << 2), coeff, accum);
+        }
+
+        *(reinterpret_cast<int*>(out_row)) = pack_pixel(accum);
+        out_row += 4;
+    }
+}
+
+void convolve4RowsHorizontally_AVX2(const unsigned char* src_data[4],
+                                    const SkConvolutionFilter1D& filter,
+                                    unsigned char* out_row[4]) {
+    int num_values = filter.numValues();
+    int filter_offset, filter_length;
+
+    // Output one pixel of each row per iteration.
+    for (int out_x = 0; out_x < num_values; out_x++) {
+        const SkConvolutionFilter1D::ConvolutionFixed* filter_values =
+            filter.FilterForValue(out_x, &filter_offset, &filter_length);
+        int start = filter_offset << 2;
+
+        __m256i accum8_0 = _mm256_setzero_si256();
+        __m256i accum8_1 = _mm256_setzero_si256();
+        __m256i accum8_2 = _mm256_setzero_si256();
+        __m256i accum8_3 = _mm256_setzero_si256();
+        int filter_x = 0;
+        for (; filter_x + 8 <= filter_length; filter_x += 8) {
+            __m256i coeff01, coeff23;
+            load_coefficients8(filter_values + filter_x, &coeff01, &coeff23);
+            accum8_0 = accumulate8(src_data[0] + start, coeff01, coeff23, accum8_0);
+            accum8_1 = accumulate8(src_data[1] + start, coeff01, coeff23, accum8_1);
+            accum8_2 = accumulate8(src_data[2] + start, coeff01, coeff23, accum8_2);
+            accum8_3 = accumulate8(src_data[3] + start, coeff01, coeff23, accum8_3);
+            start += 32;
+        }
+        __m128i accum0 = add_lanes(accum8_0);
+        __m128i accum1 = add_lanes(accum8_1);
+        __m128i accum2 = add_lanes(accum8_2);
+        __m128i accum3 = add_lanes(accum8_3);
+
+        for (; filter_x < filter_length; filter_x += 4) {
+            __m128i coeff = load_last_coefficients(filter_values + filter_x,
+                                                   filter_length - filter_x);
+            accum0 = accumulate4(src_data[0] + start, coeff, accum0);
+            accum1 = accumulate4(src_data[1] + start, coeff, accum1);
+            accum2 = accumulate4(src_data[2] + start, coeff, accum2);
+            accum3 = accumulate4(src_data[3] + start, coeff, accum3);
+            start += 16;
+        }
+
+        *(reinterpret_cast<int*>(out_row[0])) = pack_pixel(accum0);
+        *(reinterpret_cast<int*>(out_row[1])) = pack_pixel(accum1);
+        *(reinterpret_cast<int*>(out_row[2])) = pack_pixel(accum2);
+        *(reinterpret_cast<int*>(out_row[3])) = pack_pixel(accum3);
+
+        out_row[0] += 4;
+        out_row[1] += 4;
+        out_row[2] += 4;
+        out_row[3] += 4;
+    }
+}
+
+// Vertically convolves the 8 pixels starting at |byte_offset| in each row.
+template<bool has_alpha>
+static inline __m256i convolveVertically8(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                                          int filter_length,
+                                          unsigned char* const* source_data_rows,
+                                          int byte_offset) {
+    const __m256i zero = _mm256_setzero_si256();
+
+    // [32] per channel. Because unpacking works within lanes, accum0 holds
+    // pixels 0 and 4, accum1 pixels 1 and 5, and so on.
+    __m256i accum0 = _mm256_setzero_si256();
+    __m256i accum1 = _mm256_setzero_si256();
+    __m256i accum2 = _mm256_setzero_si256();
+    __m256i accum3 = _mm256_setzero_si256();
+
+    for (int filter_y = 0; filter_y < filter_length; filter_y++) {
+        __m256i coeff16 = _mm256_set1_epi16(filter_values[filter_y]);
+        __m256i src8 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+            &source_data_rows[filter_y][byte_offset]));
+
+        // [16] p5 p4 | p1 p0
+        __m256i src16 = _mm256_unpacklo_epi8(src8, zero);
+        __m256i mul_hi = _mm256_mulhi_epi16(src16, coeff16);
+        __m256i mul_lo = _mm256_mullo_epi16(src16, coeff16);
+        accum0 = _mm256_add_epi32(accum0, _mm256_unpacklo_epi16(mul_lo, mul_hi));
+        accum1 = _mm256_add_epi32(accum1, _mm256_unpackhi_epi16(mul_lo, mul_hi));
+
+        // [16] p7 p6 | p3 p2
+        src16 = _mm256_unpackhi_epi8(src8, zero);
+        mul_hi = _mm256_mulhi_epi16(src16, coeff16);
+        mul_lo = _mm256_mullo_epi16(src16, coeff16);
+        accum2 = _mm256_add_epi32(accum2, _mm256_unpacklo_epi16(mul_lo, mul_hi));
+        accum3 = _mm256_add_epi32(accum3, _mm256_unpackhi_epi16(mul_lo, mul_hi));
+    }
+
+    accum0 = _mm256_srai_epi32(accum0, SkConvolutionFilter1D::kShiftBits);
+    accum1 = _mm256_srai_epi32(accum1, SkConvolutionFilter1D::kShiftBits);
+    accum2 = _mm256_srai_epi32(accum2, SkConvolutionFilter1D::kShiftBits);
+    accum3 = _mm256_srai_epi32(accum3, SkConvolutionFilter1D::kShiftBits);
+
+    // The packs also work within lanes, which puts the pixels back in order:
+    // [8] p7 p6 p5 p4 | p3 p2 p1 p0
+    accum0 = _mm256_packs_epi32(accum0, accum1);
+    accum2 = _mm256_packs_epi32(accum2, accum3);
+    accum0 = _mm256_packus_epi16(accum0, accum2);
+
+    if (has_alpha) {
+        // Make sure the alpha channel is never smaller than any of the
+        // color channels.
+        __m256i a = _mm256_srli_epi32(accum0, 8);
+        __m256i b = _mm256_max_epu8(a, accum0);
+        a = _mm256_srli_epi32(accum0, 16);
+        b = _mm256_max_epu8(a, b);
+        b = _mm256_slli_epi32(b, 24);
+        accum0 = _mm256_max_epu8(b, accum0);
+    } else {
+        accum0 = _mm256_or_si256(accum0, _mm256_set1_epi32(0xff000000));
+    }
+    return accum0;
+}
+
+template<bool has_alpha>
+static void convolveVertically_AVX2(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                                    int filter_length,
+                                    unsigned char* const* source_data_rows,
+                                    int pixel_width,
+                                    unsigned char* out_row) {
+    int width = pixel_width & ~7;
+
+    // Output eight pixels per iteration (32 bytes).
+    for (int out_x = 0; out_x < width; out_x += 8) {
+        __m256i result = convolveVertically8<has_alpha>(filter_values, filter_length,
+                                                        source_data_rows, out_x << 2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out_row), result);
+        out_row += 32;
+    }
+
+    // The rows of the convolver's row buffer are padded to 16 pixels, so the
+    // last few pixels can be computed as a group of eight as well; only the
+    // store has to be cut short.
+    if (pixel_width & 7) {
+        uint32_t pixels[8];
+        __m256i result = convolveVertically8<has_alpha>(filter_values, filter_length,
+                                                        source_data_rows, width << 2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels), result);
+        memcpy(out_row, pixels, (pixel_width & 7) << 2);
+    }
+}
+
+void convolveVertically_AVX2(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row,
+                             bool has_alpha) {
+    if (has_alpha) {
+        convolveVertically_AVX2<true>(filter_values,
+                                      filter_length,
+                                      source_data_rows,
+                                      pixel_width,
+                                      out_row);
+    } else {
+        convolveVertically_AVX2<false>(filter_values,
+                                       filter_length,
+                                       source_data_rows,
+                                       pixel_width,
+                                       out_row);
+    }
+}
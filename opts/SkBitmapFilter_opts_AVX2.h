@@ -0,0 +1,33 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBitmapFilter_opts_AVX2_DEFINED
+#define SkBitmapFilter_opts_AVX2_DEFINED
+
+#include "SkConvolver.h"
+
+// These procs are only selected (by opts_check_SSE2.cpp) when the CPU and OS
+// report AVX2 support. Their implementation file must be compiled with -mavx2.
+// They give the same results as the _SSE2 versions, make the same extra
+// reads (so they also use applySIMDPadding_SSE2), and work on twice as many
+// filter taps or pixels at a time.
+
+void convolveVertically_AVX2(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row,
+                             bool has_alpha);
+void convolve4RowsHorizontally_AVX2(const unsigned char* src_data[4],
+                                    const SkConvolutionFilter1D& filter,
+                                    unsigned char* out_row[4]);
+void convolveHorizontally_AVX2(const unsigned char* src_data,
+                               const SkConvolutionFilter1D& filter,
+                               unsigned char* out_row,
+                               bool has_alpha);
+
+#endif
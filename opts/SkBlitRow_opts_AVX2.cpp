@@ -0,0 +1,254 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBlitRow_opts_AVX2.h"
+#include "SkColorPriv.h"
+#include "SkColor_opts_AVX2.h"
+#include "SkUtils.h"
+
+#include <immintrin.h>
+
+/* These are the SSE2 procs from SkBlitRow_opts_SSE2.cpp widened to eight
+ * pixels per iteration. Each one aligns dst to 32 bytes with the portable
+ * per-pixel math, so results match the SSE2 and C versions exactly.
+ */
+
+/* AVX2 version of S32_Blend_BlitRow32()
+ * portable version is in core/SkBlitRow_D32.cpp
+ */
+void S32_Blend_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                              const SkPMColor* SK_RESTRICT src,
+                              int count, U8CPU alpha) {
+    SkASSERT(alpha <= 255);
+    if (count <= 0) {
+        return;
+    }
+
+    uint32_t src_scale = SkAlpha255To256(alpha);
+    uint32_t dst_scale = 256 - src_scale;
+
+    if (count >= 8) {
+        SkASSERT(((size_t)dst & 0x03) == 0);
+        while (((size_t)dst & 0x1F) != 0) {
+            *dst = SkAlphaMulQ(*src, src_scale) + SkAlphaMulQ(*dst, dst_scale);
+            src++;
+            dst++;
+            count--;
+        }
+
+        const __m256i* s = reinterpret_cast<const __m256i*>(src);
+        __m256i* d = reinterpret_cast<__m256i*>(dst);
+        __m256i src_scale_wide = _mm256_set1_epi16(src_scale);
+        __m256i dst_scale_wide = _mm256_set1_epi16(dst_scale);
+        while (count >= 8) {
+            __m256i src_pixel = _mm256_loadu_si256(s);
+            __m256i dst_pixel = _mm256_load_si256(d);
+
+            src_pixel = SkAlphaMulQ_AVX2(src_pixel, src_scale_wide);
+            dst_pixel = SkAlphaMulQ_AVX2(dst_pixel, dst_scale_wide);
+
+            _mm256_store_si256(d, _mm256_add_epi8(src_pixel, dst_pixel));
+            s++;
+            d++;
+            count -= 8;
+        }
+        src = reinterpret_cast<const SkPMColor*>(s);
+        dst = reinterpret_cast<SkPMColor*>(d);
+    }
+
+    while (count > 0) {
+        *dst = SkAlphaMulQ(*src, src_scale) + SkAlphaMulQ(*dst, dst_scale);
+        src++;
+        dst++;
+        count--;
+    }
+}
+
+void S32A_Opaque_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                                const SkPMColor* SK_RESTRICT src,
+                                int count, U8CPU alpha) {
+    SkASSERT(alpha == 255);
+    if (count <= 0) {
+        return;
+    }
+
+    if (count >= 8) {
+        SkASSERT(((size_t)dst & 0x03) == 0);
+        while (((size_t)dst & 0x1F) != 0) {
+            *dst = SkPMSrcOver(*src, *dst);
+            src++;
+            dst++;
+            count--;
+        }
+
+        const __m256i* s = reinterpret_cast<const __m256i*>(src);
+        __m256i* d = reinterpret_cast<__m256i*>(dst);
+        __m256i alpha_mask = _mm256_set1_epi32(0xFF000000);
+#ifdef SK_USE_ACCURATE_BLENDING
+        __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+        __m256i c_128 = _mm256_set1_epi16(128);
+        __m256i c_255 = _mm256_set1_epi16(255);
+#endif
+        while (count >= 8) {
+            __m256i src_pixel = _mm256_loadu_si256(s);
+
+            // Runs of fully opaque or fully transparent sources are common
+            // (sprites, glyph backgrounds) and need no blending at all.
+            __m256i src_alpha = _mm256_and_si256(src_pixel, alpha_mask);
+            if (-1 == _mm256_movemask_epi8(_mm256_cmpeq_epi32(src_alpha, alpha_mask))) {
+                _mm256_store_si256(d, src_pixel);
+            } else if (!_mm256_testz_si256(src_pixel, src_pixel)) {
+                __m256i dst_pixel = _mm256_load_si256(d);
+#ifdef SK_USE_ACCURATE_BLENDING
+                __m256i dst_rb = _mm256_and_si256(rb_mask, dst_pixel);
+                __m256i dst_ag = _mm256_srli_epi16(dst_pixel, 8);
+
+                // Subtract alphas from 255, to get 0..255
+                __m256i scale = _mm256_sub_epi16(c_255, SkGetPackedA32x2_AVX2(src_pixel));
+
+                dst_rb = _mm256_mullo_epi16(dst_rb, scale);
+                dst_ag = _mm256_mullo_epi16(dst_ag, scale);
+
+                // dst_rb = (dst_rb + (dst_rb >> 8) + 128) >> 8
+                dst_rb = _mm256_add_epi16(dst_rb, _mm256_srli_epi16(dst_rb, 8));
+                dst_rb = _mm256_srli_epi16(_mm256_add_epi16(dst_rb, c_128), 8);
+
+                // dst_ag = (dst_ag + (dst_ag >> 8) + 128) & ag_mask
+                dst_ag = _mm256_add_epi16(dst_ag, _mm256_srli_epi16(dst_ag, 8));
+                dst_ag = _mm256_andnot_si256(rb_mask, _mm256_add_epi16(dst_ag, c_128));
+
+                dst_pixel = _mm256_add_epi8(src_pixel, _mm256_or_si256(dst_rb, dst_ag));
+#else
+                dst_pixel = SkPMSrcOver_AVX2(src_pixel, dst_pixel);
+#endif
+                _mm256_store_si256(d, dst_pixel);
+            }
+            s++;
+            d++;
+            count -= 8;
+        }
+        src = reinterpret_cast<const SkPMColor*>(s);
+        dst = reinterpret_cast<SkPMColor*>(d);
+    }
+
+    while (count > 0) {
+        *dst = SkPMSrcOver(*src, *dst);
+        src++;
+        dst++;
+        count--;
+    }
+}
+
+void S32A_Blend_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                               const SkPMColor* SK_RESTRICT src,
+                               int count, U8CPU alpha) {
+    SkASSERT(alpha <= 255);
+    if (count <= 0) {
+        return;
+    }
+
+    if (count >= 8) {
+        while (((size_t)dst & 0x1F) != 0) {
+            *dst = SkBlendARGB32(*src, *dst, alpha);
+            src++;
+            dst++;
+            count--;
+        }
+
+        uint32_t src_scale = SkAlpha255To256(alpha);
+
+        const __m256i* s = reinterpret_cast<const __m256i*>(src);
+        __m256i* d = reinterpret_cast<__m256i*>(dst);
+        __m256i src_scale_wide = _mm256_set1_epi16(src_scale << 8);
+        __m256i c_256 = _mm256_set1_epi16(256);
+        while (count >= 8) {
+            __m256i src_pixel = _mm256_loadu_si256(s);
+            __m256i dst_pixel = _mm256_load_si256(d);
+
+            // The per-pixel source alpha is scaled by the global alpha first;
+            // src_scale sits in the high byte of each word, so mulhi leaves
+            // the product already divided by 256.
+            __m256i dst_scale = _mm256_mulhi_epu16(SkGetPackedA32x2_AVX2(src_pixel),
+                                                   src_scale_wide);
+            dst_scale = _mm256_sub_epi16(c_256, dst_scale);
+
+            src_pixel = SkAlphaMulQ_AVX2(src_pixel, _mm256_set1_epi16(src_scale));
+            dst_pixel = SkAlphaMulQ_AVX2(dst_pixel, dst_scale);
+
+            _mm256_store_si256(d, _mm256_add_epi8(src_pixel, dst_pixel));
+            s++;
+            d++;
+            count -= 8;
+        }
+        src = reinterpret_cast<const SkPMColor*>(s);
+        dst = reinterpret_cast<SkPMColor*>(d);
+    }
+
+    while (count > 0) {
+        *dst = SkBlendARGB32(*src, *dst, alpha);
+        src++;
+        dst++;
+        count--;
+    }
+}
+
+/* AVX2 version of Color32()
+ * portable version is in core/SkBlitRow_D32.cpp
+ */
+void Color32_AVX2(SkPMColor dst[], const SkPMColor src[], int count,
+                  SkPMColor color) {
+    if (count <= 0) {
+        return;
+    }
+
+    if (0 == color) {
+        if (src != dst) {
+            memcpy(dst, src, count * sizeof(SkPMColor));
+        }
+        return;
+    }
+
+    unsigned colorA = SkGetPackedA32(color);
+    if (255 == colorA) {
+        sk_memset32(dst, color, count);
+        return;
+    }
+
+    unsigned scale = 256 - SkAlpha255To256(colorA);
+
+    if (count >= 8) {
+        SkASSERT(((size_t)dst & 0x03) == 0);
+        while (((size_t)dst & 0x1F) != 0) {
+            *dst = color + SkAlphaMulQ(*src, scale);
+            src++;
+            dst++;
+            count--;
+        }
+
+        const __m256i* s = reinterpret_cast<const __m256i*>(src);
+        __m256i* d = reinterpret_cast<__m256i*>(dst);
+        __m256i scale_wide = _mm256_set1_epi16(scale);
+        __m256i color_wide = _mm256_set1_epi32(color);
+        while (count >= 8) {
+            __m256i src_pixel = _mm256_loadu_si256(s);
+            src_pixel = SkAlphaMulQ_AVX2(src_pixel, scale_wide);
+            _mm256_store_si256(d, _mm256_add_epi8(color_wide, src_pixel));
+            s++;
+            d++;
+            count -= 8;
+        }
+        src = reinterpret_cast<const SkPMColor*>(s);
+        dst = reinterpret_cast<SkPMColor*>(d);
+    }
+
+    while (count > 0) {
+        *dst = color + SkAlphaMulQ(*src, scale);
+        src++;
+        dst++;
+        count--;
+    }
+}
@@ -10,8 +10,12 @@
 
 #include "SkColorPriv.h"
 
-typedef void (*SkBoxBlurProc)(const SkPMColor* src, int srcStride, SkPMColor* dst, int kernelSize,
-                              int leftOffset, int rightOffset, int width, int height);
+// Blurs height rows of width pixels each. The strides are in pixels, between
+// consecutive rows of src and dst; for a transposing proc the dst "rows" are
+// its columns.
+typedef void (*SkBoxBlurProc)(const SkPMColor* src, int srcStride, SkPMColor* dst, int dstStride,
+                              int kernelSize, int leftOffset, int rightOffset,
+                              int width, int height);
 
 bool SkBoxBlurGetPlatformProcs(SkBoxBlurProc* boxBlurX,
                                SkBoxBlurProc* boxBlurY,
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkColor_opts_AVX2_DEFINED
+#define SkColor_opts_AVX2_DEFINED
+
+#include <immintrin.h>
+
+// Helpers operating on eight SkPMColors packed in a __m256i. Like the SSE2
+// procs, these assume alpha lives in the top byte of each pixel.
+
+// Returns each pixel's alpha in both 16-bit halves of its 32-bit lane, which
+// is the layout the rb and ag multiplies below expect.
+static inline __m256i SkGetPackedA32x2_AVX2(__m256i c) {
+    __m256i a = _mm256_srli_epi32(c, 24);
+    return _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+}
+
+// Vector form of SkAlphaMulQ(): scale holds a 0..256 factor in every word.
+static inline __m256i SkAlphaMulQ_AVX2(__m256i c, __m256i scale) {
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+
+    __m256i rb = _mm256_and_si256(rb_mask, c);
+    __m256i ag = _mm256_srli_epi16(c, 8);
+
+    rb = _mm256_srli_epi16(_mm256_mullo_epi16(rb, scale), 8);
+    ag = _mm256_andnot_si256(rb_mask, _mm256_mullo_epi16(ag, scale));
+
+    return _mm256_or_si256(rb, ag);
+}
+
+// Vector form of SkPMSrcOver().
+static inline __m256i SkPMSrcOver_AVX2(__m256i src, __m256i dst) {
+    __m256i scale = _mm256_sub_epi16(_mm256_set1_epi16(256),
+                                     SkGetPackedA32x2_AVX2(src));
+    return _mm256_add_epi8(src, SkAlphaMulQ_AVX2(dst, scale));
+}
+
+// Vector form of SkMulDiv255Round() on unpacked 16-bit channels.
+static inline __m256i SkMulDiv255Round16_AVX2(__m256i a, __m256i b) {
+    __m256i prod = _mm256_add_epi16(_mm256_mullo_epi16(a, b),
+                                    _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(prod, _mm256_srli_epi16(prod, 8)), 8);
+}
+
+// Converts eight pixels whose bytes are R, G, B, A in memory to SkPMColors.
+static inline __m256i SkRGBAToPMColor_AVX2(__m256i rgba) {
+#if SK_PMCOLOR_BYTE_ORDER(R,G,B,A)
+    return rgba;
+#else
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    __m256i r = _mm256_and_si256(rgba, mask);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(rgba, 8), mask);
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(rgba, 16), mask);
+    __m256i a = _mm256_srli_epi32(rgba, 24);
+    return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(r, SK_R32_SHIFT),
+                                           _mm256_slli_epi32(g, SK_G32_SHIFT)),
+                           _mm256_or_si256(_mm256_slli_epi32(b, SK_B32_SHIFT),
+                                           _mm256_slli_epi32(a, SK_A32_SHIFT)));
+#endif
+}
+
+#endif//SkColor_opts_AVX2_DEFINED
@@ -28,4 +28,21 @@ static inline __m128i SkPackRGB16_SSE(__m128i r, __m128i g, __m128i b) {
     return _mm_or_si128(c, b);
 }
 
+// Converts four pixels whose bytes are R, G, B, A in memory to SkPMColors.
+static inline __m128i SkRGBAToPMColor_SSE(__m128i rgba) {
+#if SK_PMCOLOR_BYTE_ORDER(R,G,B,A)
+    return rgba;
+#else
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    __m128i r = _mm_and_si128(rgba, mask);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(rgba, 8), mask);
+    __m128i b = _mm_and_si128(_mm_srli_epi32(rgba, 16), mask);
+    __m128i a = _mm_srli_epi32(rgba, 24);
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, SK_R32_SHIFT),
+                                     _mm_slli_epi32(g, SK_G32_SHIFT)),
+                        _mm_or_si128(_mm_slli_epi32(b, SK_B32_SHIFT),
+                                     _mm_slli_epi32(a, SK_A32_SHIFT)));
+#endif
+}
+
 #endif//SkColor_opts_SSE2_DEFINED
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMipMap_opts_DEFINED
+#define SkMipMap_opts_DEFINED
+
+#include "SkTypes.h"
+
+enum SkMipMapProcType {
+    k8888_SkMipMapProcType,
+    k565_SkMipMapProcType,
+    k4444_SkMipMapProcType
+};
+
+/**
+ *  Downsamples by 2 into a row of count dst pixels: each component of pixel x
+ *  is the sum of that component of pixels 2x and 2x+1 in both src rows,
+ *  divided by 4 (rounding down). Returns how many leading dst pixels were
+ *  written, which may be less than count; SkMipMap finishes the rest.
+ */
+typedef int (*SkDownsampleRowProc)(void* dst, const void* src0, const void* src1,
+                                   int count);
+
+/**
+ *  Returns the platform's row proc for the given config, or NULL.
+ */
+SkDownsampleRowProc SkMipMapGetPlatformProc(SkMipMapProcType);
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkMipMap_opts_SSE2.h"
+#include "SkColorPriv.h"
+
+#include <emmintrin.h>
+
+/* SSE2 versions of the mipmap downsampling row procs.
+ * portable versions are in src/core/SkMipMap.cpp.
+ */
+
+// Returns the per-component sums of each pair of pixels in the two rows, as
+// 16 bit lanes: pixels 0+1 in the low half and pixels 2+3 in the high half.
+static inline __m128i sum_pairs_8888(const __m128i& row0, const __m128i& row1) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero),
+                               _mm_unpacklo_epi8(row1, zero));
+    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero),
+                               _mm_unpackhi_epi8(row1, zero));
+    return _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+}
+
+int SkDownsampleRow32_SSE2(void* dst, const void* src0, const void* src1, int count) {
+    const __m128i* s0 = static_cast<const __m128i*>(src0);
+    const __m128i* s1 = static_cast<const __m128i*>(src1);
+    __m128i* d = static_cast<__m128i*>(dst);
+
+    const int n = count >> 2;
+    for (int i = 0; i < n; ++i) {
+        __m128i lo = sum_pairs_8888(_mm_loadu_si128(s0), _mm_loadu_si128(s1));
+        __m128i hi = sum_pairs_8888(_mm_loadu_si128(s0 + 1), _mm_loadu_si128(s1 + 1));
+        _mm_storeu_si128(d, _mm_packus_epi16(_mm_srli_epi16(lo, 2), _mm_srli_epi16(hi, 2)));
+        s0 += 2;
+        s1 += 2;
+        d += 1;
+    }
+    return n << 2;
+}
+
+// Returns the average of the component at shift for 8 dst pixels, from 16
+// pixels in each row, shifted back into place.
+static inline __m128i average_component_16(const __m128i row0[2], const __m128i row1[2],
+                                           int shift, unsigned mask) {
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i m = _mm_set1_epi16(mask);
+    __m128i sums[2];
+    for (int i = 0; i < 2; ++i) {
+        // madd sums each pair of (small, so positive) 16 bit lanes into 32.
+        __m128i a = _mm_and_si128(_mm_srli_epi16(row0[i], shift), m);
+        __m128i b = _mm_and_si128(_mm_srli_epi16(row1[i], shift), m);
+        sums[i] = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(a, ones),
+                                               _mm_madd_epi16(b, ones)), 2);
+    }
+    return _mm_slli_epi16(_mm_packs_epi32(sums[0], sums[1]), shift);
+}
+
+static inline void load_16(const __m128i* src, __m128i row[2]) {
+    row[0] = _mm_loadu_si128(src);
+    row[1] = _mm_loadu_si128(src + 1);
+}
+
+int SkDownsampleRow565_SSE2(void* dst, const void* src0, const void* src1, int count) {
+    const __m128i* s0 = static_cast<const __m128i*>(src0);
+    const __m128i* s1 = static_cast<const __m128i*>(src1);
+    __m128i* d = static_cast<__m128i*>(dst);
+
+    const int n = count >> 3;
+    for (int i = 0; i < n; ++i) {
+        __m128i row0[2], row1[2];
+        load_16(s0, row0);
+        load_16(s1, row1);
+        __m128i c = average_component_16(row0, row1, SK_R16_SHIFT, SK_R16_MASK);
+        c = _mm_or_si128(c, average_component_16(row0, row1, SK_G16_SHIFT, SK_G16_MASK));
+        c = _mm_or_si128(c, average_component_16(row0, row1, SK_B16_SHIFT, SK_B16_MASK));
+        _mm_storeu_si128(d, c);
+        s0 += 2;
+        s1 += 2;
+        d += 1;
+    }
+    return n << 3;
+}
+
+int SkDownsampleRow4444_SSE2(void* dst, const void* src0, const void* src1, int count) {
+    const __m128i* s0 = static_cast<const __m128i*>(src0);
+    const __m128i* s1 = static_cast<const __m128i*>(src1);
+    __m128i* d = static_cast<__m128i*>(dst);
+
+    const int n = count >> 3;
+    for (int i = 0; i < n; ++i) {
+        __m128i row0[2], row1[2];
+        load_16(s0, row0);
+        load_16(s1, row1);
+        __m128i c = average_component_16(row0, row1, SK_A4444_SHIFT, 0xF);
+        c = _mm_or_si128(c, average_component_16(row0, row1, SK_R4444_SHIFT, 0xF));
+        c = _mm_or_si128(c, average_component_16(row0, row1, SK_G4444_SHIFT, 0xF));
+        c = _mm_or_si128(c, average_component_16(row0, row1, SK_B4444_SHIFT, 0xF));
+        _mm_storeu_si128(d, c);
+        s0 += 2;
+        s1 += 2;
+        d += 1;
+    }
+    return n << 3;
+}
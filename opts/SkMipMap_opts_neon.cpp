@@ -0,0 +1,90 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkMipMap_opts_neon.h"
+#include "SkColorPriv.h"
+
+#include <arm_neon.h>
+
+/* neon versions of the mipmap downsampling row procs.
+ * portable versions are in src/core/SkMipMap.cpp.
+ */
+
+int SkDownsampleRow32_neon(void* dst, const void* src0, const void* src1, int count) {
+    const uint8_t* s0 = static_cast<const uint8_t*>(src0);
+    const uint8_t* s1 = static_cast<const uint8_t*>(src1);
+    uint8_t* d = static_cast<uint8_t*>(dst);
+
+    const int n = count >> 3;
+    for (int i = 0; i < n; ++i) {
+        // 16 pixels from each row, one component per register.
+        uint8x16x4_t a = vld4q_u8(s0);
+        uint8x16x4_t b = vld4q_u8(s1);
+        uint8x8x4_t c;
+        for (int j = 0; j < 4; ++j) {
+            uint16x8_t sum = vpadalq_u8(vpaddlq_u8(a.val[j]), b.val[j]);
+            c.val[j] = vshrn_n_u16(sum, 2);
+        }
+        vst4_u8(d, c);
+        s0 += 64;
+        s1 += 64;
+        d += 32;
+    }
+    return n << 3;
+}
+
+// Returns the average of the component at shift for 4 dst pixels, from 8
+// pixels in each row, shifted back into place.
+static inline uint16x4_t average_component_16(uint16x8_t row0, uint16x8_t row1,
+                                              int shift, unsigned mask) {
+    const int16x8_t right = vdupq_n_s16(-shift);
+    const uint16x8_t m = vdupq_n_u16(mask);
+    uint32x4_t sum = vpaddlq_u16(vandq_u16(vshlq_u16(row0, right), m));
+    sum = vpadalq_u16(sum, vandq_u16(vshlq_u16(row1, right), m));
+    return vshl_u16(vshrn_n_u32(sum, 2), vdup_n_s16(shift));
+}
+
+int SkDownsampleRow565_neon(void* dst, const void* src0, const void* src1, int count) {
+    const uint16_t* s0 = static_cast<const uint16_t*>(src0);
+    const uint16_t* s1 = static_cast<const uint16_t*>(src1);
+    uint16_t* d = static_cast<uint16_t*>(dst);
+
+    const int n = count >> 2;
+    for (int i = 0; i < n; ++i) {
+        uint16x8_t row0 = vld1q_u16(s0);
+        uint16x8_t row1 = vld1q_u16(s1);
+        uint16x4_t c = average_component_16(row0, row1, SK_R16_SHIFT, SK_R16_MASK);
+        c = vorr_u16(c, average_component_16(row0, row1, SK_G16_SHIFT, SK_G16_MASK));
+        c = vorr_u16(c, average_component_16(row0, row1, SK_B16_SHIFT, SK_B16_MASK));
+        vst1_u16(d, c);
+        s0 += 8;
+        s1 += 8;
+        d += 4;
+    }
+    return n << 2;
+}
+
+int SkDownsampleRow4444_neon(void* dst, const void* src0, const void* src1, int count) {
+    const uint16_t* s0 = static_cast<const uint16_t*>(src0);
+    const uint16_t* s1 = static_cast<const uint16_t*>(src1);
+    uint16_t* d = static_cast<uint16_t*>(dst);
+
+    const int n = count >> 2;
+    for (int i = 0; i < n; ++i) {
+        uint16x8_t row0 = vld1q_u16(s0);
+        uint16x8_t row1 = vld1q_u16(s1);
+        uint16x4_t c = average_component_16(row0, row1, SK_A4444_SHIFT, 0xF);
+        c = vorr_u16(c, average_component_16(row0, row1, SK_R4444_SHIFT, 0xF));
+        c = vorr_u16(c, average_component_16(row0, row1, SK_G4444_SHIFT, 0xF));
+        c = vorr_u16(c, average_component_16(row0, row1, SK_B4444_SHIFT, 0xF));
+        vst1_u16(d, c);
+        s0 += 8;
+        s1 += 8;
+        d += 4;
+    }
+    return n << 2;
+}
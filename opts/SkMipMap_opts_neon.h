@@ -0,0 +1,17 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMipMap_opts_neon_DEFINED
+#define SkMipMap_opts_neon_DEFINED
+
+#include "SkTypes.h"
+
+int SkDownsampleRow32_neon(void* dst, const void* src0, const void* src1, int count);
+int SkDownsampleRow565_neon(void* dst, const void* src0, const void* src1, int count);
+int SkDownsampleRow4444_neon(void* dst, const void* src0, const void* src1, int count);
+
+#endif
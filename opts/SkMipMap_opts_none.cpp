@@ -0,0 +1,12 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkMipMap_opts.h"
+
+SkDownsampleRowProc SkMipMapGetPlatformProc(SkMipMapProcType) {
+    return NULL;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkScaledBitmapSampler_opts_DEFINED
+#define SkScaledBitmapSampler_opts_DEFINED
+
+#include "SkScaledBitmapSampler.h"
+
+enum SkSamplerProcType {
+    kGray_D8888_SkSamplerProcType,          // Sample_Gray_D8888
+    kRGB_D8888_SkSamplerProcType,           // Sample_RGBx_D8888, 3 byte src
+    kRGBX_D8888_SkSamplerProcType,          // Sample_RGBx_D8888, 4 byte src
+    kRGBA_D8888_SkSamplerProcType,          // Sample_RGBA_D8888
+    kRGBA_D8888_Unpremul_SkSamplerProcType, // Sample_RGBA_D8888_Unpremul
+};
+
+/**
+ *  Returns a platform version of one of the sampler's row procs, or NULL.
+ *  It gives exactly the same results as the portable proc, but it is only
+ *  used when every pixel of the row is sampled, so it may assume that
+ *  deltaSrc is the size of a source pixel.
+ */
+SkScaledBitmapSampler::RowProc SkScaledBitmapSamplerGetPlatformProc(SkSamplerProcType);
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScaledBitmapSampler_opts_AVX2.h"
+#include "SkScaledBitmapSampler_opts_SSE2.h"
+#include "SkColorPriv.h"
+#include "SkColor_opts_AVX2.h"
+
+#include <immintrin.h>
+
+/* These are the SSE2 procs from SkScaledBitmapSampler_opts_SSE2.cpp widened
+ * to eight pixels per iteration. The last few pixels of a row are left to the
+ * SSE2 procs.
+ */
+
+// Returns the AND of the alpha bytes of eight R, G, B, A pixels.
+static inline unsigned and_alphas(__m256i rgba) {
+    __m128i a = _mm_and_si128(_mm256_castsi256_si128(rgba),
+                              _mm256_extracti128_si256(rgba, 1));
+    a = _mm_srli_epi32(a, 24);
+    a = _mm_and_si128(a, _mm_srli_si128(a, 8));
+    a = _mm_and_si128(a, _mm_srli_si128(a, 4));
+    return _mm_cvtsi128_si32(a);
+}
+
+bool Sample_RGBX_D8888_AVX2(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int y, const SkPMColor ctable[]) {
+    SkASSERT(4 == deltaSrc);
+    SkPMColor* SK_RESTRICT dst = (SkPMColor*)dstRow;
+    const __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i rgbx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x),
+                            SkRGBAToPMColor_AVX2(_mm256_or_si256(rgbx, opaque)));
+        src += 32;
+    }
+    return Sample_RGBX_D8888_SSE2(dst + x, src, width - x, deltaSrc, y, ctable);
+}
+
+bool Sample_RGBA_D8888_AVX2(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int y, const SkPMColor ctable[]) {
+    SkASSERT(4 == deltaSrc);
+    SkPMColor* SK_RESTRICT dst = (SkPMColor*)dstRow;
+    const __m256i zero = _mm256_setzero_si256();
+    // The alpha channel is "multiplied" by 255, which leaves it unchanged.
+    const __m256i colorLanes = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1,
+                                                0, -1, -1, -1, 0, -1, -1, -1);
+    const __m256i alphaLanes = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0,
+                                                255, 0, 0, 0, 255, 0, 0, 0);
+    __m256i allAlphas = _mm256_set1_epi32(-1);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i rgba = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        allAlphas = _mm256_and_si256(allAlphas, rgba);
+
+        // The unpacks and the pack below work within each 128 bit lane, so
+        // the pixels come back out in order.
+        __m256i lo = _mm256_unpacklo_epi8(rgba, zero);
+        __m256i hi = _mm256_unpackhi_epi8(rgba, zero);
+        __m256i scaleLo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, 0xFF), 0xFF);
+        __m256i scaleHi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, 0xFF), 0xFF);
+        scaleLo = _mm256_or_si256(_mm256_and_si256(scaleLo, colorLanes), alphaLanes);
+        scaleHi = _mm256_or_si256(_mm256_and_si256(scaleHi, colorLanes), alphaLanes);
+        lo = SkMulDiv255Round16_AVX2(lo, scaleLo);
+        hi = SkMulDiv255Round16_AVX2(hi, scaleHi);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x),
+                            SkRGBAToPMColor_AVX2(_mm256_packus_epi16(lo, hi)));
+        src += 32;
+    }
+    bool tailHasAlpha = Sample_RGBA_D8888_SSE2(dst + x, src, width - x, deltaSrc, y, ctable);
+    return tailHasAlpha || and_alphas(allAlphas) != 0xFF;
+}
+
+bool Sample_RGBA_D8888_Unpremul_AVX2(void* SK_RESTRICT dstRow,
+                                     const uint8_t* SK_RESTRICT src,
+                                     int width, int deltaSrc, int y,
+                                     const SkPMColor ctable[]) {
+    SkASSERT(4 == deltaSrc);
+    uint32_t* SK_RESTRICT dst = reinterpret_cast<uint32_t*>(dstRow);
+    __m256i allAlphas = _mm256_set1_epi32(-1);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i rgba = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        allAlphas = _mm256_and_si256(allAlphas, rgba);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), SkRGBAToPMColor_AVX2(rgba));
+        src += 32;
+    }
+    bool tailHasAlpha = Sample_RGBA_D8888_Unpremul_SSE2(dst + x, src, width - x,
+                                                        deltaSrc, y, ctable);
+    return tailHasAlpha || and_alphas(allAlphas) != 0xFF;
+}
@@ -0,0 +1,24 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkScaledBitmapSampler_opts_AVX2_DEFINED
+#define SkScaledBitmapSampler_opts_AVX2_DEFINED
+
+#include "SkColor.h"
+
+bool Sample_RGBX_D8888_AVX2(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]);
+bool Sample_RGBA_D8888_AVX2(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]);
+bool Sample_RGBA_D8888_Unpremul_AVX2(void* SK_RESTRICT dstRow,
+                                     const uint8_t* SK_RESTRICT src,
+                                     int width, int deltaSrc, int,
+                                     const SkPMColor[]);
+
+#endif
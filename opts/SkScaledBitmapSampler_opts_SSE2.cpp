@@ -0,0 +1,132 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScaledBitmapSampler_opts_SSE2.h"
+#include "SkColorPriv.h"
+#include "SkColor_opts_SSE2.h"
+
+#include <emmintrin.h>
+
+/* SSE2 versions of the sampler's row procs, for rows where every pixel is
+ * sampled. portable versions are in src/images/SkScaledBitmapSampler.cpp.
+ */
+
+// Returns the AND of the alpha bytes of four R, G, B, A pixels.
+static inline unsigned and_alphas(__m128i rgba) {
+    __m128i a = _mm_srli_epi32(rgba, 24);
+    a = _mm_and_si128(a, _mm_srli_si128(a, 8));
+    a = _mm_and_si128(a, _mm_srli_si128(a, 4));
+    return _mm_cvtsi128_si32(a);
+}
+
+bool Sample_Gray_D8888_SSE2(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]) {
+    SkASSERT(1 == deltaSrc);
+    SkPMColor* SK_RESTRICT dst = (SkPMColor*)dstRow;
+    // Each gray byte is copied to all four bytes, then the alpha byte is
+    // filled in, which works for any byte order.
+    const __m128i alpha = _mm_set1_epi32((int)(0xFFu << SK_A32_SHIFT));
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i gray = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        __m128i lo = _mm_unpacklo_epi8(gray, gray);
+        __m128i hi = _mm_unpackhi_epi8(gray, gray);
+        __m128i* d = reinterpret_cast<__m128i*>(dst + x);
+        _mm_storeu_si128(d + 0, _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha));
+        _mm_storeu_si128(d + 1, _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha));
+        _mm_storeu_si128(d + 2, _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha));
+        _mm_storeu_si128(d + 3, _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha));
+    }
+    for (; x < width; x++) {
+        dst[x] = SkPackARGB32(0xFF, src[x], src[x], src[x]);
+    }
+    return false;
+}
+
+bool Sample_RGBX_D8888_SSE2(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]) {
+    SkASSERT(4 == deltaSrc);
+    SkPMColor* SK_RESTRICT dst = (SkPMColor*)dstRow;
+    const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i rgbx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                         SkRGBAToPMColor_SSE(_mm_or_si128(rgbx, opaque)));
+        src += 16;
+    }
+    for (; x < width; x++) {
+        dst[x] = SkPackARGB32(0xFF, src[0], src[1], src[2]);
+        src += 4;
+    }
+    return false;
+}
+
+bool Sample_RGBA_D8888_SSE2(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]) {
+    SkASSERT(4 == deltaSrc);
+    SkPMColor* SK_RESTRICT dst = (SkPMColor*)dstRow;
+    const __m128i zero = _mm_setzero_si128();
+    // The alpha channel is "multiplied" by 255, which leaves it unchanged.
+    const __m128i colorLanes = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alphaLanes = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    __m128i allAlphas = _mm_set1_epi32(-1);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        allAlphas = _mm_and_si128(allAlphas, rgba);
+
+        __m128i lo = _mm_unpacklo_epi8(rgba, zero);
+        __m128i hi = _mm_unpackhi_epi8(rgba, zero);
+        __m128i scaleLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xFF), 0xFF);
+        __m128i scaleHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xFF), 0xFF);
+        scaleLo = _mm_or_si128(_mm_and_si128(scaleLo, colorLanes), alphaLanes);
+        scaleHi = _mm_or_si128(_mm_and_si128(scaleHi, colorLanes), alphaLanes);
+        // Same rounding as SkMulDiv255Round().
+        lo = SkMul16ShiftRound_SSE(lo, scaleLo, 8);
+        hi = SkMul16ShiftRound_SSE(hi, scaleHi, 8);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                         SkRGBAToPMColor_SSE(_mm_packus_epi16(lo, hi)));
+        src += 16;
+    }
+    unsigned alphaMask = and_alphas(allAlphas);
+    for (; x < width; x++) {
+        unsigned alpha = src[3];
+        dst[x] = SkPreMultiplyARGB(alpha, src[0], src[1], src[2]);
+        src += 4;
+        alphaMask &= alpha;
+    }
+    return alphaMask != 0xFF;
+}
+
+bool Sample_RGBA_D8888_Unpremul_SSE2(void* SK_RESTRICT dstRow,
+                                     const uint8_t* SK_RESTRICT src,
+                                     int width, int deltaSrc, int,
+                                     const SkPMColor[]) {
+    SkASSERT(4 == deltaSrc);
+    uint32_t* SK_RESTRICT dst = reinterpret_cast<uint32_t*>(dstRow);
+    __m128i allAlphas = _mm_set1_epi32(-1);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        allAlphas = _mm_and_si128(allAlphas, rgba);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), SkRGBAToPMColor_SSE(rgba));
+        src += 16;
+    }
+    unsigned alphaMask = and_alphas(allAlphas);
+    for (; x < width; x++) {
+        unsigned alpha = src[3];
+        dst[x] = SkPackARGB32NoCheck(alpha, src[0], src[1], src[2]);
+        src += 4;
+        alphaMask &= alpha;
+    }
+    return alphaMask != 0xFF;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScaledBitmapSampler_opts_SSSE3.h"
+#include "SkColorPriv.h"
+
+/* See SkBitmapProcState_opts_SSSE3.cpp for why the Android framework may get
+ * a stub instead.
+ */
+#if !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) || SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSSE3
+
+#include "SkColor_opts_SSE2.h"
+
+#include <tmmintrin.h>  // SSSE3
+
+/* SSSE3 version of the sampler's RGB row proc, for rows where every pixel is
+ * sampled. portable version is Sample_RGBx_D8888 in
+ * src/images/SkScaledBitmapSampler.cpp.
+ */
+bool Sample_RGB_D8888_SSSE3(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]) {
+    SkASSERT(3 == deltaSrc);
+    SkPMColor* SK_RESTRICT dst = (SkPMColor*)dstRow;
+    // Spreads four 3 byte pixels out to 4 bytes each, zeroing the 4th.
+    const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,
+                                         6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+    int x = 0;
+    // Each step loads 16 bytes but only uses 12, so stop while at least 16
+    // bytes (6 pixels) are left.
+    for (; x + 6 <= width; x += 4) {
+        __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(rgb, expand), opaque);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), SkRGBAToPMColor_SSE(rgba));
+        src += 12;
+    }
+    for (; x < width; x++) {
+        dst[x] = SkPackARGB32(0xFF, src[0], src[1], src[2]);
+        src += 3;
+    }
+    return false;
+}
+
+#else // !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) || SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSSE3
+
+bool Sample_RGB_D8888_SSSE3(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]) {
+    sk_throw();
+    return false;
+}
+
+#endif
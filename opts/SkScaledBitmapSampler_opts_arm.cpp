@@ -0,0 +1,36 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScaledBitmapSampler_opts.h"
+#include "SkScaledBitmapSampler_opts_neon.h"
+#include "SkUtilsArm.h"
+
+SkScaledBitmapSampler::RowProc SkScaledBitmapSamplerGetPlatformProc(SkSamplerProcType type) {
+#if SK_ARM_NEON_IS_NONE
+    return NULL;
+#else
+#if SK_ARM_NEON_IS_DYNAMIC
+    if (!sk_cpu_arm_has_neon()) {
+        return NULL;
+    }
+#endif
+    switch (type) {
+        case kGray_D8888_SkSamplerProcType:
+            return Sample_Gray_D8888_neon;
+        case kRGB_D8888_SkSamplerProcType:
+            return Sample_RGB_D8888_neon;
+        case kRGBX_D8888_SkSamplerProcType:
+            return Sample_RGBX_D8888_neon;
+        case kRGBA_D8888_SkSamplerProcType:
+            return Sample_RGBA_D8888_neon;
+        case kRGBA_D8888_Unpremul_SkSamplerProcType:
+            return Sample_RGBA_D8888_Unpremul_neon;
+        default:
+            return NULL;
+    }
+#endif
+}
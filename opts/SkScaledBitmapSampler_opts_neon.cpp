@@ -0,0 +1,152 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScaledBitmapSampler_opts_neon.h"
+#include "SkColorPriv.h"
+
+#include <arm_neon.h>
+
+/* neon versions of the sampler's row procs, for rows where every pixel is
+ * sampled. portable versions are in src/images/SkScaledBitmapSampler.cpp.
+ */
+
+static inline void store_pmcolors(SkPMColor* dst, uint8x8_t r, uint8x8_t g,
+                                  uint8x8_t b, uint8x8_t a) {
+    uint8x8x4_t pixels;
+#if SK_PMCOLOR_BYTE_ORDER(B,G,R,A)
+    pixels.val[0] = b;
+    pixels.val[2] = r;
+#elif SK_PMCOLOR_BYTE_ORDER(R,G,B,A)
+    pixels.val[0] = r;
+    pixels.val[2] = b;
+#else
+    #error "unsupported SkPMColor byte order"
+#endif
+    pixels.val[1] = g;
+    pixels.val[3] = a;
+    vst4_u8(reinterpret_cast<uint8_t*>(dst), pixels);
+}
+
+// Same rounding as SkMulDiv255Round().
+static inline uint8x8_t mul_div_255_round(uint8x8_t c, uint8x8_t a) {
+    uint16x8_t prod = vaddq_u16(vmull_u8(c, a), vdupq_n_u16(128));
+    return vshrn_n_u16(vsraq_n_u16(prod, prod, 8), 8);
+}
+
+// Returns the AND of the eight bytes of v.
+static inline unsigned and_lanes(uint8x8_t v) {
+    uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(v), 0);
+    bits &= bits >> 32;
+    bits &= bits >> 16;
+    bits &= bits >> 8;
+    return bits & 0xFF;
+}
+
+bool Sample_Gray_D8888_neon(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]) {
+    SkASSERT(1 == deltaSrc);
+    SkPMColor* SK_RESTRICT dst = (SkPMColor*)dstRow;
+    const uint8x8_t opaque = vdup_n_u8(0xFF);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint8x8_t gray = vld1_u8(src + x);
+        store_pmcolors(dst + x, gray, gray, gray, opaque);
+    }
+    for (; x < width; x++) {
+        dst[x] = SkPackARGB32(0xFF, src[x], src[x], src[x]);
+    }
+    return false;
+}
+
+bool Sample_RGB_D8888_neon(void* SK_RESTRICT dstRow,
+                           const uint8_t* SK_RESTRICT src,
+                           int width, int deltaSrc, int, const SkPMColor[]) {
+    SkASSERT(3 == deltaSrc);
+    SkPMColor* SK_RESTRICT dst = (SkPMColor*)dstRow;
+    const uint8x8_t opaque = vdup_n_u8(0xFF);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint8x8x3_t rgb = vld3_u8(src);
+        store_pmcolors(dst + x, rgb.val[0], rgb.val[1], rgb.val[2], opaque);
+        src += 24;
+    }
+    for (; x < width; x++) {
+        dst[x] = SkPackARGB32(0xFF, src[0], src[1], src[2]);
+        src += 3;
+    }
+    return false;
+}
+
+bool Sample_RGBX_D8888_neon(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]) {
+    SkASSERT(4 == deltaSrc);
+    SkPMColor* SK_RESTRICT dst = (SkPMColor*)dstRow;
+    const uint8x8_t opaque = vdup_n_u8(0xFF);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint8x8x4_t rgbx = vld4_u8(src);
+        store_pmcolors(dst + x, rgbx.val[0], rgbx.val[1], rgbx.val[2], opaque);
+        src += 32;
+    }
+    for (; x < width; x++) {
+        dst[x] = SkPackARGB32(0xFF, src[0], src[1], src[2]);
+        src += 4;
+    }
+    return false;
+}
+
+bool Sample_RGBA_D8888_neon(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]) {
+    SkASSERT(4 == deltaSrc);
+    SkPMColor* SK_RESTRICT dst = (SkPMColor*)dstRow;
+    uint8x8_t allAlphas = vdup_n_u8(0xFF);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint8x8x4_t rgba = vld4_u8(src);
+        uint8x8_t a = rgba.val[3];
+        allAlphas = vand_u8(allAlphas, a);
+        store_pmcolors(dst + x, mul_div_255_round(rgba.val[0], a),
+                       mul_div_255_round(rgba.val[1], a),
+                       mul_div_255_round(rgba.val[2], a), a);
+        src += 32;
+    }
+    unsigned alphaMask = and_lanes(allAlphas);
+    for (; x < width; x++) {
+        unsigned alpha = src[3];
+        dst[x] = SkPreMultiplyARGB(alpha, src[0], src[1], src[2]);
+        src += 4;
+        alphaMask &= alpha;
+    }
+    return alphaMask != 0xFF;
+}
+
+bool Sample_RGBA_D8888_Unpremul_neon(void* SK_RESTRICT dstRow,
+                                     const uint8_t* SK_RESTRICT src,
+                                     int width, int deltaSrc, int,
+                                     const SkPMColor[]) {
+    SkASSERT(4 == deltaSrc);
+    uint32_t* SK_RESTRICT dst = reinterpret_cast<uint32_t*>(dstRow);
+    uint8x8_t allAlphas = vdup_n_u8(0xFF);
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint8x8x4_t rgba = vld4_u8(src);
+        allAlphas = vand_u8(allAlphas, rgba.val[3]);
+        store_pmcolors(dst + x, rgba.val[0], rgba.val[1], rgba.val[2], rgba.val[3]);
+        src += 32;
+    }
+    unsigned alphaMask = and_lanes(allAlphas);
+    for (; x < width; x++) {
+        unsigned alpha = src[3];
+        dst[x] = SkPackARGB32NoCheck(alpha, src[0], src[1], src[2]);
+        src += 4;
+        alphaMask &= alpha;
+    }
+    return alphaMask != 0xFF;
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkScaledBitmapSampler_opts_neon_DEFINED
+#define SkScaledBitmapSampler_opts_neon_DEFINED
+
+#include "SkColor.h"
+
+bool Sample_Gray_D8888_neon(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]);
+bool Sample_RGB_D8888_neon(void* SK_RESTRICT dstRow,
+                           const uint8_t* SK_RESTRICT src,
+                           int width, int deltaSrc, int, const SkPMColor[]);
+bool Sample_RGBX_D8888_neon(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]);
+bool Sample_RGBA_D8888_neon(void* SK_RESTRICT dstRow,
+                            const uint8_t* SK_RESTRICT src,
+                            int width, int deltaSrc, int, const SkPMColor[]);
+bool Sample_RGBA_D8888_Unpremul_neon(void* SK_RESTRICT dstRow,
+                                     const uint8_t* SK_RESTRICT src,
+                                     int width, int deltaSrc, int,
+                                     const SkPMColor[]);
+
+#endif
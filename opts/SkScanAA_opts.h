@@ -0,0 +1,32 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkScanAA_opts_DEFINED
+#define SkScanAA_opts_DEFINED
+
+#include "SkTypes.h"
+
+/**
+ *  Adds value to each of the count coverage bytes in alpha. The caller
+ *  guarantees that no byte overflows past 255.
+ */
+typedef void (*SkCoverageAddProc)(uint8_t alpha[], U8CPU value, int count);
+
+/**
+ *  Returns the number of leading bytes in alpha (at least 1, at most count)
+ *  that are equal to alpha[0].
+ */
+typedef int (*SkCoverageRunProc)(const uint8_t alpha[], int count);
+
+/**
+ *  If the platform has wide coverage accumulation procs, sets both and returns
+ *  true. In that case SkScan_AntiPath accumulates each supersampled scanline
+ *  into a dense coverage row, rather than through SkAlphaRuns.
+ */
+bool SkScanAAGetPlatformProcs(SkCoverageAddProc*, SkCoverageRunProc*);
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScanAA_opts_SSE2.h"
+
+#include <emmintrin.h>
+
+/* SSE2 versions of the dense coverage row procs (see SkScanAA_opts.h).
+ * There are no portable versions: without platform procs, SkScan_AntiPath
+ * accumulates coverage through SkAlphaRuns instead.
+ */
+
+void SkCoverageAdd_SSE2(uint8_t alpha[], U8CPU value, int count) {
+    SkASSERT(count >= 0);
+
+    const __m128i v = _mm_set1_epi8((char)value);
+    while (count >= 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(alpha), _mm_add_epi8(a, v));
+        alpha += 16;
+        count -= 16;
+    }
+    while (--count >= 0) {
+        *alpha = SkToU8(*alpha + value);
+        alpha += 1;
+    }
+}
+
+int SkCoverageRun_SSE2(const uint8_t alpha[], int count) {
+    SkASSERT(count > 0);
+
+    const uint8_t first = alpha[0];
+    const __m128i v = _mm_set1_epi8((char)first);
+    int n = 0;
+    while (n + 16 <= count) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha + n));
+        int equal = _mm_movemask_epi8(_mm_cmpeq_epi8(a, v));
+        if (equal != 0xFFFF) {
+            // the run ends at the first byte that differs
+            int differ = ~equal & 0xFFFF;
+            while (!(differ & 1)) {
+                differ >>= 1;
+                n += 1;
+            }
+            return n;
+        }
+        n += 16;
+    }
+    while (n < count && alpha[n] == first) {
+        n += 1;
+    }
+    return n;
+}
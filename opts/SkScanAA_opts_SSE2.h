@@ -0,0 +1,16 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkScanAA_opts_SSE2_DEFINED
+#define SkScanAA_opts_SSE2_DEFINED
+
+#include "SkTypes.h"
+
+void SkCoverageAdd_SSE2(uint8_t alpha[], U8CPU value, int count);
+int SkCoverageRun_SSE2(const uint8_t alpha[], int count);
+
+#endif
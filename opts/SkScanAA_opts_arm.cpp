@@ -0,0 +1,25 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScanAA_opts.h"
+#include "SkScanAA_opts_neon.h"
+#include "SkUtilsArm.h"
+
+bool SkScanAAGetPlatformProcs(SkCoverageAddProc* addProc, SkCoverageRunProc* runProc) {
+#if SK_ARM_NEON_IS_NONE
+    return false;
+#else
+#if SK_ARM_NEON_IS_DYNAMIC
+    if (!sk_cpu_arm_has_neon()) {
+        return false;
+    }
+#endif
+    *addProc = SkCoverageAdd_neon;
+    *runProc = SkCoverageRun_neon;
+    return true;
+#endif
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScanAA_opts_neon.h"
+
+#include <arm_neon.h>
+
+/* neon versions of the dense coverage row procs (see SkScanAA_opts.h).
+ * There are no portable versions: without platform procs, SkScan_AntiPath
+ * accumulates coverage through SkAlphaRuns instead.
+ */
+
+void SkCoverageAdd_neon(uint8_t alpha[], U8CPU value, int count) {
+    SkASSERT(count >= 0);
+
+    const uint8x16_t v = vdupq_n_u8(value);
+    while (count >= 16) {
+        vst1q_u8(alpha, vaddq_u8(vld1q_u8(alpha), v));
+        alpha += 16;
+        count -= 16;
+    }
+    while (--count >= 0) {
+        *alpha = SkToU8(*alpha + value);
+        alpha += 1;
+    }
+}
+
+int SkCoverageRun_neon(const uint8_t alpha[], int count) {
+    SkASSERT(count > 0);
+
+    const uint8_t first = alpha[0];
+    const uint8x16_t v = vdupq_n_u8(first);
+    int n = 0;
+    while (n + 16 <= count) {
+        uint64x2_t equal = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8(alpha + n), v));
+        if ((vgetq_lane_u64(equal, 0) & vgetq_lane_u64(equal, 1)) != ~(uint64_t)0) {
+            // the run ends somewhere in these 16 bytes
+            break;
+        }
+        n += 16;
+    }
+    while (n < count && alpha[n] == first) {
+        n += 1;
+    }
+    return n;
+}
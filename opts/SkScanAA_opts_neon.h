@@ -0,0 +1,16 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkScanAA_opts_neon_DEFINED
+#define SkScanAA_opts_neon_DEFINED
+
+#include "SkTypes.h"
+
+void SkCoverageAdd_neon(uint8_t alpha[], U8CPU value, int count);
+int SkCoverageRun_neon(const uint8_t alpha[], int count);
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkXfermode_opts_AVX2.h"
+
+#include "SkColorPriv.h"
+#include "SkColor_opts_AVX2.h"
+
+#include <immintrin.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// 8 pixels modeprocs
+////////////////////////////////////////////////////////////////////////////////
+
+typedef __m256i (*SkXfermodeProcAVX2)(__m256i src, __m256i dst);
+
+// Widens both inputs to 16 bits per channel, runs proc16 on each half and
+// packs the result back. Unpack and pack both work within 128-bit lanes, so
+// the pixel order is preserved.
+template <SkXfermodeProcAVX2 proc16>
+static inline __m256i unpacked_modeproc_avx2(__m256i src, __m256i dst) {
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m256i lo = proc16(_mm256_unpacklo_epi8(src, zero),
+                        _mm256_unpacklo_epi8(dst, zero));
+    __m256i hi = proc16(_mm256_unpackhi_epi8(src, zero),
+                        _mm256_unpackhi_epi8(dst, zero));
+    return _mm256_packus_epi16(lo, hi);
+}
+
+// Copies each pixel's alpha word into its other three channel words.
+static inline __m256i splat_alpha16_avx2(__m256i c16) {
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c16, 0xFF), 0xFF);
+}
+
+static __m256i src_modeproc_avx2(__m256i src, __m256i dst) {
+    return src;
+}
+
+static __m256i dstin_modeproc_avx2(__m256i src, __m256i dst) {
+    __m256i scale = _mm256_add_epi16(SkGetPackedA32x2_AVX2(src),
+                                     _mm256_set1_epi16(1));
+    return SkAlphaMulQ_AVX2(dst, scale);
+}
+
+// srcover_byte() on every channel: s + d - s * d / 255
+static __m256i screen_modeproc16_avx2(__m256i src, __m256i dst) {
+    __m256i sum = _mm256_add_epi16(src, dst);
+    return _mm256_sub_epi16(sum, SkMulDiv255Round16_AVX2(src, dst));
+}
+
+// clamp_div255round(sc * (255 - da) + dc * (255 - sa) + sc * dc). For the
+// alpha channel this reduces to srcover_byte(sa, da), so all four channels
+// share the same math. The saturating adds and the min reproduce the clamp
+// for (non-premultiplied) inputs that would overflow 16 bits.
+static __m256i multiply_modeproc16_avx2(__m256i src, __m256i dst) {
+    const __m256i c_255 = _mm256_set1_epi16(255);
+
+    __m256i isa = _mm256_sub_epi16(c_255, splat_alpha16_avx2(src));
+    __m256i ida = _mm256_sub_epi16(c_255, splat_alpha16_avx2(dst));
+
+    __m256i prod = _mm256_mullo_epi16(src, ida);
+    prod = _mm256_adds_epu16(prod, _mm256_mullo_epi16(dst, isa));
+    prod = _mm256_adds_epu16(prod, _mm256_mullo_epi16(src, dst));
+    prod = _mm256_min_epu16(prod, _mm256_set1_epi16(255 * 255));
+
+    prod = _mm256_add_epi16(prod, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(prod, _mm256_srli_epi16(prod, 8)), 8);
+}
+
+static __m256i screen_modeproc_avx2(__m256i src, __m256i dst) {
+    return unpacked_modeproc_avx2<screen_modeproc16_avx2>(src, dst);
+}
+
+static __m256i multiply_modeproc_avx2(__m256i src, __m256i dst) {
+    return unpacked_modeproc_avx2<multiply_modeproc16_avx2>(src, dst);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SkAVX2ProcCoeffXfermode::xfer32(SkPMColor dst[], const SkPMColor src[],
+                                     int count, const SkAlpha aa[]) const {
+    SkASSERT(dst && src && count >= 0);
+
+    SkXfermodeProc proc = this->getProc();
+    SkXfermodeProcAVX2 procSIMD = reinterpret_cast<SkXfermodeProcAVX2>(fProcSIMD);
+    SkASSERT(procSIMD != NULL);
+
+    while (count >= 8) {
+        // Coverage is mostly all-on or all-off over 8 pixels, so those runs
+        // stay vectorized and only partial edges drop to the per-pixel code.
+        uint64_t coverage = ~0ULL;
+        if (NULL != aa) {
+            memcpy(&coverage, aa, sizeof(coverage));
+        }
+
+        if (~0ULL == coverage) {
+            __m256i vsrc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+            __m256i vdst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), procSIMD(vsrc, vdst));
+        } else if (0 != coverage) {
+            for (int i = 0; i < 8; ++i) {
+                unsigned a = aa[i];
+                if (0 != a) {
+                    SkPMColor dstC = dst[i];
+                    SkPMColor C = proc(src[i], dstC);
+                    if (a != 0xFF) {
+                        C = SkFourByteInterp(C, dstC, a);
+                    }
+                    dst[i] = C;
+                }
+            }
+        }
+
+        src += 8;
+        dst += 8;
+        if (NULL != aa) {
+            aa += 8;
+        }
+        count -= 8;
+    }
+
+    // Leftovers
+    for (int i = 0; i < count; ++i) {
+        unsigned a = aa ? aa[i] : 0xFF;
+        if (0 != a) {
+            SkPMColor dstC = dst[i];
+            SkPMColor C = proc(src[i], dstC);
+            if (a != 0xFF) {
+                C = SkFourByteInterp(C, dstC, a);
+            }
+            dst[i] = C;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static SkXfermodeProcAVX2 gAVX2XfermodeProcs[] = {
+    NULL, // kClear_Mode
+    src_modeproc_avx2,
+    NULL, // kDst_Mode
+    NULL, // kSrcOver_Mode: never built (NULL means srcover), see S32A_Opaque_BlitRow32_AVX2
+    NULL, // kDstOver_Mode
+    NULL, // kSrcIn_Mode
+    dstin_modeproc_avx2,
+    NULL, // kSrcOut_Mode
+    NULL, // kDstOut_Mode
+    NULL, // kSrcATop_Mode
+    NULL, // kDstATop_Mode
+    NULL, // kXor_Mode
+    NULL, // kPlus_Mode
+    NULL, // kModulate_Mode
+    screen_modeproc_avx2,
+
+    NULL, // kOverlay_Mode
+    NULL, // kDarken_Mode
+    NULL, // kLighten_Mode
+    NULL, // kColorDodge_Mode
+    NULL, // kColorBurn_Mode
+    NULL, // kHardLight_Mode
+    NULL, // kSoftLight_Mode
+    NULL, // kDifference_Mode
+    NULL, // kExclusion_Mode
+    multiply_modeproc_avx2,
+
+    NULL, // kHue_Mode
+    NULL, // kSaturation_Mode
+    NULL, // kColor_Mode
+    NULL, // kLuminosity_Mode
+};
+
+SK_COMPILE_ASSERT(
+    SK_ARRAY_COUNT(gAVX2XfermodeProcs) == SkXfermode::kLastMode + 1,
+    mode_count_avx2
+);
+
+SkProcCoeffXfermode* SkPlatformXfermodeFactory_impl_AVX2(const ProcCoeff& rec,
+                                                         SkXfermode::Mode mode) {
+
+    void* procSIMD = reinterpret_cast<void*>(gAVX2XfermodeProcs[mode]);
+
+    if (procSIMD != NULL) {
+        return SkNEW_ARGS(SkAVX2ProcCoeffXfermode, (rec, mode, procSIMD));
+    }
+    return NULL;
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkXfermode_opts_AVX2_DEFINED
+#define SkXfermode_opts_AVX2_DEFINED
+
+#include "SkXfermode_proccoeff.h"
+
+class SkAVX2ProcCoeffXfermode : public SkProcCoeffXfermode {
+public:
+    SkAVX2ProcCoeffXfermode(const ProcCoeff& rec, SkXfermode::Mode mode,
+                            void* procSIMD)
+            : INHERITED(rec, mode), fProcSIMD(procSIMD) {}
+
+    virtual void xfer32(SkPMColor dst[], const SkPMColor src[], int count,
+                        const SkAlpha aa[]) const SK_OVERRIDE;
+
+    // No flattenable procs are declared here on purpose: this flattens (and
+    // unflattens) as a plain SkProcCoeffXfermode, so a picture recorded on an
+    // AVX2 machine still plays back on a CPU without it.
+
+private:
+    // void* is used to avoid pulling immintrin.h in the core and having to
+    // build it with -mavx2.
+    void* fProcSIMD;
+    typedef SkProcCoeffXfermode INHERITED;
+};
+
+#endif //#ifdef SkXfermode_opts_AVX2_DEFINED
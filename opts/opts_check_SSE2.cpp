@@ -7,16 +7,28 @@
 
 #include "SkBitmapProcState_opts_SSE2.h"
 #include "SkBitmapProcState_opts_SSSE3.h"
+#include "SkBitmapFilter_opts_AVX2.h"
 #include "SkBitmapFilter_opts_SSE2.h"
 #include "SkBlitMask.h"
 #include "SkBlitRow.h"
 #include "SkBlitRect_opts_SSE2.h"
 #include "SkBlitRow_opts_SSE2.h"
+#include "SkBlitRow_opts_AVX2.h"
 #include "SkBlurImage_opts_SSE2.h"
+#include "SkMipMap_opts.h"
+#include "SkMipMap_opts_SSE2.h"
+#include "SkScaledBitmapSampler_opts.h"
+#include "SkScaledBitmapSampler_opts_AVX2.h"
+#include "SkScaledBitmapSampler_opts_SSE2.h"
+#include "SkScaledBitmapSampler_opts_SSSE3.h"
+#include "SkScanAA_opts.h"
+#include "SkScanAA_opts_SSE2.h"
 #include "SkUtils_opts_SSE2.h"
 #include "SkUtils.h"
 #include "SkMorphology_opts.h"
 #include "SkMorphology_opts_SSE2.h"
+#include "SkXfermode.h"
+#include "SkXfermode_proccoeff.h"
 
 #include "SkRTConf.h"
 
@@ -27,16 +39,20 @@
 /* This file must *not* be compiled with -msse or -msse2, otherwise
    gcc may generate sse2 even for scalar ops (and thus give an invalid
    instruction on Pentium3 on the code below).  Only files named *_SSE2.cpp
-   in this directory should be compiled with -msse2. */
+   in this directory should be compiled with -msse2, and likewise only
+   *_AVX2.cpp files with -mavx2. */
 
 
+// ecx is cleared before cpuid, which selects sub-leaf 0 for leaves (like 7)
+// that take one and is ignored by the others.
 #ifdef _MSC_VER
 static inline void getcpuid(int info_type, int info[4]) {
 #if defined(_WIN64)
-    __cpuid(info, info_type);
+    __cpuidex(info, info_type, 0);
 #else
     __asm {
         mov    eax, [info_type]
+        xor    ecx, ecx
         cpuid
         mov    edi, [info]
         mov    [edi], eax
@@ -52,7 +68,7 @@ static inline void getcpuid(int info_type, int info[4]) {
     asm volatile (
         "cpuid \n\t"
         : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3])
-        : "a"(info_type)
+        : "a"(info_type), "c"(0)
     );
 }
 #else
@@ -64,7 +80,7 @@ static inline void getcpuid(int info_type, int info[4]) {
         "movl %%ebx, %1   \n\t"
         "popl %%ebx       \n\t"
         : "=a"(info[0]), "=r"(info[1]), "=c"(info[2]), "=d"(info[3])
-        : "a"(info_type)
+        : "a"(info_type), "c"(0)
     );
 }
 #endif
@@ -98,6 +114,54 @@ static inline bool hasSSSE3() {
 }
 #endif
 
+/* AVX2 needs both the CPU feature bit (cpuid leaf 7) and an OS that saves the
+   YMM registers on context switch (OSXSAVE set and XCR0 enabling SSE and AVX
+   state). The xgetbv opcode is emitted by hand since older assemblers don't
+   know it. */
+static inline uint32_t getxcr0() {
+#if defined(_MSC_VER) && defined(_WIN64)
+    return (uint32_t)_xgetbv(0);
+#elif defined(_MSC_VER)
+    uint32_t xcr0;
+    __asm {
+        xor    ecx, ecx
+        _emit  0x0f
+        _emit  0x01
+        _emit  0xd0
+        mov    [xcr0], eax
+    }
+    return xcr0;
+#else
+    uint32_t eax, edx;
+    asm volatile (
+        ".byte 0x0f, 0x01, 0xd0 \n\t"
+        : "=a"(eax), "=d"(edx)
+        : "c"(0)
+    );
+    return eax;
+#endif
+}
+
+static inline bool hasAVX2() {
+    int cpu_info[4] = { 0 };
+    getcpuid(0, cpu_info);
+    if (cpu_info[0] < 7) {
+        return false;
+    }
+
+    getcpuid(1, cpu_info);
+    const int kOSXSAVEAndAVX = (1 << 27) | (1 << 28);
+    if ((cpu_info[2] & kOSXSAVEAndAVX) != kOSXSAVEAndAVX) {
+        return false;
+    }
+    if ((getxcr0() & 0x6) != 0x6) {
+        return false;
+    }
+
+    getcpuid(7, cpu_info);
+    return (cpu_info[1] & (1 << 5)) != 0;
+}
+
 static bool cachedHasSSE2() {
     static bool gHasSSE2 = hasSSE2();
     return gHasSSE2;
@@ -108,10 +172,23 @@ static bool cachedHasSSSE3() {
     return gHasSSSE3;
 }
 
+SK_CONF_DECLARE( bool, c_disable_avx2, "opts.disableAVX2", false, "Use the SSE2 procs even when the CPU supports AVX2");
+
+static bool cachedHasAVX2() {
+    static bool gHasAVX2 = hasAVX2();
+    return gHasAVX2 && !c_disable_avx2;
+}
+
 SK_CONF_DECLARE( bool, c_hqfilter_sse, "bitmap.filter.highQualitySSE", false, "Use SSE optimized version of high quality image filters");
 
 void SkBitmapProcState::platformConvolutionProcs(SkConvolutionProcs* procs) {
-    if (cachedHasSSE2()) {
+    if (cachedHasAVX2()) {
+        procs->fExtraHorizontalReads = 3;
+        procs->fConvolveVertically = &convolveVertically_AVX2;
+        procs->fConvolve4RowsHorizontally = &convolve4RowsHorizontally_AVX2;
+        procs->fConvolveHorizontally = &convolveHorizontally_AVX2;
+        procs->fApplySIMDPadding = &applySIMDPadding_SSE2;
+    } else if (cachedHasSSE2()) {
         procs->fExtraHorizontalReads = 3;
         procs->fConvolveVertically = &convolveVertically_SSE2;
         procs->fConvolve4RowsHorizontally = &convolve4RowsHorizontally_SSE2;
@@ -183,6 +260,13 @@ static SkBlitRow::Proc32 platform_32_procs[] = {
     S32A_Blend_BlitRow32_SSE2,          // S32A_Blend,
 };
 
+static SkBlitRow::Proc32 platform_32_procs_AVX2[] = {
+    NULL,                               // S32_Opaque,
+    S32_Blend_BlitRow32_AVX2,           // S32_Blend,
+    S32A_Opaque_BlitRow32_AVX2,         // S32A_Opaque
+    S32A_Blend_BlitRow32_AVX2,          // S32A_Blend,
+};
+
 SkBlitRow::Proc SkBlitRow::PlatformProcs565(unsigned flags) {
     if (cachedHasSSE2()) {
         return platform_16_procs[flags];
@@ -192,7 +276,9 @@ SkBlitRow::Proc SkBlitRow::PlatformProcs565(unsigned flags) {
 }
 
 SkBlitRow::ColorProc SkBlitRow::PlatformColorProc() {
-    if (cachedHasSSE2()) {
+    if (cachedHasAVX2()) {
+        return Color32_AVX2;
+    } else if (cachedHasSSE2()) {
         return Color32_SSE2;
     } else {
         return NULL;
@@ -200,7 +286,9 @@ SkBlitRow::ColorProc SkBlitRow::PlatformColorProc() {
 }
 
 SkBlitRow::Proc32 SkBlitRow::PlatformProcs32(unsigned flags) {
-    if (cachedHasSSE2()) {
+    if (cachedHasAVX2()) {
+        return platform_32_procs_AVX2[flags];
+    } else if (cachedHasSSE2()) {
         return platform_32_procs[flags];
     } else {
         return NULL;
@@ -298,6 +386,52 @@ bool SkBoxBlurGetPlatformProcs(SkBoxBlurProc* boxBlurX,
 #endif
 }
 
+bool SkScanAAGetPlatformProcs(SkCoverageAddProc* addProc, SkCoverageRunProc* runProc) {
+    if (!cachedHasSSE2()) {
+        return false;
+    }
+    *addProc = SkCoverageAdd_SSE2;
+    *runProc = SkCoverageRun_SSE2;
+    return true;
+}
+
+SkDownsampleRowProc SkMipMapGetPlatformProc(SkMipMapProcType type) {
+    if (!cachedHasSSE2()) {
+        return NULL;
+    }
+    switch (type) {
+        case k8888_SkMipMapProcType:
+            return SkDownsampleRow32_SSE2;
+        case k565_SkMipMapProcType:
+            return SkDownsampleRow565_SSE2;
+        case k4444_SkMipMapProcType:
+            return SkDownsampleRow4444_SSE2;
+        default:
+            return NULL;
+    }
+}
+
+SkScaledBitmapSampler::RowProc SkScaledBitmapSamplerGetPlatformProc(SkSamplerProcType type) {
+    if (!cachedHasSSE2()) {
+        return NULL;
+    }
+    const bool hasAVX2 = cachedHasAVX2();
+    switch (type) {
+        case kGray_D8888_SkSamplerProcType:
+            return Sample_Gray_D8888_SSE2;
+        case kRGB_D8888_SkSamplerProcType:
+            return cachedHasSSSE3() ? Sample_RGB_D8888_SSSE3 : NULL;
+        case kRGBX_D8888_SkSamplerProcType:
+            return hasAVX2 ? Sample_RGBX_D8888_AVX2 : Sample_RGBX_D8888_SSE2;
+        case kRGBA_D8888_SkSamplerProcType:
+            return hasAVX2 ? Sample_RGBA_D8888_AVX2 : Sample_RGBA_D8888_SSE2;
+        case kRGBA_D8888_Unpremul_SkSamplerProcType:
+            return hasAVX2 ? Sample_RGBA_D8888_Unpremul_AVX2 : Sample_RGBA_D8888_Unpremul_SSE2;
+        default:
+            return NULL;
+    }
+}
+
 SkBlitRow::ColorRectProc PlatformColorRectProcFactory(); // suppress warning
 
 SkBlitRow::ColorRectProc PlatformColorRectProcFactory() {
@@ -307,3 +441,25 @@ SkBlitRow::ColorRectProc PlatformColorRectProcFactory() {
         return NULL;
     }
 }
+
+extern SkProcCoeffXfermode* SkPlatformXfermodeFactory_impl_AVX2(const ProcCoeff& rec,
+                                                                SkXfermode::Mode mode);
+
+// The prototypes below are for Clang
+extern SkProcCoeffXfermode* SkPlatformXfermodeFactory(const ProcCoeff& rec,
+                                                      SkXfermode::Mode mode);
+
+extern SkXfermodeProc SkPlatformXfermodeProcFactory(SkXfermode::Mode mode);
+
+SkProcCoeffXfermode* SkPlatformXfermodeFactory(const ProcCoeff& rec,
+                                               SkXfermode::Mode mode) {
+    if (cachedHasAVX2()) {
+        return SkPlatformXfermodeFactory_impl_AVX2(rec, mode);
+    } else {
+        return NULL;
+    }
+}
+
+SkXfermodeProc SkPlatformXfermodeProcFactory(SkXfermode::Mode mode) {
+    return NULL;
+}
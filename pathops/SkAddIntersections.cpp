@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 #include "SkAddIntersections.h"
+#include "SkParallel.h"
 #include "SkPathOpsBounds.h"
 
 #if DEBUG_ADD_INTERSECTING_TS
@@ -174,6 +175,216 @@ static void debugShowCubicIntersection(int , const SkIntersectionHelper& ,
 }
 #endif
 
+// Finds where the segments of wt and wn intersect, which only depends on their
+// points. Sets swap if ts lists wn's t values first.
+static int intersect_segments(const SkIntersectionHelper& wt, const SkIntersectionHelper& wn,
+                              SkIntersections* ts, bool* swap) {
+    int pts = 0;
+    switch (wt.segmentType()) {
+        case SkIntersectionHelper::kHorizontalLine_Segment:
+            *swap = true;
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts->lineHorizontal(wn.pts(), wt.left(),
+                            wt.right(), wt.y(), wt.xFlipped());
+                    debugShowLineIntersection(pts, wn, wt, *ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts->quadHorizontal(wn.pts(), wt.left(),
+                            wt.right(), wt.y(), wt.xFlipped());
+                    debugShowQuadLineIntersection(pts, wn, wt, *ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    pts = ts->cubicHorizontal(wn.pts(), wt.left(),
+                            wt.right(), wt.y(), wt.xFlipped());
+                    debugShowCubicLineIntersection(pts, wn, wt, *ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kVerticalLine_Segment:
+            *swap = true;
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts->lineVertical(wn.pts(), wt.top(),
+                            wt.bottom(), wt.x(), wt.yFlipped());
+                    debugShowLineIntersection(pts, wn, wt, *ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts->quadVertical(wn.pts(), wt.top(),
+                            wt.bottom(), wt.x(), wt.yFlipped());
+                    debugShowQuadLineIntersection(pts, wn, wt, *ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    pts = ts->cubicVertical(wn.pts(), wt.top(),
+                            wt.bottom(), wt.x(), wt.yFlipped());
+                    debugShowCubicLineIntersection(pts, wn, wt, *ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kLine_Segment:
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                    pts = ts->lineHorizontal(wt.pts(), wn.left(),
+                            wn.right(), wn.y(), wn.xFlipped());
+                    debugShowLineIntersection(pts, wt, wn, *ts);
+                    break;
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                    pts = ts->lineVertical(wt.pts(), wn.top(),
+                            wn.bottom(), wn.x(), wn.yFlipped());
+                    debugShowLineIntersection(pts, wt, wn, *ts);
+                    break;
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts->lineLine(wt.pts(), wn.pts());
+                    debugShowLineIntersection(pts, wt, wn, *ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    *swap = true;
+                    pts = ts->quadLine(wn.pts(), wt.pts());
+                    debugShowQuadLineIntersection(pts, wn, wt, *ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    *swap = true;
+                    pts = ts->cubicLine(wn.pts(), wt.pts());
+                    debugShowCubicLineIntersection(pts, wn, wt, *ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kQuad_Segment:
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                    pts = ts->quadHorizontal(wt.pts(), wn.left(),
+                            wn.right(), wn.y(), wn.xFlipped());
+                    debugShowQuadLineIntersection(pts, wt, wn, *ts);
+                    break;
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                    pts = ts->quadVertical(wt.pts(), wn.top(),
+                            wn.bottom(), wn.x(), wn.yFlipped());
+                    debugShowQuadLineIntersection(pts, wt, wn, *ts);
+                    break;
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts->quadLine(wt.pts(), wn.pts());
+                    debugShowQuadLineIntersection(pts, wt, wn, *ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts->quadQuad(wt.pts(), wn.pts());
+                    debugShowQuadIntersection(pts, wt, wn, *ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    *swap = true;
+                    pts = ts->cubicQuad(wn.pts(), wt.pts());
+                    debugShowCubicQuadIntersection(pts, wn, wt, *ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kCubic_Segment:
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                    pts = ts->cubicHorizontal(wt.pts(), wn.left(),
+                            wn.right(), wn.y(), wn.xFlipped());
+                    debugShowCubicLineIntersection(pts, wt, wn, *ts);
+                    break;
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                    pts = ts->cubicVertical(wt.pts(), wn.top(),
+                            wn.bottom(), wn.x(), wn.yFlipped());
+                    debugShowCubicLineIntersection(pts, wt, wn, *ts);
+                    break;
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts->cubicLine(wt.pts(), wn.pts());
+                    debugShowCubicLineIntersection(pts, wt, wn, *ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts->cubicQuad(wt.pts(), wn.pts());
+                    debugShowCubicQuadIntersection(pts, wt, wn, *ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    pts = ts->cubicCubic(wt.pts(), wn.pts());
+                    debugShowCubicIntersection(pts, wt, wn, *ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        default:
+            SkASSERT(0);
+    }
+    return pts;
+}
+
+// Records the intersections found by intersect_segments on both segments.
+static void add_segment_ts(SkIntersectionHelper& wt, SkIntersectionHelper& wn,
+                           SkIntersections& ts, int pts, bool swap) {
+    // in addition to recording T values, record matching segment
+    if (pts == 2) {
+        if (wn.segmentType() <= SkIntersectionHelper::kLine_Segment
+                && wt.segmentType() <= SkIntersectionHelper::kLine_Segment) {
+            if (wt.addCoincident(wn, ts, swap)) {
+                return;
+            }
+            ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
+            pts = 1;
+        } else if (wn.segmentType() >= SkIntersectionHelper::kQuad_Segment
+                && wt.segmentType() >= SkIntersectionHelper::kQuad_Segment
+                && ts.isCoincident(0)) {
+            SkASSERT(ts.coincidentUsed() == 2);
+            if (wt.addCoincident(wn, ts, swap)) {
+                return;
+            }
+            ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
+            pts = 1;
+        }
+    }
+    if (pts >= 2) {
+        for (int pt = 0; pt < pts - 1; ++pt) {
+            const SkDPoint& point = ts.pt(pt);
+            const SkDPoint& next = ts.pt(pt + 1);
+            if (wt.isPartial(ts[swap][pt], ts[swap][pt + 1], point, next)
+                    && wn.isPartial(ts[!swap][pt], ts[!swap][pt + 1], point, next)) {
+                if (!wt.addPartialCoincident(wn, ts, pt, swap)) {
+                    // remove extra point if two map to same float values
+                    ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
+                    pts = 1;
+                }
+            }
+        }
+    }
+    for (int pt = 0; pt < pts; ++pt) {
+        SkASSERT(ts[0][pt] >= 0 && ts[0][pt] <= 1);
+        SkASSERT(ts[1][pt] >= 0 && ts[1][pt] <= 1);
+        SkPoint point = ts.pt(pt).asSkPoint();
+        int testTAt = wt.addT(wn, point, ts[swap][pt]);
+        int nextTAt = wn.addT(wt, point, ts[!swap][pt]);
+        wt.addOtherT(testTAt, ts[!swap][pt], nextTAt);
+        wn.addOtherT(nextTAt, ts[swap][pt], testTAt);
+    }
+}
+
 bool AddIntersectTs(SkOpContour* test, SkOpContour* next) {
     if (test != next) {
         if (AlmostLessUlps(test->bounds().fBottom, next->bounds().fTop)) {
@@ -197,211 +408,15 @@ bool AddIntersectTs(SkOpContour* test, SkOpContour* next) {
             if (!SkPathOpsBounds::Intersects(wt.bounds(), wn.bounds())) {
                 continue;
             }
-            int pts = 0;
             SkIntersections ts;
             bool swap = false;
-            switch (wt.segmentType()) {
-                case SkIntersectionHelper::kHorizontalLine_Segment:
-                    swap = true;
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.lineHorizontal(wn.pts(), wt.left(),
-                                    wt.right(), wt.y(), wt.xFlipped());
-                            debugShowLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.quadHorizontal(wn.pts(), wt.left(),
-                                    wt.right(), wt.y(), wt.xFlipped());
-                            debugShowQuadLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            pts = ts.cubicHorizontal(wn.pts(), wt.left(),
-                                    wt.right(), wt.y(), wt.xFlipped());
-                            debugShowCubicLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
-                    break;
-                case SkIntersectionHelper::kVerticalLine_Segment:
-                    swap = true;
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.lineVertical(wn.pts(), wt.top(),
-                                    wt.bottom(), wt.x(), wt.yFlipped());
-                            debugShowLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.quadVertical(wn.pts(), wt.top(),
-                                    wt.bottom(), wt.x(), wt.yFlipped());
-                            debugShowQuadLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            pts = ts.cubicVertical(wn.pts(), wt.top(),
-                                    wt.bottom(), wt.x(), wt.yFlipped());
-                            debugShowCubicLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
-                    break;
-                case SkIntersectionHelper::kLine_Segment:
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                            pts = ts.lineHorizontal(wt.pts(), wn.left(),
-                                    wn.right(), wn.y(), wn.xFlipped());
-                            debugShowLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                            pts = ts.lineVertical(wt.pts(), wn.top(),
-                                    wn.bottom(), wn.x(), wn.yFlipped());
-                            debugShowLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.lineLine(wt.pts(), wn.pts());
-                            debugShowLineIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            swap = true;
-                            pts = ts.quadLine(wn.pts(), wt.pts());
-                            debugShowQuadLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            swap = true;
-                            pts = ts.cubicLine(wn.pts(), wt.pts());
-                            debugShowCubicLineIntersection(pts, wn, wt,  ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
-                    break;
-                case SkIntersectionHelper::kQuad_Segment:
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                            pts = ts.quadHorizontal(wt.pts(), wn.left(),
-                                    wn.right(), wn.y(), wn.xFlipped());
-                            debugShowQuadLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                            pts = ts.quadVertical(wt.pts(), wn.top(),
-                                    wn.bottom(), wn.x(), wn.yFlipped());
-                            debugShowQuadLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.quadLine(wt.pts(), wn.pts());
-                            debugShowQuadLineIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.quadQuad(wt.pts(), wn.pts());
-                            debugShowQuadIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            swap = true;
-                            pts = ts.cubicQuad(wn.pts(), wt.pts());
-                            debugShowCubicQuadIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
-                    break;
-                case SkIntersectionHelper::kCubic_Segment:
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                            pts = ts.cubicHorizontal(wt.pts(), wn.left(),
-                                    wn.right(), wn.y(), wn.xFlipped());
-                            debugShowCubicLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                            pts = ts.cubicVertical(wt.pts(), wn.top(),
-                                    wn.bottom(), wn.x(), wn.yFlipped());
-                            debugShowCubicLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.cubicLine(wt.pts(), wn.pts());
-                            debugShowCubicLineIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.cubicQuad(wt.pts(), wn.pts());
-                            debugShowCubicQuadIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            pts = ts.cubicCubic(wt.pts(), wn.pts());
-                            debugShowCubicIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
-                    break;
-                default:
-                    SkASSERT(0);
-            }
+            int pts = intersect_segments(wt, wn, &ts, &swap);
             if (!foundCommonContour && pts > 0) {
                 test->addCross(next);
                 next->addCross(test);
                 foundCommonContour = true;
             }
-            // in addition to recording T values, record matching segment
-            if (pts == 2) {
-                if (wn.segmentType() <= SkIntersectionHelper::kLine_Segment
-                        && wt.segmentType() <= SkIntersectionHelper::kLine_Segment) {
-                    if (wt.addCoincident(wn, ts, swap)) {
-                        continue;
-                    }
-                    ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
-                    pts = 1;
-                } else if (wn.segmentType() >= SkIntersectionHelper::kQuad_Segment
-                        && wt.segmentType() >= SkIntersectionHelper::kQuad_Segment
-                        && ts.isCoincident(0)) {
-                    SkASSERT(ts.coincidentUsed() == 2);
-                    if (wt.addCoincident(wn, ts, swap)) {
-                        continue;
-                    }
-                    ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
-                    pts = 1;
-                }
-            }
-            if (pts >= 2) {
-                for (int pt = 0; pt < pts - 1; ++pt) {
-                    const SkDPoint& point = ts.pt(pt);
-                    const SkDPoint& next = ts.pt(pt + 1);
-                    if (wt.isPartial(ts[swap][pt], ts[swap][pt + 1], point, next)
-                            && wn.isPartial(ts[!swap][pt], ts[!swap][pt + 1], point, next)) {
-                        if (!wt.addPartialCoincident(wn, ts, pt, swap)) {
-                            // remove extra point if two map to same float values
-                            ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
-                            pts = 1;
-                        }
-                    }
-                }
-            }
-            for (int pt = 0; pt < pts; ++pt) {
-                SkASSERT(ts[0][pt] >= 0 && ts[0][pt] <= 1);
-                SkASSERT(ts[1][pt] >= 0 && ts[1][pt] <= 1);
-                SkPoint point = ts.pt(pt).asSkPoint();
-                int testTAt = wt.addT(wn, point, ts[swap][pt]);
-                int nextTAt = wn.addT(wt, point, ts[!swap][pt]);
-                wt.addOtherT(testTAt, ts[!swap][pt], nextTAt);
-                wn.addOtherT(nextTAt, ts[swap][pt], testTAt);
-            }
+            add_segment_ts(wt, wn, ts, pts, swap);
         } while (wn.advance());
     } while (wt.advance());
     return true;
@@ -431,6 +446,150 @@ void AddSelfIntersectTs(SkOpContour* test) {
     } while (wt.advance());
 }
 
+// Below this many segments, finding intersections on other threads does not
+// pay for recording them first.
+static const int kMinParallelSegments = 256;
+// The test contour of a pair is split into ranges of this many segments, so
+// that a pair of big contours is spread over several threads.
+static const int kSegmentsPerWorkItem = 32;
+
+namespace {
+struct SegmentHit {
+    int fTestIndex;
+    int fNextIndex;
+    int fPts;
+    bool fSwap;
+    SkIntersections fTs;
+};
+
+// The intersections of segments [fStart, fStop) of fTest with fNext.
+struct IntersectWorkItem {
+    SkOpContour* fTest;
+    SkOpContour* fNext;
+    int fStart;
+    int fStop;
+    SkTArray<SegmentHit, true> fHits;
+};
+}  // namespace
+
+// Like AddIntersectTs, but only finds the intersections, which does not
+// change the contours, so work items can run concurrently.
+static void find_intersect_ts(void* context, int index) {
+    IntersectWorkItem& item = (*static_cast<SkTArray<IntersectWorkItem>*>(context))[index];
+    SkIntersectionHelper wt;
+    for (int tIndex = item.fStart; tIndex < item.fStop; ++tIndex) {
+        wt.init(item.fTest, tIndex);
+        SkIntersectionHelper wn;
+        wn.init(item.fNext);
+        if (item.fTest == item.fNext && !wn.startAfter(wt)) {
+            continue;
+        }
+        do {
+            if (!SkPathOpsBounds::Intersects(wt.bounds(), wn.bounds())) {
+                continue;
+            }
+            SkIntersections ts;
+            bool swap = false;
+            int pts = intersect_segments(wt, wn, &ts, &swap);
+            if (pts > 0) {
+                SegmentHit& hit = item.fHits.push_back();
+                hit.fTestIndex = tIndex;
+                hit.fNextIndex = wn.index();
+                hit.fPts = pts;
+                hit.fSwap = swap;
+                hit.fTs = ts;
+            }
+        } while (wn.advance());
+    }
+}
+
+static void add_work_item_ts(IntersectWorkItem& item, bool* foundCommonContour) {
+    for (int index = 0; index < item.fHits.count(); ++index) {
+        SegmentHit& hit = item.fHits[index];
+        if (!*foundCommonContour) {
+            item.fTest->addCross(item.fNext);
+            item.fNext->addCross(item.fTest);
+            *foundCommonContour = true;
+        }
+        SkIntersectionHelper wt;
+        wt.init(item.fTest, hit.fTestIndex);
+        SkIntersectionHelper wn;
+        wn.init(item.fNext, hit.fNextIndex);
+        add_segment_ts(wt, wn, hit.fTs, hit.fPts, hit.fSwap);
+    }
+}
+
+// find all intersections between segments
+void AddAllIntersectTs(SkTArray<SkOpContour*, true>* contourList) {
+    int contourCount = (*contourList).count();
+    int total = 0;
+    for (int cIndex = 0; cIndex < contourCount; ++cIndex) {
+        total += (*contourList)[cIndex]->segments().count();
+    }
+    if (SkParallel::Concurrency() <= 1 || total < kMinParallelSegments) {
+        for (int cIndex = 0; cIndex < contourCount; ++cIndex) {
+            SkOpContour* current = (*contourList)[cIndex];
+            if (current->containsCubics()) {
+                AddSelfIntersectTs(current);
+            }
+            for (int nIndex = cIndex; nIndex < contourCount; ++nIndex) {
+                if (!AddIntersectTs(current, (*contourList)[nIndex])) {
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
+    // Contours are sorted by their tops, so each one only needs to be swept
+    // against the ones that follow it until one starts below its bottom. The
+    // pairs whose bounds intersect become work items, in the order
+    // AddIntersectTs would visit them.
+    SkTArray<IntersectWorkItem> items;
+    for (int cIndex = 0; cIndex < contourCount; ++cIndex) {
+        SkOpContour* current = (*contourList)[cIndex];
+        int segmentCount = current->segments().count();
+        for (int nIndex = cIndex; nIndex < contourCount; ++nIndex) {
+            SkOpContour* next = (*contourList)[nIndex];
+            if (current != next) {
+                if (AlmostLessUlps(current->bounds().fBottom, next->bounds().fTop)) {
+                    break;
+                }
+                if (!SkPathOpsBounds::Intersects(current->bounds(), next->bounds())) {
+                    continue;
+                }
+            }
+            for (int start = 0; start < segmentCount; start += kSegmentsPerWorkItem) {
+                IntersectWorkItem& item = items.push_back();
+                item.fTest = current;
+                item.fNext = next;
+                item.fStart = start;
+                item.fStop = SkMin32(start + kSegmentsPerWorkItem, segmentCount);
+            }
+        }
+    }
+    SkParallel::For(items.count(), find_intersect_ts, &items);
+
+    // Adding the Ts in that same order gives the same contours as the serial
+    // loop above.
+    int itemIndex = 0;
+    for (int cIndex = 0; cIndex < contourCount; ++cIndex) {
+        SkOpContour* current = (*contourList)[cIndex];
+        if (current->containsCubics()) {
+            AddSelfIntersectTs(current);
+        }
+        while (itemIndex < items.count() && items[itemIndex].fTest == current) {
+            SkOpContour* next = items[itemIndex].fNext;
+            bool foundCommonContour = current == next;
+            do {
+                add_work_item_ts(items[itemIndex], &foundCommonContour);
+            } while (++itemIndex < items.count() && items[itemIndex].fTest == current
+                    && items[itemIndex].fNext == next);
+        }
+    }
+    SkASSERT(itemIndex == items.count());
+}
+
 // resolve any coincident pairs found while intersecting, and
 // see if coincidence is formed by clipping non-concident segments
 void CoincidenceCheck(SkTArray<SkOpContour*, true>* contourList, int total) {
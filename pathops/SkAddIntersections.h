@@ -13,6 +13,7 @@
 
 bool AddIntersectTs(SkOpContour* test, SkOpContour* next);
 void AddSelfIntersectTs(SkOpContour* test);
+void AddAllIntersectTs(SkTArray<SkOpContour*, true>* contourList);
 void CoincidenceCheck(SkTArray<SkOpContour*, true>* contourList, int total);
 
 #endif
@@ -62,9 +62,17 @@ public:
         return fContour->segments()[fIndex].bounds();
     }
 
+    int index() const {
+        return fIndex;
+    }
+
     void init(SkOpContour* contour) {
+        init(contour, 0);
+    }
+
+    void init(SkOpContour* contour, int index) {
         fContour = contour;
-        fIndex = 0;
+        fIndex = index;
         fLast = contour->segments().count();
     }
 
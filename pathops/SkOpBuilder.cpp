@@ -0,0 +1,153 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "SkGeometry.h"
+#include "SkOpBuilder.h"
+
+void SkOpBuilder::add(const SkPath& path, SkPathOp op) {
+    fPaths.push_back(path);
+    *fOps.append() = op;
+}
+
+void SkOpBuilder::reset() {
+    fPaths.reset();
+    fOps.reset();
+}
+
+// Returns a point halfway along the first curve of the contour. Contours of a
+// simplified path only touch at their ends, so no other contour goes through it.
+static bool contour_inner_point(const SkPath& contour, SkPoint* pt) {
+    SkPath::Iter iter(contour, false);
+    SkPoint pts[4];
+    SkPath::Verb verb;
+    while ((verb = iter.next(pts)) != SkPath::kDone_Verb) {
+        switch (verb) {
+            case SkPath::kLine_Verb:
+                pt->set(SkScalarAve(pts[0].fX, pts[1].fX), SkScalarAve(pts[0].fY, pts[1].fY));
+                return true;
+            case SkPath::kQuad_Verb:
+                SkEvalQuadAt(pts, SK_ScalarHalf, pt);
+                return true;
+            case SkPath::kConic_Verb: {
+                SkConic conic;
+                conic.set(pts, iter.conicWeight());
+                conic.evalAt(SK_ScalarHalf, pt);
+                return true;
+            }
+            case SkPath::kCubic_Verb:
+                SkEvalCubicAt(pts, SK_ScalarHalf, pt, NULL, NULL);
+                return true;
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+// Appends the contours of a simplified path to sum, turned so that the ones
+// inside an even number of the others (outlines) wind clockwise, and the rest
+// (holes) counterclockwise. Every point inside the path then adds one to its
+// winding in sum, and every point outside adds nothing.
+static void add_with_common_winding(const SkPath& path, SkPath* sum) {
+    SkTArray<SkPath> contours;
+    SkPath::Iter iter(path, false);
+    SkPoint pts[4];
+    SkPath::Verb verb;
+    while ((verb = iter.next(pts)) != SkPath::kDone_Verb) {
+        switch (verb) {
+            case SkPath::kMove_Verb:
+                contours.push_back().moveTo(pts[0]);
+                break;
+            case SkPath::kLine_Verb:
+                contours.back().lineTo(pts[1]);
+                break;
+            case SkPath::kQuad_Verb:
+                contours.back().quadTo(pts[1], pts[2]);
+                break;
+            case SkPath::kConic_Verb:
+                contours.back().conicTo(pts[1], pts[2], iter.conicWeight());
+                break;
+            case SkPath::kCubic_Verb:
+                contours.back().cubicTo(pts[1], pts[2], pts[3]);
+                break;
+            case SkPath::kClose_Verb:
+                contours.back().close();
+                break;
+            default:
+                SkDEBUGFAIL("unknown verb");
+        }
+    }
+    for (int index = 0; index < contours.count(); ++index) {
+        const SkPath& contour = contours[index];
+        SkPath::Direction dir;
+        SkPoint pt;
+        if (!contour.cheapComputeDirection(&dir) || !contour_inner_point(contour, &pt)) {
+            continue;  // encloses nothing
+        }
+        int depth = 0;
+        for (int other = 0; other < contours.count(); ++other) {
+            if (other != index && contours[other].contains(pt.fX, pt.fY)) {
+                ++depth;
+            }
+        }
+        if ((depth & 1 ? SkPath::kCCW_Direction : SkPath::kCW_Direction) == dir) {
+            sum->addPath(contour);
+        } else {
+            sum->reverseAddPath(contour);
+        }
+    }
+}
+
+bool SkOpBuilder::resolve(SkPath* result) {
+    const int count = fOps.count();
+    bool allUnion = true;
+    for (int index = 0; index < count; ++index) {
+        if (kUnion_PathOp != fOps[index] || fPaths[index].isInverseFillType()) {
+            allUnion = false;
+            break;
+        }
+    }
+    SkPath combined;
+    bool success = true;
+    if (allUnion) {
+        // The union is wherever the sum of the paths, each winding once
+        // around its inside, has a nonzero winding.
+        SkPath sum;
+        for (int index = 0; index < count; ++index) {
+            const SkPath& path = fPaths[index];
+            if (path.isConvex()) {
+                SkPath::Direction dir;
+                if (!path.cheapComputeDirection(&dir)) {
+                    continue;  // encloses nothing
+                }
+                if (SkPath::kCW_Direction == dir) {
+                    sum.addPath(path);
+                } else {
+                    sum.reverseAddPath(path);
+                }
+                continue;
+            }
+            SkPath simple;
+            if (!Simplify(path, &simple)) {
+                success = false;
+                break;
+            }
+            add_with_common_winding(simple, &sum);
+        }
+        success = success && Simplify(sum, &combined);
+    } else {
+        for (int index = 0; index < count && success; ++index) {
+            SkPath next;
+            success = Op(combined, fPaths[index], fOps[index], &next);
+            combined.swap(next);
+        }
+    }
+    this->reset();
+    if (success) {
+        result->swap(combined);
+    }
+    return success;
+}
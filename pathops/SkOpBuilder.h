@@ -0,0 +1,44 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#ifndef SkOpBuilder_DEFINED
+#define SkOpBuilder_DEFINED
+
+#include "SkPath.h"
+#include "SkPathOps.h"
+#include "SkTArray.h"
+#include "SkTDArray.h"
+
+/** \class SkOpBuilder
+
+    Combines any number of paths with the PathOps boolean operators. Each
+    path is added with the operator that applies it to the combination of
+    the paths added before it, starting from an empty path.
+
+    When every operator is kUnion_PathOp and no path is inverse filled, the
+    paths are given a common winding and simplified together, so the edges
+    of all of them are built and intersected once, instead of once for each
+    Op() call. Otherwise resolve() calls Op() for each path in turn.
+*/
+class SK_API SkOpBuilder {
+public:
+    /** Add a path, combined with the paths added before it by op. */
+    void add(const SkPath& path, SkPathOp op);
+
+    /** Set result to the combination of all the added paths, and empty the
+        builder. Returns false, leaving result unchanged, if the paths could
+        not be combined.
+    */
+    bool resolve(SkPath* result);
+
+private:
+    void reset();
+
+    SkTArray<SkPath> fPaths;
+    SkTDArray<SkPathOp> fOps;
+};
+
+#endif
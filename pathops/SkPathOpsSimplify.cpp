@@ -163,25 +163,12 @@ bool Simplify(const SkPath& path, SkPath* result) {
     }
     SkTArray<SkOpContour*, true> contourList;
     MakeContourList(contours, contourList, false, false);
-    SkOpContour** currentPtr = contourList.begin();
     result->reset();
     result->setFillType(fillType);
-    if (!currentPtr) {
+    if (contourList.count() == 0) {
         return true;
     }
-    SkOpContour** listEnd = contourList.end();
-    // find all intersections between segments
-    do {
-        SkOpContour** nextPtr = currentPtr;
-        SkOpContour* current = *currentPtr++;
-        if (current->containsCubics()) {
-            AddSelfIntersectTs(current);
-        }
-        SkOpContour* next;
-        do {
-            next = *nextPtr++;
-        } while (AddIntersectTs(current, next) && nextPtr != listEnd);
-    } while (currentPtr != listEnd);
+    AddAllIntersectTs(&contourList);
     HandleCoincidence(&contourList, 0);
     // construct closed contours
     SkPathWriter simple(*result);
@@ -8,6 +8,7 @@
 
 
 #include "SkPDFCatalog.h"
+#include "SkParallel.h"
 #include "SkPDFTypes.h"
 #include "SkStream.h"
 #include "SkTypes.h"
@@ -28,7 +29,11 @@ SkPDFObject* SkPDFCatalog::addObject(SkPDFObject* obj, bool onFirstPage) {
     if (findObjectIndex(obj) != -1) {  // object already added
         return obj;
     }
-    SkASSERT(fNextFirstPageObjNum == 0);
+    // Once object numbers are being handed out, objects can only be added
+    // when there are no first page objects, whose numbers depend on the
+    // final object count (see SkPDFStreamingDocument).
+    SkASSERT(fNextFirstPageObjNum == 0 ||
+             (fFirstPageCount == 0 && !onFirstPage));
     if (onFirstPage) {
         fFirstPageCount++;
     }
@@ -39,12 +44,15 @@ SkPDFObject* SkPDFCatalog::addObject(SkPDFObject* obj, bool onFirstPage) {
 }
 
 size_t SkPDFCatalog::setFileOffset(SkPDFObject* obj, off_t offset) {
+    recordFileOffset(obj, offset);
+    return getSubstituteObject(obj)->getOutputSize(this, true);
+}
+
+void SkPDFCatalog::recordFileOffset(SkPDFObject* obj, off_t offset) {
     int objIndex = assignObjNum(obj) - 1;
     SkASSERT(fCatalog[objIndex].fObjNumAssigned);
     SkASSERT(fCatalog[objIndex].fFileOffset == 0);
     fCatalog[objIndex].fFileOffset = offset;
-
-    return getSubstituteObject(obj)->getOutputSize(this, true);
 }
 
 void SkPDFCatalog::emitObjectNumber(SkWStream* stream, SkPDFObject* obj) {
@@ -213,3 +221,35 @@ SkTSet<SkPDFObject*>* SkPDFCatalog::getSubstituteList(bool firstPage) {
     return firstPage ? &fSubstituteResourcesFirstPage :
                        &fSubstituteResourcesRemaining;
 }
+
+namespace {
+
+struct PreflightRec {
+    SkPDFObject* const* fObjects;
+    SkPDFCatalog*       fCatalog;
+};
+
+}  // namespace
+
+static void preflight_object(void* context, int index) {
+    PreflightRec* rec = static_cast<PreflightRec*>(context);
+    SkPDFCatalog* catalog = rec->fCatalog;
+    catalog->getSubstituteObject(rec->fObjects[index])->preflight(catalog);
+}
+
+void SkPDFCatalog::preflightObjects() {
+    // A set, so that no object is preflighted on two threads at once.
+    SkTSet<SkPDFObject*> objects;
+    for (int i = 0; i < fCatalog.count(); i++) {
+        objects.add(getSubstituteObject(fCatalog[i].fObject));
+    }
+    objects.mergeInto(fSubstituteResourcesFirstPage);
+    objects.mergeInto(fSubstituteResourcesRemaining);
+
+    this->preflightObjects(objects.begin(), objects.count());
+}
+
+void SkPDFCatalog::preflightObjects(SkPDFObject* const objects[], int count) {
+    PreflightRec rec = { objects, this };
+    SkParallel::For(count, preflight_object, &rec);
+}
@@ -44,6 +44,13 @@ public:
      */
     size_t setFileOffset(SkPDFObject* obj, off_t offset);
 
+    /** Like setFileOffset(), for an object that is about to be written at
+     *  offset, so that its size doesn't need to be computed.
+     *  @param obj         The object to add.
+     *  @param offset      The byte offset in the output stream of this object.
+     */
+    void recordFileOffset(SkPDFObject* obj, off_t offset);
+
     /** Output the object number for the passed object.
      *  @param obj         The object of interest.
      *  @param stream      The writable output stream to send the output to.
@@ -88,6 +95,26 @@ public:
      */
     void emitSubstituteResources(SkWStream* stream, bool firstPage);
 
+    /** Return the resources of substitute objects, which setSubstitute()
+     *  added to the catalog.
+     */
+    const SkTSet<SkPDFObject*>& getSubstituteResources(bool firstPage) {
+        return *getSubstituteList(firstPage);
+    }
+
+    /** Call preflight() on every object that will be emitted, spread over
+     *  the threads available through SkParallel. Doing this before the
+     *  file offsets are computed moves all of the compression work out of
+     *  the serial offset and emit passes. Object numbers and output are
+     *  the same as without it.
+     */
+    void preflightObjects();
+
+    /** Call preflight() on the passed objects (or their substitutes) like
+     *  preflightObjects() does. The objects must all be different.
+     */
+    void preflightObjects(SkPDFObject* const objects[], int count);
+
 private:
     struct Rec {
         Rec(SkPDFObject* object, bool onFirstPage)
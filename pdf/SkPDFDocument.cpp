@@ -159,6 +159,9 @@ bool SkPDFDocument::emitPDF(SkWStream* stream) {
         // Build font subsetting info before proceeding.
         perform_font_subsetting(fCatalog.get(), fPages, &fSubstitutes);
 
+        // Compress streams and encode images on all available threads.
+        fCatalog->preflightObjects();
+
         // Figure out the size of things and inform the catalog of file offsets.
         off_t fileOffset = headerSize();
         fileOffset += fCatalog->setFileOffset(fDocCatalog, fileOffset);
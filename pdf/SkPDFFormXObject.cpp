@@ -93,3 +93,10 @@ void SkPDFFormXObject::getResources(
                        knownResourceObjects,
                        newResourceObjects);
 }
+
+void SkPDFFormXObject::releaseContent() {
+    INHERITED::releaseContent();
+    // Let the resources that only this form used be released in turn.
+    fResources.unrefAll();
+    fResources.reset();
+}
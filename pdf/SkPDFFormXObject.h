@@ -50,12 +50,15 @@ public:
     // The SkPDFObject interface.
     virtual void getResources(const SkTSet<SkPDFObject*>& knownResourceObjects,
                               SkTSet<SkPDFObject*>* newResourceObjects);
+    virtual void releaseContent();
 
 private:
     void init(const char* colorSpace,
               SkPDFDict* resourceDict, SkPDFArray* bbox);
 
     SkTSet<SkPDFObject*> fResources;
+
+    typedef SkPDFStream INHERITED;
 };
 
 #endif
@@ -495,6 +495,14 @@ void SkPDFImage::getResources(const SkTSet<SkPDFObject*>& knownResourceObjects,
     GetResourcesHelper(&fResources, knownResourceObjects, newResourceObjects);
 }
 
+void SkPDFImage::releaseContent() {
+    INHERITED::releaseContent();
+    fBitmap.reset();
+    // Drop the mask too, so that it can be released in turn.
+    fResources.unrefAll();
+    fResources.reset();
+}
+
 SkPDFImage::SkPDFImage(SkStream* stream,
                        const SkBitmap& bitmap,
                        bool isAlpha,
@@ -56,6 +56,7 @@ public:
     // The SkPDFObject interface.
     virtual void getResources(const SkTSet<SkPDFObject*>& knownResourceObjects,
                               SkTSet<SkPDFObject*>* newResourceObjects);
+    virtual void releaseContent();
 
 private:
     SkBitmap fBitmap;
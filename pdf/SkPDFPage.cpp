@@ -153,6 +153,16 @@ const SkPDFGlyphSetMap& SkPDFPage::getFontGlyphUsage() const {
     return fDevice->getFontGlyphUsage();
 }
 
+void SkPDFPage::releaseContent() {
+    // This also drops the Parent entry, which ties the page into a cycle
+    // with the page tree.
+    this->clear();
+    if (fContentStream.get() != NULL) {
+        fContentStream->releaseContent();
+    }
+    fDevice.reset(NULL);
+}
+
 void SkPDFPage::appendDestinations(SkPDFDict* dict) {
     fDevice->appendDestinations(dict, this);
 }
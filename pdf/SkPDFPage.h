@@ -71,6 +71,11 @@ public:
      */
     void emitPage(SkWStream* stream, SkPDFCatalog* catalog);
 
+    /** Return the stream holding the page content.  This is NULL until
+     *  finalizePage has been called.
+     */
+    SkPDFStream* getContentStream() const { return fContentStream.get(); }
+
     /** Generate a page tree for the passed vector of pages.  New objects are
      *  added to the catalog.  The pageTree vector is populated with all of
      *  the 'Pages' dictionaries as well as the 'Page' objects.  Page trees
@@ -97,6 +102,12 @@ public:
      */
     const SkPDFGlyphSetMap& getFontGlyphUsage() const;
 
+    /** Drop the page's device and content once the page has been emitted
+     *  with emitObject() and emitPage().  None of the other methods can be
+     *  used after this.
+     */
+    virtual void releaseContent();
+
 private:
     // Multiple pages may reference the content.
     SkAutoTUnref<SkPDFDevice> fDevice;
@@ -546,6 +546,9 @@ public:
         return fColorShader.get() != NULL;
     }
 
+    // Shaders are canonicalized, so another document may reuse this one.
+    virtual void releaseContent() {}
+
 private:
     SkAutoTDelete<const SkPDFShader::State> fState;
 
@@ -574,6 +577,10 @@ public:
 
     virtual bool isValid() { return size() > 0; }
 
+    // Shaders are canonicalized, so another document may reuse this one.
+    // Clearing the dictionary would also keep isValid() from unregistering it.
+    virtual void releaseContent() {}
+
     void getResources(const SkTSet<SkPDFObject*>& knownResourceObjects,
                       SkTSet<SkPDFObject*>* newResourceObjects) {
         GetResourcesHelper(&fResources.toArray(),
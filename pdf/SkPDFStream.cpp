@@ -78,6 +78,24 @@ size_t SkPDFStream::getOutputSize(SkPDFCatalog* catalog, bool indirect) {
         strlen(" stream\n\nendstream") + fData->getLength();
 }
 
+void SkPDFStream::preflight(SkPDFCatalog* catalog) {
+    // Compress now. A stream that was already populated is left alone, since
+    // populate() may then need to register a substitute with the catalog.
+    if (fState == kUnused_State) {
+        this->populate(catalog);
+    }
+}
+
+void SkPDFStream::releaseContent() {
+    this->clear();
+    fData.reset(NULL);
+    // The catalog maps this stream to its substitute by pointer for as long
+    // as it lives, so only the substitute's data can go.
+    if (fSubstitute.get()) {
+        fSubstitute->releaseContent();
+    }
+}
+
 SkPDFStream::SkPDFStream() : fState(kUnused_State) {}
 
 void SkPDFStream::setData(SkData* data) {
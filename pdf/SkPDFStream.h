@@ -45,6 +45,8 @@ public:
     virtual void emitObject(SkWStream* stream, SkPDFCatalog* catalog,
                             bool indirect);
     virtual size_t getOutputSize(SkPDFCatalog* catalog, bool indirect);
+    virtual void preflight(SkPDFCatalog* catalog);
+    virtual void releaseContent();
 
 protected:
     enum State {
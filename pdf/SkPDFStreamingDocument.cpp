@@ -0,0 +1,280 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkPDFStreamingDocument.h"
+#include "SkPDFCatalog.h"
+#include "SkPDFDevice.h"
+#include "SkPDFDocument.h"
+#include "SkPDFPage.h"
+#include "SkPDFStream.h"
+#include "SkStream.h"
+
+// Same as SkPDFPage::GeneratePageTree.
+static const int kPageTreeNodeSize = 8;
+
+static void emit_header(SkWStream* stream) {
+    stream->writeText("%PDF-1.4\n%");
+    // The PDF spec recommends including a comment with four bytes, all
+    // with their high bits set.  This is "Skia" with the high bits set.
+    stream->write32(0xD3EBE9E1);
+    stream->writeText("\n");
+}
+
+SkPDFStreamingDocument::SkPDFStreamingDocument(SkWStream* stream)
+        : fStream(stream),
+          fStartOffset(0),
+          fClosed(false),
+          fPageCount(0),
+          fCurrentKids(NULL) {
+    // All objects are numbered in the order they are written, so nothing
+    // goes in the first page section of the catalog.
+    fCatalog.reset(new SkPDFCatalog(static_cast<SkPDFDocument::Flags>(0)));
+    fDocCatalog = SkNEW_ARGS(SkPDFDict, ("Catalog"));
+    fCatalog->addObject(fDocCatalog, false);
+    fDests.reset(SkNEW(SkPDFDict));
+}
+
+SkPDFStreamingDocument::~SkPDFStreamingDocument() {
+    // Page tree nodes have both child and parent pointers.  The pages were
+    // cleared when they were written, but the nodes must be cleared here to
+    // break the reference cycles.
+    for (int i = 0; i < fPageTree.count(); i++) {
+        fPageTree[i]->clear();
+    }
+    fPageTree.unrefAll();
+
+    fResources.unrefAll();
+    fSubstitutes.unrefAll();
+    fDocCatalog->unref();
+}
+
+bool SkPDFStreamingDocument::appendPage(SkPDFDevice* pdfDevice) {
+    if (fClosed) {
+        return false;
+    }
+    if (0 == fPageCount) {
+        fStartOffset = fStream->bytesWritten();
+        emit_header(fStream);
+    }
+    fPageCount++;
+
+    // The previous page's device is gone by now, so more of its resources
+    // may be unused.
+    this->releaseUnusedResources();
+
+    SkAutoTUnref<SkPDFPage> page(SkNEW_ARGS(SkPDFPage, (pdfDevice)));
+    SkPDFDict* parent = this->addToPageTree(page.get());
+    page->insert("Parent", SkNEW_ARGS(SkPDFObjRef, (parent)))->unref();
+
+    SkTSet<SkPDFObject*> newResources;
+    page->finalizePage(fCatalog.get(), false, fResources, &newResources);
+    fCatalog->addObject(page.get(), false);
+    for (int i = 0; i < newResources.count(); i++) {
+        fCatalog->addObject(newResources[i], false);
+    }
+    fGlyphUsage.merge(page->getFontGlyphUsage());
+    page->appendDestinations(fDests.get());
+    this->deferFonts(page->getFontGlyphUsage(), newResources);
+
+    SkTDArray<SkPDFObject*> objects;
+    objects.push(page.get());
+    objects.push(page->getContentStream());
+    int firstResource = objects.count();
+    for (int i = 0; i < newResources.count(); i++) {
+        if (!fFonts.contains(newResources[i])) {
+            objects.push(newResources[i]);
+        }
+    }
+    // mergeInto returns the number of duplicates.
+    // If there are duplicates, there is a bug and we mess ref counting.
+    SkDEBUGCODE(int duplicates =) fResources.mergeInto(newResources);
+    SkASSERT(duplicates == 0);
+
+    fCatalog->preflightObjects(objects.begin(), objects.count());
+    for (int i = 0; i < objects.count(); i++) {
+        this->writeObject(objects[i]);
+    }
+
+    page->releaseContent();
+    fUnreleased.append(objects.count() - firstResource,
+                       objects.begin() + firstResource);
+    return true;
+}
+
+bool SkPDFStreamingDocument::close() {
+    if (fClosed) {
+        return false;
+    }
+    fClosed = true;
+    if (0 == fPageCount) {
+        return false;
+    }
+    this->releaseUnusedResources();
+
+    // Every glyph the fonts need is known now, so they can be subset.
+    SkPDFGlyphSetMap::F2BIter iterator(fGlyphUsage);
+    const SkPDFGlyphSetMap::FontGlyphSetPair* entry = iterator.next();
+    while (entry) {
+        if (fFonts.contains(entry->fFont)) {
+            SkPDFFont* subsetFont =
+                entry->fFont->getFontSubset(entry->fGlyphSet);
+            if (subsetFont) {
+                fCatalog->setSubstitute(entry->fFont, subsetFont);
+                fSubstitutes.push(subsetFont);  // Transfer ownership.
+            }
+        }
+        entry = iterator.next();
+    }
+
+    SkPDFDict* pageTreeRoot = this->finishPageTree();
+    fDocCatalog->insert("Pages", SkNEW_ARGS(SkPDFObjRef, (pageTreeRoot)))->unref();
+
+    SkTDArray<SkPDFObject*> objects;
+    objects.append(fFonts.count(), fFonts.begin());
+    const SkTSet<SkPDFObject*>& substituteResources =
+        fCatalog->getSubstituteResources(false);
+    objects.append(substituteResources.count(), substituteResources.begin());
+    fCatalog->preflightObjects(objects.begin(), objects.count());
+
+    for (int i = 0; i < fPageTree.count(); i++) {
+        objects.push(fPageTree[i]);
+    }
+    if (fDests->size() > 0) {
+        fCatalog->addObject(fDests.get(), false);
+        fDocCatalog->insert("Dests", SkNEW_ARGS(SkPDFObjRef, (fDests.get())))->unref();
+        objects.push(fDests.get());
+    }
+    objects.push(fDocCatalog);
+
+    for (int i = 0; i < objects.count(); i++) {
+        this->writeObject(objects[i]);
+    }
+
+    off_t xRefFileOffset = this->getOffset();
+    int64_t objCount = fCatalog->emitXrefTable(fStream, false);
+
+    SkAutoTUnref<SkPDFDict> trailerDict(SkNEW(SkPDFDict));
+    trailerDict->insertInt("Size", int(objCount));
+    trailerDict->insert("Root", SkNEW_ARGS(SkPDFObjRef, (fDocCatalog)))->unref();
+
+    fStream->writeText("trailer\n");
+    trailerDict->emitObject(fStream, fCatalog.get(), false);
+    fStream->writeText("\nstartxref\n");
+    fStream->writeBigDecAsText(xRefFileOffset);
+    fStream->writeText("\n%%EOF");
+    return true;
+}
+
+off_t SkPDFStreamingDocument::getOffset() const {
+    return (off_t)(fStream->bytesWritten() - fStartOffset);
+}
+
+void SkPDFStreamingDocument::writeObject(SkPDFObject* obj) {
+    fCatalog->recordFileOffset(obj, this->getOffset());
+    obj->emit(fStream, fCatalog.get(), true);
+}
+
+SkPDFDict* SkPDFStreamingDocument::addToPageTree(SkPDFPage* page) {
+    // Pages are put in nodes of kPageTreeNodeSize as they come.  The rest of
+    // the tree is built over those nodes by finishPageTree().
+    if (NULL == fCurrentKids || fCurrentKids->size() == kPageTreeNodeSize) {
+        SkPDFDict* node = SkNEW_ARGS(SkPDFDict, ("Pages"));
+        fCurrentKids = SkNEW(SkPDFArray);
+        fCurrentKids->reserve(kPageTreeNodeSize);
+        node->insert("Kids", fCurrentKids)->unref();
+        fCatalog->addObject(node, false);
+        fPageTree.push(node);  // Transfer reference.
+    }
+    fCurrentKids->append(SkNEW_ARGS(SkPDFObjRef, (page)))->unref();
+    return fPageTree.top();
+}
+
+SkPDFDict* SkPDFStreamingDocument::finishPageTree() {
+    // Like SkPDFPage::GeneratePageTree, but the bottom level nodes already
+    // exist.  A last node that would be the only child of a new node is
+    // moved up a level instead.
+    SkTDArray<SkPDFDict*> curNodes;
+    SkTDArray<int> curCounts;
+    for (int i = 0; i < fPageTree.count(); i++) {
+        int count = SkMin32(fPageCount - i * kPageTreeNodeSize,
+                            kPageTreeNodeSize);
+        fPageTree[i]->insertInt("Count", count);
+        curNodes.push(fPageTree[i]);
+        curCounts.push(count);
+    }
+
+    SkTDArray<SkPDFDict*> nextRoundNodes;
+    SkTDArray<int> nextRoundCounts;
+    while (curNodes.count() > 1) {
+        for (int i = 0; i < curNodes.count(); ) {
+            if (i > 0 && i + 1 == curNodes.count()) {
+                nextRoundNodes.push(curNodes[i]);
+                nextRoundCounts.push(curCounts[i]);
+                break;
+            }
+
+            SkPDFDict* newNode = SkNEW_ARGS(SkPDFDict, ("Pages"));
+            SkAutoTUnref<SkPDFObjRef> newNodeRef(SkNEW_ARGS(SkPDFObjRef, (newNode)));
+            SkAutoTUnref<SkPDFArray> kids(SkNEW(SkPDFArray));
+            kids->reserve(kPageTreeNodeSize);
+
+            int pageCount = 0;
+            for (int j = 0; j < kPageTreeNodeSize && i < curNodes.count(); j++, i++) {
+                curNodes[i]->insert("Parent", newNodeRef.get());
+                kids->append(SkNEW_ARGS(SkPDFObjRef, (curNodes[i])))->unref();
+                pageCount += curCounts[i];
+            }
+            newNode->insertInt("Count", pageCount);
+            newNode->insert("Kids", kids.get());
+
+            fCatalog->addObject(newNode, false);
+            fPageTree.push(newNode);  // Transfer reference.
+            nextRoundNodes.push(newNode);
+            nextRoundCounts.push(pageCount);
+        }
+
+        curNodes = nextRoundNodes;
+        curCounts = nextRoundCounts;
+        nextRoundNodes.rewind();
+        nextRoundCounts.rewind();
+    }
+    return curNodes[0];
+}
+
+void SkPDFStreamingDocument::deferFonts(const SkPDFGlyphSetMap& usage,
+                                        const SkTSet<SkPDFObject*>& newResources) {
+    SkPDFGlyphSetMap::F2BIter iterator(usage);
+    const SkPDFGlyphSetMap::FontGlyphSetPair* entry = iterator.next();
+    while (entry) {
+        // Fonts that were seen before are already deferred.
+        SkPDFObject* font = entry->fFont;
+        if (newResources.contains(font)) {
+            fFonts.add(font);
+            // These are all new too, so newResources holds the references.
+            SkTSet<SkPDFObject*> fontResources;
+            font->getResources(fResources, &fontResources);
+            fFonts.mergeInto(fontResources);
+            fontResources.unrefAll();
+        }
+        entry = iterator.next();
+    }
+}
+
+void SkPDFStreamingDocument::releaseUnusedResources() {
+    // Resources are in the order they were found, so an object comes before
+    // the ones it refers to, and releasing it may leave them unused in turn.
+    int kept = 0;
+    for (int i = 0; i < fUnreleased.count(); i++) {
+        SkPDFObject* obj = fUnreleased[i];
+        if (obj->unique()) {
+            obj->releaseContent();
+        } else {
+            fUnreleased[kept++] = obj;
+        }
+    }
+    fUnreleased.setCount(kept);
+}
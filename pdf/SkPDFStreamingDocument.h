@@ -0,0 +1,95 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPDFStreamingDocument_DEFINED
+#define SkPDFStreamingDocument_DEFINED
+
+#include <sys/types.h>
+
+#include "SkPDFFont.h"
+#include "SkPDFTypes.h"
+#include "SkRefCnt.h"
+#include "SkTDArray.h"
+#include "SkTemplates.h"
+#include "SkTSet.h"
+
+class SkPDFCatalog;
+class SkPDFDevice;
+class SkPDFPage;
+class SkWStream;
+
+/** \class SkPDFStreamingDocument
+
+    A PDF document that is written out one page at a time.  SkPDFDocument
+    keeps every page and resource in memory until emitPDF(), so its memory
+    use grows with the page count; this one only keeps what later pages may
+    still need.
+
+    Each page is written as soon as it is appended, along with the resources
+    it is the first page to use.  The page's device and content are freed
+    right away, and a written resource releases its content once nothing
+    else refers to it.  Fonts are kept until close(), since they can only
+    be subset once every page is known.  The page tree, the document
+    catalog and the cross reference table are written last.
+*/
+class SkPDFStreamingDocument : SkNoncopyable {
+public:
+    /** Create a document that writes to stream, which is not owned and
+     *  must outlive the document.  Nothing is written before the first
+     *  page is appended.
+     */
+    explicit SkPDFStreamingDocument(SkWStream* stream);
+    ~SkPDFStreamingDocument();
+
+    /** Write out a page with the content of the passed device.  No changes
+     *  to the device will be honored after this.  Returns false if the
+     *  document has been closed.
+     */
+    bool appendPage(SkPDFDevice* pdfDevice);
+
+    /** Write the fonts, the page tree, the cross reference table and the
+     *  trailer.  Returns false if no page was appended, in which case
+     *  nothing has been written.  No pages can be appended after this.
+     */
+    bool close();
+
+private:
+    SkWStream* fStream;
+    SkAutoTDelete<SkPDFCatalog> fCatalog;
+    size_t fStartOffset;  // Stream offset of the PDF header.
+    bool fClosed;
+
+    SkPDFDict* fDocCatalog;
+    SkAutoTUnref<SkPDFDict> fDests;
+
+    int fPageCount;
+    // All the "Pages" nodes of the page tree, starting with the ones that
+    // the pages were put in as they were written.
+    SkTDArray<SkPDFDict*> fPageTree;
+    SkPDFArray* fCurrentKids;  // Kids of the last node, owned by the node.
+
+    // Every resource used so far.  This holds the references.
+    SkTSet<SkPDFObject*> fResources;
+    // The fonts and their resources, which close() writes.
+    SkTSet<SkPDFObject*> fFonts;
+    SkPDFGlyphSetMap fGlyphUsage;
+    SkTDArray<SkPDFObject*> fSubstitutes;
+    // Written resources that still have to release their content.
+    SkTDArray<SkPDFObject*> fUnreleased;
+
+    off_t getOffset() const;
+    void writeObject(SkPDFObject* obj);
+
+    SkPDFDict* addToPageTree(SkPDFPage* page);
+    SkPDFDict* finishPageTree();
+
+    void deferFonts(const SkPDFGlyphSetMap& usage,
+                    const SkTSet<SkPDFObject*>& newResources);
+    void releaseUnusedResources();
+};
+
+#endif
@@ -50,6 +50,26 @@ public:
     virtual void getResources(const SkTSet<SkPDFObject*>& knownResourceObjects,
                               SkTSet<SkPDFObject*>* newResourceObjects);
 
+    /** Do the expensive part of preparing this object for output, when it
+     *  doesn't depend on other objects (e.g. compressing a stream's data).
+     *  SkPDFCatalog::preflightObjects() calls this on several objects at
+     *  once from different threads, so it must only modify this object.
+     *  The default does nothing.
+     *  @param catalog  The object catalog to use.
+     */
+    virtual void preflight(SkPDFCatalog* catalog) {}
+
+    /** Free whatever this object no longer needs once it has been output.
+     *  SkPDFStreamingDocument calls this on objects that it has written and
+     *  that nothing but the document refers to anymore. The object will only
+     *  be referenced by object number after that, so it won't be emitted or
+     *  asked for its resources again. Objects that can be shared through a
+     *  canonical list (fonts, graphic states, shaders) must keep their
+     *  contents, since another document may still look them up. The default
+     *  does nothing.
+     */
+    virtual void releaseContent() {}
+
     /** Emit this object unless the catalog has a substitute object, in which
      *  case emit that.
      *  @see emitObject
@@ -0,0 +1,518 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "SkDiscardableMemory.h"
+#include "SkDiscardableMemoryPool.h"
+#include "SkOnce.h"
+#include "SkThread.h"
+#include "SkTypes.h"
+
+// Every process (of the same user) that uses this name shares one budget.
+// They must also share a pid namespace, since segments are found in and
+// cleaned up after other processes by pid.
+#ifndef SK_MEMFD_DISCARDABLE_MEMORY_NAME
+    #define SK_MEMFD_DISCARDABLE_MEMORY_NAME "/skia_discardable_memory"
+#endif
+
+// The most segments that can exist at once across all the processes.
+#ifndef SK_MEMFD_DISCARDABLE_MEMORY_SLOT_COUNT
+    #define SK_MEMFD_DISCARDABLE_MEMORY_SLOT_COUNT 4096
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+enum SlotState {
+    kFree_SlotState,
+    kLocked_SlotState,
+    kUnlocked_SlotState,
+    // The process in fPurger is discarding the pages, or freeing the slot of
+    // a dead owner. The pages are no longer counted.
+    kPurging_SlotState,
+    // The pages are discarded and no longer counted. Only the owner (or a
+    // process cleaning up after a dead owner) frees the slot.
+    kPurged_SlotState,
+};
+
+/**
+ *  Describes one segment, in the control block. fPid, fFd, fPages, fDev and
+ *  fIno may only be changed by the process that moved fState away from
+ *  kFree_SlotState, kUnlocked_SlotState or kPurged_SlotState. fPid is 0 while
+ *  a slot is free or being claimed.
+ *
+ *  A process claims fPurger before it moves fState to kPurging_SlotState, and
+ *  gives it up after it moves fState on, so a purger that dies at any point
+ *  leaves its pid behind for others to find.
+ */
+struct Slot {
+    int32_t  fState;
+    int32_t  fPid;      // of the owner
+    int32_t  fFd;       // in the owner
+    int32_t  fPages;
+    int32_t  fStamp;    // clock value at the last unlock, for LRU purging
+    int32_t  fPurger;   // pid of the process that may purge it, or 0
+    // Identify the memfd, so that a reused pid or fd is never mistaken for it.
+    uint64_t fDev;
+    uint64_t fIno;
+};
+
+// Changes with the layout, so that builds with different layouts never share
+// a control block.
+static const int32_t kMagic = 0x536b4d33 + SK_MEMFD_DISCARDABLE_MEMORY_SLOT_COUNT;
+
+/**
+ *  Shared by all the processes through a POSIX shared memory object. It is
+ *  only ever changed with atomics.
+ */
+struct ControlBlock {
+    int32_t fMagic;         // set once the block is initialized
+    int32_t fBudgetPages;
+    int32_t fUsedPages;     // by all the unpurged segments, locked or not
+    int32_t fClock;
+    Slot    fSlots[SK_MEMFD_DISCARDABLE_MEMORY_SLOT_COUNT];
+};
+
+static size_t page_size() {
+    static const size_t gPageSize = getpagesize();
+    return gPageSize;
+}
+
+static int create_memfd() {
+#ifdef __NR_memfd_create
+    static const unsigned kCloseOnExec = 1;     // MFD_CLOEXEC
+    return (int)syscall(__NR_memfd_create, "skia_discardable_memory", kCloseOnExec);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static bool process_is_dead(int32_t pid) {
+    return -1 == kill(pid, 0) && ESRCH == errno;
+}
+
+enum PunchResult {
+    kPunched_PunchResult,
+    kFailed_PunchResult,
+    // The owner is gone: its pid now belongs to a process that does not
+    // have the memfd open where the owner had it (and the owner keeps it
+    // open for as long as the segment is unlocked).
+    kOwnerGone_PunchResult,
+};
+
+/**
+ *  Gives the segment's pages back to the kernel. The segment may belong to
+ *  another process, whose memfd is then reached through /proc, and is only
+ *  punched once fstat shows that it is the segment's memfd.
+ */
+static PunchResult punch_segment(const Slot& slot) {
+    const off_t size = (off_t)slot.fPages * page_size();
+    if (slot.fPid == getpid()) {
+        return 0 == fallocate(slot.fFd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, size) ?
+               kPunched_PunchResult : kFailed_PunchResult;
+    }
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/fd/%d", slot.fPid, slot.fFd);
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return ENOENT == errno ? kOwnerGone_PunchResult : kFailed_PunchResult;
+    }
+    struct stat st;
+    PunchResult result = kFailed_PunchResult;
+    if (0 == fstat(fd, &st)) {
+        if ((uint64_t)st.st_dev != slot.fDev || (uint64_t)st.st_ino != slot.fIno) {
+            result = kOwnerGone_PunchResult;
+        } else if (0 == fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, size)) {
+            result = kPunched_PunchResult;
+        }
+    }
+    close(fd);
+    return result;
+}
+
+/**
+ *  Moves the slot from the from state to kPurging_SlotState, with this process
+ *  as its purger. Fails if the slot is not in that state, or if a live
+ *  process is purging it.
+ */
+static bool begin_purge(Slot* slot, int32_t from) {
+    const int32_t purger = slot->fPurger;
+    if (0 != purger && !process_is_dead(purger)) {
+        return false;
+    }
+    const int32_t self = getpid();
+    if (!sk_atomic_cas(&slot->fPurger, purger, self)) {
+        return false;
+    }
+    if (!sk_atomic_cas(&slot->fState, from, kPurging_SlotState)) {
+        SkAssertResult(sk_atomic_cas(&slot->fPurger, self, 0));
+        return false;
+    }
+    return true;
+}
+
+static void end_purge(Slot* slot, int32_t to) {
+    SkAssertResult(sk_atomic_cas(&slot->fState, kPurging_SlotState, to));
+    SkAssertResult(sk_atomic_cas(&slot->fPurger, (int32_t)getpid(), 0));
+}
+
+/**
+ *  If the slot's purger died while purging it, moves it on to
+ *  kPurged_SlotState. Its pages were uncounted (and possibly discarded), so
+ *  it is as good as purged. Returns true if it did.
+ */
+static bool take_over_dead_purge(Slot* slot) {
+    if (kPurging_SlotState != slot->fState) {
+        return false;
+    }
+    const int32_t purger = slot->fPurger;
+    if (0 == purger || !process_is_dead(purger) ||
+        !sk_atomic_cas(&slot->fPurger, purger, (int32_t)getpid())) {
+        return false;
+    }
+    if (kPurging_SlotState != slot->fState) {
+        // The purge was finished after all, before we took it over.
+        SkAssertResult(sk_atomic_cas(&slot->fPurger, (int32_t)getpid(), 0));
+        return false;
+    }
+    end_purge(slot, kPurged_SlotState);
+    return true;
+}
+
+/**
+ *  Purges the least recently unlocked segments, of any process, until the
+ *  used pages fit in budgetPages or nothing is left that can be purged.
+ *
+ *  The slots of owners that have exited (including ones whose pid has been
+ *  reused) are freed rather than punched: the kernel already has their pages
+ *  back. A segment that can not be punched stays unlocked and counted, and
+ *  becomes the most recently used, so the next purge tries it last.
+ */
+static void purge_down_to(ControlBlock* control, int32_t budgetPages) {
+    int failures = 0;
+    while (control->fUsedPages > budgetPages &&
+           failures < SK_MEMFD_DISCARDABLE_MEMORY_SLOT_COUNT) {
+        const uint32_t now = control->fClock;
+        Slot* victim = NULL;
+        uint32_t victimAge = 0;
+        for (int i = 0; i < SK_MEMFD_DISCARDABLE_MEMORY_SLOT_COUNT; ++i) {
+            Slot* slot = &control->fSlots[i];
+            if (kUnlocked_SlotState == slot->fState) {
+                uint32_t age = now - (uint32_t)slot->fStamp;
+                if (NULL == victim || age > victimAge) {
+                    victim = slot;
+                    victimAge = age;
+                }
+            }
+        }
+        if (NULL == victim) {
+            return;
+        }
+        if (!begin_purge(victim, kUnlocked_SlotState)) {
+            // It was locked or purged in the meantime, or another process is
+            // purging it.
+            failures += 1;
+            continue;
+        }
+        // Uncounted first, so that if this process dies while purging, the
+        // slot can be taken over as purged.
+        const int32_t pages = victim->fPages;
+        sk_atomic_add(&control->fUsedPages, -pages);
+        PunchResult result = kOwnerGone_PunchResult;
+        if (victim->fPid == getpid() || !process_is_dead(victim->fPid)) {
+            result = punch_segment(*victim);
+        }
+        switch (result) {
+            case kPunched_PunchResult:
+                end_purge(victim, kPurged_SlotState);
+                break;
+            case kFailed_PunchResult:
+                failures += 1;
+                sk_atomic_add(&control->fUsedPages, pages);
+                victim->fStamp = sk_atomic_inc(&control->fClock);
+                end_purge(victim, kUnlocked_SlotState);
+                break;
+            case kOwnerGone_PunchResult:
+                victim->fPid = 0;
+                end_purge(victim, kFree_SlotState);
+                break;
+        }
+    }
+}
+
+/**
+ *  Frees the slots of processes that exited (or crashed) without freeing
+ *  them, and finishes the purges of processes that died while purging. The
+ *  kernel has already taken the pages of dead processes back.
+ */
+static void reclaim_dead_slots(ControlBlock* control) {
+    const int32_t self = getpid();
+    for (int i = 0; i < SK_MEMFD_DISCARDABLE_MEMORY_SLOT_COUNT; ++i) {
+        Slot* slot = &control->fSlots[i];
+        take_over_dead_purge(slot);
+        const int32_t state = slot->fState;
+        const int32_t pid = slot->fPid;
+        if (kFree_SlotState == state || kPurging_SlotState == state ||
+            0 == pid || self == pid || !process_is_dead(pid)) {
+            continue;
+        }
+        if (!begin_purge(slot, state)) {
+            continue;
+        }
+        if (slot->fPid != pid) {
+            // The slot was freed and claimed again since we looked at it.
+            end_purge(slot, state);
+            continue;
+        }
+        if (kPurged_SlotState != state) {
+            sk_atomic_add(&control->fUsedPages, -slot->fPages);
+        }
+        slot->fPid = 0;
+        end_purge(slot, kFree_SlotState);
+    }
+}
+
+/** Returns a slot in the locked state, or NULL if they are all in use. */
+static Slot* claim_slot(ControlBlock* control) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        for (int i = 0; i < SK_MEMFD_DISCARDABLE_MEMORY_SLOT_COUNT; ++i) {
+            Slot* slot = &control->fSlots[i];
+            if (kFree_SlotState == slot->fState &&
+                sk_atomic_cas(&slot->fState, kFree_SlotState, kLocked_SlotState)) {
+                return slot;
+            }
+        }
+        reclaim_dead_slots(control);
+    }
+    return NULL;
+}
+
+static void free_slot(Slot* slot) {
+    slot->fPid = 0;
+    SkAssertResult(sk_atomic_cas(&slot->fState, kLocked_SlotState, kFree_SlotState));
+}
+
+static ControlBlock* gControlBlock;
+
+static void attach_control_block(int) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s_%u", SK_MEMFD_DISCARDABLE_MEMORY_NAME,
+             (unsigned)getuid());
+
+    bool creator = true;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0 && EEXIST == errno) {
+        creator = false;
+        fd = shm_open(name, O_RDWR | O_CLOEXEC, 0600);
+    }
+    if (fd < 0) {
+        return;
+    }
+    if (creator && 0 != ftruncate(fd, sizeof(ControlBlock))) {
+        close(fd);
+        shm_unlink(name);
+        return;
+    }
+    // Another process may still be creating it.
+    for (int tries = 0;; ++tries) {
+        struct stat st;
+        if (0 == fstat(fd, &st) && st.st_size >= (off_t)sizeof(ControlBlock)) {
+            break;
+        }
+        if (tries == 1000) {
+            close(fd);
+            return;
+        }
+        usleep(1000);
+    }
+    void* addr = mmap(NULL, sizeof(ControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == addr) {
+        return;
+    }
+
+    ControlBlock* control = static_cast<ControlBlock*>(addr);
+    if (creator) {
+        // Everything else starts out zero, i.e. no pages used and free slots.
+        control->fBudgetPages = SkToS32(SK_DEFAULT_GLOBAL_DISCARDABLE_MEMORY_POOL_SIZE /
+                                        page_size());
+        sk_atomic_cas(&control->fMagic, 0, kMagic);
+    }
+    for (int tries = 0; kMagic != control->fMagic; ++tries) {
+        // Not initialized yet, or by a build with a different layout.
+        if (tries == 1000 || 0 != control->fMagic) {
+            munmap(addr, sizeof(ControlBlock));
+            return;
+        }
+        usleep(1000);
+    }
+    reclaim_dead_slots(control);
+    gControlBlock = control;
+}
+
+static ControlBlock* get_control_block() {
+    SK_DECLARE_STATIC_ONCE(once);
+    SkOnce(&once, attach_control_block, 0);
+    return gControlBlock;
+}
+
+/**
+ *  DiscardableMemory implementation whose pages are in a memfd, and that is
+ *  counted in a budget shared with other processes. Going over the budget
+ *  (in any process) purges the least recently unlocked segments, wherever
+ *  they are.
+ */
+class SkMemfdDiscardableMemory : public SkDiscardableMemory {
+public:
+    SkMemfdDiscardableMemory(ControlBlock* control, Slot* slot, int fd,
+                             void* address, size_t size);
+    virtual ~SkMemfdDiscardableMemory();
+    virtual bool lock() SK_OVERRIDE;
+    virtual void* data() SK_OVERRIDE;
+    virtual void unlock() SK_OVERRIDE;
+private:
+    ControlBlock* const fControl;
+    Slot*         fSlot;    // NULL once purged
+    bool          fLocked;
+    int           fFd;
+    void*         fMemory;
+    const size_t  fSize;
+
+    void release();
+};
+
+SkMemfdDiscardableMemory::SkMemfdDiscardableMemory(ControlBlock* control,
+                                                   Slot* slot,
+                                                   int fd,
+                                                   void* address,
+                                                   size_t size)
+    : fControl(control)
+    , fSlot(slot)
+    , fLocked(true)
+    , fFd(fd)
+    , fMemory(address)
+    , fSize(size) {
+    SkASSERT(fControl != NULL);
+    SkASSERT(fSlot != NULL);
+    SkASSERT(fFd >= 0);
+    SkASSERT(fMemory != NULL);
+    SkASSERT(fSize > 0);
+}
+
+SkMemfdDiscardableMemory::~SkMemfdDiscardableMemory() {
+    SkASSERT(!fLocked);
+    // Locking keeps other processes away while the slot is freed.
+    if (this->lock()) {
+        sk_atomic_add(&fControl->fUsedPages, -fSlot->fPages);
+        free_slot(fSlot);
+        fSlot = NULL;
+        fLocked = false;
+        this->release();
+    }
+}
+
+void SkMemfdDiscardableMemory::release() {
+    SkASSERT(!fLocked);
+    munmap(fMemory, fSize);
+    fMemory = NULL;
+    close(fFd);
+    fFd = -1;
+}
+
+bool SkMemfdDiscardableMemory::lock() {
+    SkASSERT(!fLocked);
+    if (NULL == fSlot) {
+        return false;
+    }
+    for (;;) {
+        if (sk_atomic_cas(&fSlot->fState, kUnlocked_SlotState, kLocked_SlotState)) {
+            fLocked = true;
+            return true;
+        }
+        if (kPurged_SlotState == fSlot->fState || take_over_dead_purge(fSlot)) {
+            break;
+        }
+        // Some process is purging it right now.
+        sched_yield();
+    }
+    this->release();
+    fSlot->fPid = 0;
+    SkAssertResult(sk_atomic_cas(&fSlot->fState, kPurged_SlotState, kFree_SlotState));
+    fSlot = NULL;
+    return false;
+}
+
+void* SkMemfdDiscardableMemory::data() {
+    SkASSERT(fLocked);
+    return fLocked ? fMemory : NULL;
+}
+
+void SkMemfdDiscardableMemory::unlock() {
+    SkASSERT(fLocked);
+    fSlot->fStamp = sk_atomic_inc(&fControl->fClock);
+    SkAssertResult(sk_atomic_cas(&fSlot->fState, kLocked_SlotState, kUnlocked_SlotState));
+    fLocked = false;
+    purge_down_to(fControl, fControl->fBudgetPages);
+}
+}  // namespace
+////////////////////////////////////////////////////////////////////////////////
+
+SkDiscardableMemory* SkDiscardableMemory::Create(size_t bytes) {
+    ControlBlock* control = get_control_block();
+    if (NULL == control) {
+        // No shared memory (e.g. in a sandbox): keep it in this process.
+        return SkGetGlobalDiscardableMemoryPool()->create(bytes);
+    }
+
+    const size_t mask = page_size() - 1;
+    const size_t size = (bytes + mask) & ~mask;
+    const size_t pages = size / page_size();
+    if (0 == pages || pages > (size_t)control->fBudgetPages) {
+        return NULL;
+    }
+
+    Slot* slot = claim_slot(control);
+    if (NULL == slot) {
+        return SkGetGlobalDiscardableMemoryPool()->create(bytes);
+    }
+    int fd = create_memfd();
+    if (fd < 0) {
+        free_slot(slot);
+        return SkGetGlobalDiscardableMemoryPool()->create(bytes);
+    }
+    struct stat st;
+    void* addr = MAP_FAILED;
+    if (0 == fstat(fd, &st) && 0 == ftruncate(fd, size)) {
+        addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (MAP_FAILED == addr) {
+        close(fd);
+        free_slot(slot);
+        return NULL;
+    }
+
+    slot->fPid = getpid();
+    slot->fFd = fd;
+    slot->fPages = SkToS32(pages);
+    slot->fDev = (uint64_t)st.st_dev;
+    slot->fIno = (uint64_t)st.st_ino;
+    sk_atomic_add(&control->fUsedPages, slot->fPages);
+    // This one is locked, so other segments make room for it.
+    purge_down_to(control, control->fBudgetPages);
+
+    return SkNEW_ARGS(SkMemfdDiscardableMemory, (control, slot, fd, addr, size));
+}
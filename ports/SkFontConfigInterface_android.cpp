@@ -566,6 +566,7 @@ SkTypeface* SkFontConfigInterfaceAndroid::getTypefaceForChar(SkUnichar uni,
     SkAutoGlyphCache autoCache(paint, NULL, NULL);
     SkGlyphCache*    cache = autoCache.getCache();
 
+    SkAutoMutexAcquire ac(cache->getScalerContextMutex());
     SkScalerContext* ctx = cache->getScalerContext();
     if (ctx) {
         SkFontID fontID = ctx->findTypefaceIdForChar(uni);
@@ -20,6 +20,7 @@
 #include "SkMaskGamma.h"
 #include "SkOTUtils.h"
 #include "SkOnce.h"
+#include "SkParallel.h"
 #include "SkScalerContext.h"
 #include "SkStream.h"
 #include "SkString.h"
@@ -115,8 +116,8 @@ static int          gLCDExtra;  // number of extra pixels for filtering.
 typedef FT_Error (*FT_Library_SetLcdFilterWeightsProc)(FT_Library, unsigned char*);
 
 // Caller must lock gFTMutex before calling this function.
-static bool InitFreetype() {
-    FT_Error err = FT_Init_FreeType(&gFTLibrary);
+static bool InitFreetype(FT_Library* library) {
+    FT_Error err = FT_Init_FreeType(library);
     if (err) {
         return false;
     }
@@ -125,7 +126,7 @@ static bool InitFreetype() {
 #ifdef FT_LCD_FILTER_H
     // Use default { 0x10, 0x40, 0x70, 0x40, 0x10 }, as it adds up to 0x110, simulating ink spread.
     // SetLcdFilter must be called before SetLcdFilterWeights.
-    err = FT_Library_SetLcdFilter(gFTLibrary, FT_LCD_FILTER_DEFAULT);
+    err = FT_Library_SetLcdFilter(*library, FT_LCD_FILTER_DEFAULT);
     if (0 == err) {
         gLCDSupport = true;
         gLCDExtra = 2; //Using a filter adds one full pixel to each side.
@@ -136,7 +137,7 @@ static bool InitFreetype() {
 
 #if defined(SK_FONTHOST_FREETYPE_RUNTIME_VERSION) && \
             SK_FONTHOST_FREETYPE_RUNTIME_VERSION > 0x020400
-        err = FT_Library_SetLcdFilterWeights(gFTLibrary, gGaussianLikeHeavyWeights);
+        err = FT_Library_SetLcdFilterWeights(*library, gGaussianLikeHeavyWeights);
 #elif defined(SK_CAN_USE_DLOPEN) && SK_CAN_USE_DLOPEN == 1
         //The FreeType library is already loaded, so symbols are available in process.
         void* self = dlopen(NULL, RTLD_LAZY);
@@ -147,7 +148,7 @@ static bool InitFreetype() {
             dlclose(self);
 
             if (NULL != setLcdFilterWeights) {
-                err = setLcdFilterWeights(gFTLibrary, gGaussianLikeHeavyWeights);
+                err = setLcdFilterWeights(*library, gGaussianLikeHeavyWeights);
             }
         }
 #endif
@@ -165,7 +166,7 @@ static bool InitFreetype() {
 static void determine_lcd_support(bool* lcdSupported) {
     if (!gLCDSupportValid) {
         // This will determine LCD support as a side effect.
-        InitFreetype();
+        InitFreetype(&gFTLibrary);
         FT_Done_FreeType(gFTLibrary);
     }
     SkASSERT(gLCDSupportValid);
@@ -196,6 +197,7 @@ protected:
     virtual void generateAdvance(SkGlyph* glyph) SK_OVERRIDE;
     virtual void generateMetrics(SkGlyph* glyph) SK_OVERRIDE;
     virtual void generateImage(const SkGlyph& glyph) SK_OVERRIDE;
+    virtual void generateImages(const SkGlyph* glyphs[], int count) SK_OVERRIDE;
     virtual void generatePath(const SkGlyph& glyph, SkPath* path) SK_OVERRIDE;
     virtual void generateFontMetrics(SkPaint::FontMetrics* mx,
                                      SkPaint::FontMetrics* my) SK_OVERRIDE;
@@ -217,14 +219,24 @@ private:
     SkMatrix    fMatrix22Scalar;
 
     FT_Error setupSize();
+    // Sizes a face of our own (see generateImages) the way setupSize does
+    // fFace. Caller must lock gFTMutex before calling this function.
+    FT_Error setupWorkerFace(FT_Face face);
+    // Loads and renders the glyph with a face that is already set up. Caller
+    // must lock gFTMutex if the face is fFace.
+    void renderGlyph(FT_Face face, const SkGlyph& glyph);
+    static void RenderBatch(void* batch, int index);
     void getBBoxForCurrentGlyph(SkGlyph* glyph, FT_BBox* bbox,
                                 bool snapToPixelBoundary = false);
     bool getCBoxForLetter(char letter, FT_BBox* bbox);
     // Caller must lock gFTMutex before calling this function.
     void updateGlyphIfLCD(SkGlyph* glyph);
-    // Caller must lock gFTMutex before calling this function.
+    // Caller must lock gFTMutex before calling this function, unless face is
+    // a worker's own (see generateImages).
     // update FreeType2 glyph slot with glyph emboldened
     void emboldenIfNeeded(FT_Face face, FT_GlyphSlot glyph);
+
+    typedef SkScalerContext_FreeType_Base INHERITED;
 };
 
 ///////////////////////////////////////////////////////////////////////////
@@ -287,20 +299,10 @@ SkFaceRec::SkFaceRec(SkStream* strm, uint32_t fontID)
     fFTStream.close = sk_stream_close;
 }
 
-// Will return 0 on failure
+// Opens a face that is not in gFaceRecHead, or returns 0 on failure.
 // Caller must lock gFTMutex before calling this function.
-static SkFaceRec* ref_ft_face(const SkTypeface* typeface) {
+static SkFaceRec* open_ft_face(FT_Library library, const SkTypeface* typeface) {
     const SkFontID fontID = typeface->uniqueID();
-    SkFaceRec* rec = gFaceRecHead;
-    while (rec) {
-        if (rec->fFontID == fontID) {
-            SkASSERT(rec->fFace);
-            rec->fRefCnt += 1;
-            return rec;
-        }
-        rec = rec->fNext;
-    }
-
     int face_index;
     SkStream* strm = typeface->openStream(&face_index);
     if (NULL == strm) {
@@ -308,7 +310,7 @@ static SkFaceRec* ref_ft_face(const SkTypeface* typeface) {
     }
 
     // this passes ownership of strm to the rec
-    rec = SkNEW_ARGS(SkFaceRec, (strm, fontID));
+    SkFaceRec* rec = SkNEW_ARGS(SkFaceRec, (strm, fontID));
 
     FT_Open_Args    args;
     memset(&args, 0, sizeof(args));
@@ -325,18 +327,37 @@ static SkFaceRec* ref_ft_face(const SkTypeface* typeface) {
         args.stream = &rec->fFTStream;
     }
 
-    FT_Error err = FT_Open_Face(gFTLibrary, &args, face_index, &rec->fFace);
+    FT_Error err = FT_Open_Face(library, &args, face_index, &rec->fFace);
     if (err) {    // bad filename, try the default font
         fprintf(stderr, "ERROR: unable to open font '%x'\n", fontID);
         SkDELETE(rec);
         return NULL;
-    } else {
-        SkASSERT(rec->fFace);
-        //fprintf(stderr, "Opened font '%s'\n", filename.c_str());
+    }
+    SkASSERT(rec->fFace);
+    //fprintf(stderr, "Opened font '%s'\n", filename.c_str());
+    return rec;
+}
+
+// Will return 0 on failure
+// Caller must lock gFTMutex before calling this function.
+static SkFaceRec* ref_ft_face(const SkTypeface* typeface) {
+    const SkFontID fontID = typeface->uniqueID();
+    SkFaceRec* rec = gFaceRecHead;
+    while (rec) {
+        if (rec->fFontID == fontID) {
+            SkASSERT(rec->fFace);
+            rec->fRefCnt += 1;
+            return rec;
+        }
+        rec = rec->fNext;
+    }
+
+    rec = open_ft_face(gFTLibrary, typeface);
+    if (rec) {
         rec->fNext = gFaceRecHead;
         gFaceRecHead = rec;
-        return rec;
     }
+    return rec;
 }
 
 // Caller must lock gFTMutex before calling this function.
@@ -368,7 +389,7 @@ public:
     AutoFTAccess(const SkTypeface* tf) : fRec(NULL), fFace(NULL) {
         gFTMutex.acquire();
         if (1 == ++gFTCount) {
-            if (!InitFreetype()) {
+            if (!InitFreetype(&gFTLibrary)) {
                 sk_throw();
             }
         }
@@ -833,7 +854,7 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(SkTypeface* typeface,
     SkAutoMutexAcquire  ac(gFTMutex);
 
     if (gFTCount == 0) {
-        if (!InitFreetype()) {
+        if (!InitFreetype(&gFTLibrary)) {
             sk_throw();
         }
     }
@@ -1283,23 +1304,120 @@ void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph) {
 void SkScalerContext_FreeType::generateImage(const SkGlyph& glyph) {
     SkAutoMutexAcquire  ac(gFTMutex);
 
-    FT_Error    err;
-
     if (this->setupSize()) {
-        goto ERROR;
+        memset(glyph.fImage, 0, glyph.rowBytes() * glyph.fHeight);
+        return;
     }
+    this->renderGlyph(fFace, glyph);
+}
 
-    err = FT_Load_Glyph( fFace, glyph.getGlyphID(fBaseGlyphCount), fLoadGlyphFlags);
+void SkScalerContext_FreeType::renderGlyph(FT_Face face, const SkGlyph& glyph) {
+    FT_Error err = FT_Load_Glyph( face, glyph.getGlyphID(fBaseGlyphCount), fLoadGlyphFlags);
     if (err != 0) {
         SkDEBUGF(("SkScalerContext_FreeType::generateImage: FT_Load_Glyph(glyph:%d width:%d height:%d rb:%d flags:%d) returned 0x%x\n",
                     glyph.getGlyphID(fBaseGlyphCount), glyph.fWidth, glyph.fHeight, glyph.rowBytes(), fLoadGlyphFlags, err));
-    ERROR:
         memset(glyph.fImage, 0, glyph.rowBytes() * glyph.fHeight);
         return;
     }
 
-    emboldenIfNeeded(fFace, fFace->glyph);
-    generateGlyphImage(fFace, glyph);
+    emboldenIfNeeded(face, face->glyph);
+    generateGlyphImage(face, glyph);
+}
+
+FT_Error SkScalerContext_FreeType::setupWorkerFace(FT_Face face) {
+    if (FT_IS_SCALABLE(face)) {
+        FT_Error err = FT_Set_Char_Size(face, SkFixedToFDot6(fScaleX), SkFixedToFDot6(fScaleY),
+                                        72, 72);
+        if (err != 0) {
+            return err;
+        }
+        FT_Set_Transform(face, &fMatrix22, NULL);
+    } else if (fStrikeIndex != -1) {
+        return FT_Select_Size(face, fStrikeIndex);
+    }
+    return 0;
+}
+
+// Each worker of a batch needs at least this many glyphs to pay for opening
+// its own face.
+static const int kMinGlyphsPerWorker = 32;
+
+namespace {
+/**
+ *  A library and face of one worker's own. FreeType objects may only be used
+ *  by one thread at a time, and (before 2.6) a library's rasterizer pool is
+ *  shared by all its faces, so each worker gets both.
+ */
+struct FTWorker {
+    FT_Library  fLibrary;
+    SkFaceRec*  fRec;
+};
+
+struct FTBatch {
+    SkScalerContext_FreeType*   fContext;
+    const SkGlyph**             fGlyphs;
+    int                         fCount;
+    FTWorker*                   fWorkers;
+    int                         fWorkerCount;
+};
+}  // namespace
+
+// Caller must lock gFTMutex before calling this function.
+static void close_worker(FTWorker* worker) {
+    if (worker->fRec) {
+        FT_Done_Face(worker->fRec->fFace);
+        SkDELETE(worker->fRec);
+    }
+    FT_Done_FreeType(worker->fLibrary);
+}
+
+void SkScalerContext_FreeType::generateImages(const SkGlyph* glyphs[], int count) {
+    const int maxWorkers = SkMin32(SkParallel::Concurrency(), count / kMinGlyphsPerWorker);
+    if (maxWorkers <= 1) {
+        INHERITED::generateImages(glyphs, count);
+        return;
+    }
+
+    // Faces are opened and closed under gFTMutex, but rendered without it.
+    SkAutoSTMalloc<8, FTWorker> workers(maxWorkers);
+    int workerCount = 0;
+    {
+        SkAutoMutexAcquire  ac(gFTMutex);
+        while (workerCount < maxWorkers) {
+            FTWorker* worker = &workers[workerCount];
+            if (!InitFreetype(&worker->fLibrary)) {
+                break;
+            }
+            worker->fRec = open_ft_face(worker->fLibrary, this->getTypeface());
+            if (NULL == worker->fRec || this->setupWorkerFace(worker->fRec->fFace)) {
+                close_worker(worker);
+                break;
+            }
+            ++workerCount;
+        }
+    }
+
+    if (workerCount > 1) {
+        FTBatch batch = { this, glyphs, count, workers.get(), workerCount };
+        SkParallel::For(workerCount, RenderBatch, &batch);
+    } else {
+        INHERITED::generateImages(glyphs, count);
+    }
+
+    SkAutoMutexAcquire  ac(gFTMutex);
+    for (int i = 0; i < workerCount; ++i) {
+        close_worker(&workers[i]);
+    }
+}
+
+void SkScalerContext_FreeType::RenderBatch(void* context, int index) {
+    const FTBatch& batch = *static_cast<const FTBatch*>(context);
+    const int start = batch.fCount * index / batch.fWorkerCount;
+    const int stop = batch.fCount * (index + 1) / batch.fWorkerCount;
+    FT_Face face = batch.fWorkers[index].fRec->fFace;
+    for (int i = start; i < stop; ++i) {
+        batch.fContext->renderGlyph(face, *batch.fGlyphs[i]);
+    }
 }
 
 
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkChunkedPicture.h"
+#include "SkCanvas.h"
+#include "SkPicture.h"
+
+SkChunkedPicture::SkChunkedPicture(int width, int height, uint32_t recordingFlags)
+    : fWidth(width)
+    , fHeight(height)
+    , fRecordingFlags(recordingFlags)
+    , fRecordingID(-1)
+    , fRecording(NULL)
+    , fCombined(NULL) {
+}
+
+SkChunkedPicture::~SkChunkedPicture() {
+    SkASSERT(-1 == fRecordingID);
+    SkSafeUnref(fRecording);
+    SkSafeUnref(fCombined);
+    for (int i = 0; i < fChunks.count(); ++i) {
+        SkSafeUnref(fChunks[i].fPicture);
+    }
+}
+
+int SkChunkedPicture::addChunk(const SkIRect& bounds) {
+    Chunk* chunk = fChunks.append();
+    chunk->fBounds = bounds;
+    if (!chunk->fBounds.intersect(SkIRect::MakeWH(fWidth, fHeight))) {
+        chunk->fBounds.setEmpty();
+    }
+    chunk->fPicture = NULL;
+    chunk->fDirty = true;
+    return fChunks.count() - 1;
+}
+
+int SkChunkedPicture::invalidate(const SkIRect& dirty) {
+    int marked = 0;
+    for (int i = 0; i < fChunks.count(); ++i) {
+        Chunk& chunk = fChunks[i];
+        if (!chunk.fDirty && SkIRect::Intersects(chunk.fBounds, dirty)) {
+            chunk.fDirty = true;
+            ++marked;
+        }
+    }
+    return marked;
+}
+
+void SkChunkedPicture::invalidateChunk(int id) {
+    fChunks[id].fDirty = true;
+}
+
+SkCanvas* SkChunkedPicture::beginChunk(int id) {
+    SkASSERT(-1 == fRecordingID);
+    const SkIRect& bounds = fChunks[id].fBounds;
+
+    fRecordingID = id;
+    fRecording = SkNEW(SkPicture);
+    SkCanvas* canvas = fRecording->beginRecording(bounds.width(), bounds.height(),
+                                                  fRecordingFlags);
+    canvas->translate(-SkIntToScalar(bounds.fLeft), -SkIntToScalar(bounds.fTop));
+    canvas->clipRect(SkRect::Make(bounds));
+    return canvas;
+}
+
+void SkChunkedPicture::endChunk() {
+    SkASSERT(fRecordingID >= 0);
+    Chunk& chunk = fChunks[fRecordingID];
+
+    fRecording->endRecording();
+    SkSafeUnref(chunk.fPicture);
+    chunk.fPicture = fRecording;
+    chunk.fDirty = false;
+
+    fRecording = NULL;
+    fRecordingID = -1;
+    SkSafeSetNull(fCombined);
+}
+
+SkPicture* SkChunkedPicture::newPicture() {
+    SkASSERT(-1 == fRecordingID);
+    if (NULL == fCombined) {
+        fCombined = SkNEW(SkPicture);
+        SkCanvas* canvas = fCombined->beginRecording(fWidth, fHeight, fRecordingFlags);
+        for (int i = 0; i < fChunks.count(); ++i) {
+            const Chunk& chunk = fChunks[i];
+            if (NULL == chunk.fPicture || chunk.fBounds.isEmpty()) {
+                continue;
+            }
+            canvas->save();
+            canvas->translate(SkIntToScalar(chunk.fBounds.fLeft),
+                              SkIntToScalar(chunk.fBounds.fTop));
+            // Drawing a picture changes its playback state, so each combined
+            // picture gets clones of its own (which share the op streams).
+            SkAutoTUnref<SkPicture> clone(chunk.fPicture->clone());
+            canvas->drawPicture(*clone);
+            canvas->restore();
+        }
+        fCombined->endRecording();
+    }
+    return SkRef(fCombined);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkChunkedPicture_DEFINED
+#define SkChunkedPicture_DEFINED
+
+#include "SkRect.h"
+#include "SkTDArray.h"
+
+class SkCanvas;
+class SkPicture;
+
+/**
+ *  Records a picture as a set of independently re-recordable chunks, each
+ *  covering a rectangle of the picture.
+ *
+ *  When part of the content changes, invalidate() marks the chunks that
+ *  overlap the changed area as dirty. Only those chunks need to be recorded
+ *  again. newPicture() then returns a single picture that draws every chunk.
+ *  It only holds one DRAW_PICTURE op per chunk and shares the chunks' op
+ *  streams, so building it costs next to nothing compared to re-recording
+ *  the whole content.
+ *
+ *  Chunk pictures are never recorded into once they are finished.
+ *  Re-recording a chunk creates a new picture, and each picture returned by
+ *  newPicture() draws clones of the chunks of its own, so it stays valid
+ *  while it is played back, and pictures from different calls can be played
+ *  back at the same time. As with any SkPicture, playing one picture back on
+ *  several threads at once takes a clone() per thread.
+ */
+class SkChunkedPicture : SkNoncopyable {
+public:
+    /**
+     *  recordingFlags are SkPicture::RecordingFlags, used for the chunks and
+     *  for the combined picture. With kOptimizeForClippedPlayback_RecordingFlag
+     *  a clipped playback skips the chunks that fall outside the clip.
+     */
+    SkChunkedPicture(int width, int height, uint32_t recordingFlags = 0);
+    ~SkChunkedPicture();
+
+    int width() const { return fWidth; }
+    int height() const { return fHeight; }
+
+    /**
+     *  Add a chunk covering bounds (in picture coordinates), clipped to the
+     *  picture. Returns its ID. A new chunk is dirty and draws nothing until
+     *  it is recorded.
+     */
+    int addChunk(const SkIRect& bounds);
+
+    int chunkCount() const { return fChunks.count(); }
+    const SkIRect& chunkBounds(int id) const { return fChunks[id].fBounds; }
+    bool isChunkDirty(int id) const { return fChunks[id].fDirty; }
+
+    /**
+     *  Mark every chunk whose bounds intersect dirty as needing to be
+     *  recorded again. Returns the number of chunks that were marked.
+     */
+    int invalidate(const SkIRect& dirty);
+
+    /**
+     *  Mark a single chunk as needing to be recorded again.
+     */
+    void invalidateChunk(int id);
+
+    /**
+     *  Start recording the content of a chunk, replacing whatever it held.
+     *  The returned canvas uses picture coordinates and is clipped to the
+     *  chunk's bounds. Draw calls must not use setMatrix() or resetMatrix(),
+     *  which would drop the chunk's offset. Each beginChunk() must be
+     *  matched with an endChunk() before another chunk is started.
+     */
+    SkCanvas* beginChunk(int id);
+    void endChunk();
+
+    /**
+     *  Returns a picture that draws every chunk, and that the caller must
+     *  unref. A chunk that is dirty but not recorded again draws its previous
+     *  content. If no chunk has changed since the last call, the same
+     *  picture is returned again (see above about playing it back on
+     *  several threads).
+     */
+    SkPicture* newPicture();
+
+private:
+    struct Chunk {
+        SkIRect     fBounds;
+        SkPicture*  fPicture;   // NULL until first recorded
+        bool        fDirty;
+    };
+
+    int                 fWidth;
+    int                 fHeight;
+    uint32_t            fRecordingFlags;
+    SkTDArray<Chunk>    fChunks;
+    int                 fRecordingID;   // chunk being recorded, or -1
+    SkPicture*          fRecording;     // its new picture
+    SkPicture*          fCombined;      // NULL when a chunk changed since
+};
+
+#endif
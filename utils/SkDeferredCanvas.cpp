@@ -7,10 +7,12 @@
  */
 
 #include "SkDeferredCanvas.h"
+#include "SkDeferredCanvasUtils.h"
 
 #include "SkBitmapDevice.h"
 #include "SkChunkAlloc.h"
 #include "SkColorFilter.h"
+#include "SkCondVar.h"
 #include "SkDrawFilter.h"
 #include "SkGPipe.h"
 #include "SkPaint.h"
@@ -18,6 +20,8 @@
 #include "SkRRect.h"
 #include "SkShader.h"
 #include "SkSurface.h"
+#include "SkThread.h"
+#include "SkThreadUtils.h"
 
 enum {
     // Deferred canvas will auto-flush when recording reaches this limit
@@ -54,6 +58,176 @@ static bool shouldDrawImmediately(const SkBitmap* bitmap, const SkPaint* paint,
     return false;
 }
 
+struct PipeBlock {
+    PipeBlock(void* block, size_t size) { fBlock = block, fSize = size; }
+    void* fBlock;
+    size_t fSize;
+};
+
+//-----------------------------------------------------------------------------
+// PlaybackThread
+//-----------------------------------------------------------------------------
+
+/**
+ *  Plays flushed pipe blocks back through a reader on a thread of its own.
+ *
+ *  The recording thread hands each flush over as a batch of blocks through a
+ *  fixed size ring. Each side only moves its own end of the ring, and they
+ *  share nothing else but atomic counters, so no lock is taken unless one
+ *  side has to sleep: the playback thread when the ring is empty, and the
+ *  recording thread when the ring is full or it waits for playback.
+ */
+class PlaybackThread : SkNoncopyable {
+public:
+    explicit PlaybackThread(SkGPipeReader* reader);
+    // Plays back everything that was pushed, then stops the thread.
+    ~PlaybackThread();
+
+    bool start();
+
+    // Takes ownership of blocks, an sk_malloc'ed array of sk_malloc'ed
+    // blocks that add up to bytes, and frees them once they are played back.
+    // Sleeps first if the ring is full.
+    void push(PipeBlock* blocks, int count, size_t bytes, bool silent);
+
+    // Returns once every batch pushed so far has been played back.
+    void wait();
+
+    // Bytes of the batches that have not been played back yet.
+    size_t bytesInFlight();
+
+private:
+    enum {
+        kRingSize = 16
+    };
+    struct Batch {
+        PipeBlock* fBlocks;  // NULL tells the thread to stop
+        int fCount;
+        size_t fBytes;
+        bool fSilent;
+    };
+
+    void sleepWhile(int32_t* counter, int32_t value);
+    void wake();
+    static void Loop(void*);
+
+    SkGPipeReader* fReader;
+    SkThread fThread;
+    bool fStarted;
+    Batch fRing[kRingSize];
+    int fPushIndex;           // only used by the recording thread
+    int fPopIndex;            // only used by the playback thread
+    int32_t fQueued;          // batches in the ring
+    int32_t fPending;         // batches pushed and not played back yet
+    int32_t fBytesInFlight;
+    int32_t fSleepers;
+    SkCondVar fCond;          // for sleeping only
+};
+
+PlaybackThread::PlaybackThread(SkGPipeReader* reader)
+    : fReader(reader)
+    , fThread(&PlaybackThread::Loop, this)
+    , fStarted(false)
+    , fPushIndex(0)
+    , fPopIndex(0)
+    , fQueued(0)
+    , fPending(0)
+    , fBytesInFlight(0)
+    , fSleepers(0) {
+}
+
+PlaybackThread::~PlaybackThread() {
+    if (fStarted) {
+        this->push(NULL, 0, 0, false);
+        fThread.join();
+    }
+}
+
+bool PlaybackThread::start() {
+    fStarted = fThread.start();
+    return fStarted;
+}
+
+void PlaybackThread::push(PipeBlock* blocks, int count, size_t bytes, bool silent) {
+    this->sleepWhile(&fQueued, kRingSize);
+    Batch& batch = fRing[fPushIndex];
+    batch.fBlocks = blocks;
+    batch.fCount = count;
+    batch.fBytes = bytes;
+    batch.fSilent = silent;
+    fPushIndex = (fPushIndex + 1) % kRingSize;
+    if (NULL != blocks) {
+        sk_atomic_add(&fBytesInFlight, SkToS32(bytes));
+        sk_atomic_inc(&fPending);
+    }
+    // This publishes the batch to the playback thread.
+    sk_atomic_inc(&fQueued);
+    this->wake();
+}
+
+void PlaybackThread::wait() {
+    for (;;) {
+        int32_t pending = sk_atomic_add(&fPending, 0);
+        if (0 == pending) {
+            return;
+        }
+        this->sleepWhile(&fPending, pending);
+    }
+}
+
+size_t PlaybackThread::bytesInFlight() {
+    return sk_atomic_add(&fBytesInFlight, 0);
+}
+
+// Sleeps until the other thread changes *counter from value. The counters
+// and fSleepers are only changed with atomic (fully fenced) operations, so
+// either the sleeper sees the change, or the other thread sees the sleeper
+// and wakes it.
+void PlaybackThread::sleepWhile(int32_t* counter, int32_t value) {
+    if (sk_atomic_add(counter, 0) != value) {
+        return;
+    }
+    fCond.lock();
+    sk_atomic_inc(&fSleepers);
+    while (sk_atomic_add(counter, 0) == value) {
+        fCond.wait();
+    }
+    sk_atomic_dec(&fSleepers);
+    fCond.unlock();
+}
+
+void PlaybackThread::wake() {
+    if (sk_atomic_add(&fSleepers, 0) > 0) {
+        fCond.lock();
+        fCond.broadcast();
+        fCond.unlock();
+    }
+}
+
+void PlaybackThread::Loop(void* arg) {
+    PlaybackThread* thread = static_cast<PlaybackThread*>(arg);
+    for (;;) {
+        thread->sleepWhile(&thread->fQueued, 0);
+        Batch batch = thread->fRing[thread->fPopIndex];
+        thread->fPopIndex = (thread->fPopIndex + 1) % kRingSize;
+        sk_atomic_dec(&thread->fQueued);
+        thread->wake();
+        if (NULL == batch.fBlocks) {
+            return;
+        }
+
+        uint32_t flags = batch.fSilent ? SkGPipeReader::kSilent_PlaybackFlag : 0;
+        for (int i = 0; i < batch.fCount; ++i) {
+            thread->fReader->playback(batch.fBlocks[i].fBlock, batch.fBlocks[i].fSize, flags);
+            sk_free(batch.fBlocks[i].fBlock);
+        }
+        sk_free(batch.fBlocks);
+        sk_atomic_add(&thread->fBytesInFlight, -SkToS32(batch.fBytes));
+        sk_atomic_dec(&thread->fPending);
+        thread->wake();
+    }
+}
+
 //-----------------------------------------------------------------------------
 // DeferredPipeController
 //-----------------------------------------------------------------------------
@@ -66,38 +240,79 @@ public:
     virtual void* requestBlock(size_t minRequest, size_t* actual) SK_OVERRIDE;
     virtual void notifyWritten(size_t bytes) SK_OVERRIDE;
     void playback(bool silent);
-    bool hasPendingCommands() const { return fAllocator.blockCount() != 0; }
-    size_t storageAllocatedForRecording() const { return fAllocator.totalCapacity(); }
+    bool hasPendingCommands() const { return NULL != fBlock; }
+    size_t storageAllocatedForRecording() const;
+    // Must only be called when there are no pending commands.
+    bool setThreadedPlayback(bool threaded);
+    bool isThreaded() const { return NULL != fThread; }
+    // Returns once the playback thread, if any, has played back everything
+    // passed to playback().
+    void waitForPlayback() const;
 private:
     enum {
         kMinBlockSize = 4096
     };
-    struct PipeBlock {
-        PipeBlock(void* block, size_t size) { fBlock = block, fSize = size; }
-        void* fBlock;
-        size_t fSize;
-    };
     void* fBlock;
     size_t fBytesWritten;
     SkChunkAlloc fAllocator;
     SkTDArray<PipeBlock> fBlockList;
+    // With a playback thread, blocks are sk_malloc'ed instead, so the thread
+    // can free them. This counts their bytes until they are handed over.
+    size_t fBlockBytes;
     SkGPipeReader fReader;
+    PlaybackThread* fThread;
 };
 
 DeferredPipeController::DeferredPipeController() :
     fAllocator(kMinBlockSize) {
     fBlock = NULL;
     fBytesWritten = 0;
+    fBlockBytes = 0;
+    fThread = NULL;
 }
 
 DeferredPipeController::~DeferredPipeController() {
+    if (NULL != fThread) {
+        SkDELETE(fThread);
+        // Blocks recorded since the last playback were never handed over.
+        for (int i = 0; i < fBlockList.count(); i++) {
+            sk_free(fBlockList[i].fBlock);
+        }
+        sk_free(fBlock);
+    }
     fAllocator.reset();
 }
 
 void DeferredPipeController::setPlaybackCanvas(SkCanvas* canvas) {
+    this->waitForPlayback();
     fReader.setCanvas(canvas);
 }
 
+bool DeferredPipeController::setThreadedPlayback(bool threaded) {
+    SkASSERT(!this->hasPendingCommands());
+    if (threaded == this->isThreaded()) {
+        return true;
+    }
+    if (threaded) {
+        fThread = SkNEW_ARGS(PlaybackThread, (&fReader));
+        if (!fThread->start()) {
+            SkDELETE(fThread);
+            fThread = NULL;
+            return false;
+        }
+    } else {
+        SkDELETE(fThread);
+        fThread = NULL;
+    }
+    return true;
+}
+
+void DeferredPipeController::waitForPlayback() const {
+    if (NULL != fThread) {
+        fThread->wait();
+    }
+}
+
 void* DeferredPipeController::requestBlock(size_t minRequest, size_t *actual) {
     if (fBlock) {
         // Save the previous block for later
@@ -105,7 +320,12 @@ void* DeferredPipeController::requestBlock(size_t minRequest, size_t *actual) {
         fBlockList.push(previousBloc);
     }
     size_t blockSize = SkTMax<size_t>(minRequest, kMinBlockSize);
-    fBlock = fAllocator.allocThrow(blockSize);
+    if (NULL != fThread) {
+        fBlock = sk_malloc_throw(blockSize);
+        fBlockBytes += blockSize;
+    } else {
+        fBlock = fAllocator.allocThrow(blockSize);
+    }
     fBytesWritten = 0;
     *actual = blockSize;
     return fBlock;
@@ -116,6 +336,22 @@ void DeferredPipeController::notifyWritten(size_t bytes) {
 }
 
 void DeferredPipeController::playback(bool silent) {
+    if (NULL != fThread) {
+        if (fBlock) {
+            fBlockList.push(PipeBlock(fBlock, fBytesWritten));
+            fBlock = NULL;
+        }
+        int count = fBlockList.count();
+        if (count > 0) {
+            PipeBlock* blocks = (PipeBlock*)sk_malloc_throw(count * sizeof(PipeBlock));
+            memcpy(blocks, fBlockList.begin(), count * sizeof(PipeBlock));
+            fThread->push(blocks, count, fBlockBytes, silent);
+        }
+        fBlockList.reset();
+        fBlockBytes = 0;
+        return;
+    }
+
     uint32_t flags = silent ? SkGPipeReader::kSilent_PlaybackFlag : 0;
     for (int currentBlock = 0; currentBlock < fBlockList.count(); currentBlock++ ) {
         fReader.playback(fBlockList[currentBlock].fBlock, fBlockList[currentBlock].fSize,
@@ -132,6 +368,13 @@ void DeferredPipeController::playback(bool silent) {
     fAllocator.reset();
 }
 
+size_t DeferredPipeController::storageAllocatedForRecording() const {
+    if (NULL != fThread) {
+        return fBlockBytes + fThread->bytesInFlight();
+    }
+    return fAllocator.totalCapacity();
+}
+
 //-----------------------------------------------------------------------------
 // SkDeferredDevice
 //-----------------------------------------------------------------------------
@@ -142,8 +385,12 @@ public:
 
     void setNotificationClient(SkDeferredCanvas::NotificationClient* notificationClient);
     SkCanvas* recordingCanvas();
-    SkCanvas* immediateCanvas() const {return fImmediateCanvas;}
-    SkBaseDevice* immediateDevice() const {return fImmediateCanvas->getTopDevice();}
+    // These wait for the playback thread (if any) to finish with the canvas.
+    SkCanvas* immediateCanvas() const {
+        fPipeController.waitForPlayback();
+        return fImmediateCanvas;
+    }
+    SkBaseDevice* immediateDevice() const {return this->immediateCanvas()->getTopDevice();}
     SkImage* newImageSnapshot();
     void setSurface(SkSurface* surface);
     bool isFreshFrame();
@@ -156,6 +403,7 @@ public:
     void skipPendingCommands();
     void setMaxRecordingStorage(size_t);
     void recordedDrawCommand();
+    bool setThreadedPlayback(bool threaded);
 
     virtual int width() const SK_OVERRIDE;
     virtual int height() const SK_OVERRIDE;
@@ -260,6 +508,10 @@ private:
     DeferredPipeController fPipeController;
     SkGPipeWriter  fPipeWriter;
     SkCanvas* fImmediateCanvas;
+    // The immediate device's, so they can be read while the playback thread
+    // draws to it.
+    SkImageInfo fImmediateInfo;
+    SkBitmap::Config fImmediateConfig;
     SkCanvas* fRecordingCanvas;
     SkSurface* fSurface;
     SkDeferredCanvas::NotificationClient* fNotificationClient;
@@ -280,8 +532,13 @@ SkDeferredDevice::SkDeferredDevice(SkSurface* surface) {
 }
 
 void SkDeferredDevice::setSurface(SkSurface* surface) {
+    fPipeController.waitForPlayback();
     SkRefCnt_SafeAssign(fImmediateCanvas, surface->getCanvas());
     SkRefCnt_SafeAssign(fSurface, surface);
+    fImmediateInfo = fImmediateCanvas->getTopDevice()->imageInfo();
+    fImmediateConfig = fImmediateCanvas->getTopDevice()->config();
+    SkASSERT(!fPipeController.isThreaded() ||
+             NULL == fImmediateCanvas->getTopDevice()->accessRenderTarget());
     fPipeController.setPlaybackCanvas(fImmediateCanvas);
 }
 
@@ -298,6 +555,7 @@ void SkDeferredDevice::init() {
 
 SkDeferredDevice::~SkDeferredDevice() {
     this->flushPendingCommands(kSilent_PlaybackMode);
+    fPipeController.waitForPlayback();
     SkSafeUnref(fImmediateCanvas);
     SkSafeUnref(fSurface);
 }
@@ -310,7 +568,7 @@ void SkDeferredDevice::setMaxRecordingStorage(size_t maxStorage) {
 void SkDeferredDevice::beginRecording() {
     SkASSERT(NULL == fRecordingCanvas);
     fRecordingCanvas = fPipeWriter.startRecording(&fPipeController, 0,
-        immediateDevice()->width(), immediateDevice()->height());
+        this->width(), this->height());
 }
 
 void SkDeferredDevice::setNotificationClient(
@@ -345,6 +603,7 @@ void SkDeferredDevice::aboutToDraw()
     }
     if (fCanDiscardCanvasContents) {
         if (NULL != fSurface) {
+            fPipeController.waitForPlayback();
             fSurface->notifyContentWillChange(SkSurface::kDiscard_ContentChangeMode);
         }
         fCanDiscardCanvasContents = false;
@@ -373,7 +632,11 @@ void SkDeferredDevice::flushPendingCommands(PlaybackMode playbackMode) {
 
 void SkDeferredDevice::flush() {
     this->flushPendingCommands(kNormal_PlaybackMode);
-    fImmediateCanvas->flush();
+    // With a playback thread this only hands the commands over. Its surface
+    // is raster (see setThreadedPlayback), so there is nothing else to flush.
+    if (!fPipeController.isThreaded()) {
+        fImmediateCanvas->flush();
+    }
 }
 
 size_t SkDeferredDevice::freeMemoryIfPossible(size_t bytesToFree) {
@@ -404,6 +667,12 @@ void SkDeferredDevice::recordedDrawCommand() {
         if (this->freeMemoryIfPossible(tryFree) < tryFree) {
             // Flush is necessary to free more space.
             this->flushPendingCommands(kNormal_PlaybackMode);
+            // A playback thread frees the blocks and releases the bitmaps as
+            // it goes, so recording waits for it rather than outgrow the limit.
+            if (fPipeController.isThreaded() &&
+                this->storageAllocatedForRecording() > fMaxRecordingStorageBytes) {
+                fPipeController.waitForPlayback();
+            }
             // Free as much as possible to avoid oscillating around fMaxRecordingStorageBytes
             // which could cause a high flushing frequency.
             this->freeMemoryIfPossible(~0U);
@@ -422,29 +691,40 @@ SkCanvas* SkDeferredDevice::recordingCanvas() {
     return fRecordingCanvas;
 }
 
+bool SkDeferredDevice::setThreadedPlayback(bool threaded) {
+    // A GPU context can only be used from the thread it was made on.
+    if (threaded && NULL != this->immediateDevice()->accessRenderTarget()) {
+        return false;
+    }
+    // The blocks recorded so far were allocated for the current mode.
+    this->flushPendingCommands(kNormal_PlaybackMode);
+    return fPipeController.setThreadedPlayback(threaded);
+}
+
 SkImage* SkDeferredDevice::newImageSnapshot() {
     this->flush();
+    fPipeController.waitForPlayback();
     return fSurface ? fSurface->newImageSnapshot() : NULL;
 }
 
 int SkDeferredDevice::width() const {
-    return immediateDevice()->width();
+    return fImmediateInfo.width();
 }
 
 int SkDeferredDevice::height() const {
-    return immediateDevice()->height();
+    return fImmediateInfo.height();
 }
 
 SkBitmap::Config SkDeferredDevice::config() const {
-    return immediateDevice()->config();
+    return fImmediateConfig;
 }
 
 bool SkDeferredDevice::isOpaque() const {
-    return immediateDevice()->isOpaque();
+    return fImmediateInfo.isOpaque();
 }
 
 SkImageInfo SkDeferredDevice::imageInfo() const {
-    return immediateDevice()->imageInfo();
+    return fImmediateInfo;
 }
 
 GrRenderTarget* SkDeferredDevice::accessRenderTarget() {
@@ -462,10 +742,12 @@ void SkDeferredDevice::prepareForImmediatePixelWrite() {
         bool mustNotifyDirectly = !fCanDiscardCanvasContents;
         this->aboutToDraw();
         if (mustNotifyDirectly) {
+            fPipeController.waitForPlayback();
             fSurface->notifyContentWillChange(SkSurface::kRetain_ContentChangeMode);
         }
     }
 
+    fPipeController.waitForPlayback();
     fImmediateCanvas->flush();
 }
 
@@ -509,7 +791,7 @@ SkSurface* SkDeferredDevice::newSurface(const SkImageInfo& info) {
 bool SkDeferredDevice::onReadPixels(const SkImageInfo& info, void* pixels, size_t rowBytes,
                                     int x, int y) {
     this->flushPendingCommands(kNormal_PlaybackMode);
-    return fImmediateCanvas->readPixels(info, pixels, rowBytes, x, y);
+    return this->immediateCanvas()->readPixels(info, pixels, rowBytes, x, y);
 }
 
 class AutoImmediateDrawIfNeeded {
@@ -643,6 +925,12 @@ SkSurface* SkDeferredCanvas::setSurface(SkSurface* surface) {
     return surface;
 }
 
+bool SkDeferredCanvasUtils::SetThreadedPlayback(SkDeferredCanvas* canvas, bool threaded) {
+    SkDeferredDevice* deferredDevice = static_cast<SkDeferredDevice*>(canvas->getDevice());
+    SkASSERT(deferredDevice);
+    return deferredDevice->setThreadedPlayback(threaded);
+}
+
 SkDeferredCanvas::NotificationClient* SkDeferredCanvas::setNotificationClient(
     NotificationClient* notificationClient) {
 
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkDeferredCanvasUtils_DEFINED
+#define SkDeferredCanvasUtils_DEFINED
+
+#include "SkTypes.h"
+
+class SkDeferredCanvas;
+
+class SK_API SkDeferredCanvasUtils {
+public:
+    /**
+     *  Have the canvas play its commands back into its surface on a thread
+     *  of its own (threaded is true), or on the thread that flushes them
+     *  (the default). Pending commands are flushed first.
+     *
+     *  With a playback thread, a flush only hands the recorded commands over,
+     *  at most 16 flushes ahead of playback, and returns. The notification
+     *  client's flushedDrawCommands() is then called once the commands have
+     *  been handed over, not drawn. Anything that needs the surface's pixels
+     *  or draws to it directly (newImageSnapshot(), readPixels(),
+     *  writePixels(), immediateCanvas(), drawing with deferral turned off)
+     *  waits for playback to catch up.
+     *
+     *  Only raster surfaces can be played back into from another thread, and
+     *  setSurface() must not be given any other kind while this is on.
+     *
+     *  Returns false, and leaves the canvas playing back on the flushing
+     *  thread, if the surface is not raster or the thread can not be started.
+     */
+    static bool SetThreadedPlayback(SkDeferredCanvas*, bool threaded);
+};
+
+#endif
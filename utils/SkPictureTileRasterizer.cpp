@@ -0,0 +1,131 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkPictureTileRasterizer.h"
+#include "SkCanvas.h"
+#include "SkPicture.h"
+#include "SkThread.h"
+#include "SkWorkerPool.h"
+
+/**
+ *  Draws tiles with one picture clone until there are none left. All of the
+ *  workers share fNextTile, so each tile is claimed by exactly one of them.
+ */
+class SkPictureTileRasterizer::Worker {
+public:
+    Worker() : fPicture(NULL), fTiles(NULL), fBitmaps(NULL), fCount(0),
+               fNextTile(NULL), fFailed(NULL) {}
+
+    void init(SkPicture* picture, const SkIRect tiles[], SkBitmap bitmaps[], int count,
+              int32_t* nextTile, int32_t* failed) {
+        fPicture = picture;
+        fTiles = tiles;
+        fBitmaps = bitmaps;
+        fCount = count;
+        fNextTile = nextTile;
+        fFailed = failed;
+    }
+
+    // SkParallel::Proc, over an array of workers.
+    static void Run(void* workers, int index) {
+        static_cast<Worker*>(workers)[index].run();
+    }
+
+    void run() {
+        int index;
+        while ((index = sk_atomic_inc(fNextTile)) < fCount) {
+            if (!this->drawTile(fTiles[index], &fBitmaps[index])) {
+                sk_atomic_inc(fFailed);
+            }
+        }
+    }
+
+private:
+    SkPicture*      fPicture;
+    const SkIRect*  fTiles;
+    SkBitmap*       fBitmaps;
+    int             fCount;
+    int32_t*        fNextTile;
+    int32_t*        fFailed;
+
+    bool drawTile(const SkIRect& tile, SkBitmap* bitmap) {
+        if (tile.isEmpty() || !bitmap->allocN32Pixels(tile.width(), tile.height())) {
+            bitmap->reset();
+            return false;
+        }
+        bitmap->eraseColor(SK_ColorTRANSPARENT);
+
+        SkCanvas canvas(*bitmap);
+        canvas.translate(-SkIntToScalar(tile.fLeft), -SkIntToScalar(tile.fTop));
+        // Clip to the tile, so that playback can skip the ops outside of it
+        // (through the picture's bounding box hierarchy, if it has one).
+        canvas.clipRect(SkRect::Make(tile));
+        fPicture->draw(&canvas);
+        return true;
+    }
+};
+
+SkPictureTileRasterizer::SkPictureTileRasterizer(SkPicture* picture, SkWorkerPool* pool)
+    : fPicture(SkRef(picture))
+    , fPool(pool)
+    , fClones(NULL)
+    , fCloneCount(0) {
+}
+
+SkPictureTileRasterizer::~SkPictureTileRasterizer() {
+    SkDELETE_ARRAY(fClones);
+    fPicture->unref();
+}
+
+void SkPictureTileRasterizer::ComputeTileGrid(int pictureWidth, int pictureHeight,
+                                              int tileWidth, int tileHeight,
+                                              SkTDArray<SkIRect>* tiles) {
+    SkASSERT(tiles);
+    SkASSERT(tileWidth > 0 && tileHeight > 0);
+
+    tiles->rewind();
+    for (int y = 0; y < pictureHeight; y += tileHeight) {
+        for (int x = 0; x < pictureWidth; x += tileWidth) {
+            tiles->append()->setLTRB(x, y,
+                                     SkMin32(x + tileWidth, pictureWidth),
+                                     SkMin32(y + tileHeight, pictureHeight));
+        }
+    }
+}
+
+bool SkPictureTileRasterizer::rasterize(const SkIRect tiles[], int count, SkBitmap bitmaps[]) {
+    if (count <= 0) {
+        return true;
+    }
+
+    // parallelFor runs workers on the calling thread too.
+    const int workerCount = fPool ? fPool->concurrency() : 1;
+    if (NULL == fClones) {
+        // SkPicture::draw is not thread-safe, but clones can be drawn
+        // concurrently and share all of the picture's immutable data.
+        fCloneCount = workerCount;
+        fClones = SkNEW_ARRAY(SkPicture, fCloneCount);
+        fPicture->clone(fClones, fCloneCount);
+    }
+    SkASSERT(fCloneCount == workerCount);
+
+    int32_t nextTile = 0;
+    int32_t failed = 0;
+    const int runCount = SkMin32(workerCount, count);
+    SkAutoTArray<Worker> workers(runCount);
+    for (int i = 0; i < runCount; ++i) {
+        workers[i].init(&fClones[i], tiles, bitmaps, count, &nextTile, &failed);
+    }
+    if (fPool) {
+        // Unlike add() and waiting, this is safe on one of the pool's threads.
+        fPool->parallelFor(runCount, Worker::Run, workers.get());
+    } else {
+        workers[0].run();
+    }
+
+    return 0 == failed;
+}
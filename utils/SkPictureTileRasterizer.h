@@ -0,0 +1,66 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPictureTileRasterizer_DEFINED
+#define SkPictureTileRasterizer_DEFINED
+
+#include "SkBitmap.h"
+#include "SkRect.h"
+#include "SkTDArray.h"
+
+class SkPicture;
+class SkWorkerPool;
+
+/**
+ *  Rasterizes a picture into a set of tiles, in parallel.
+ *
+ *  Each worker thread plays back its own clone of the picture (see
+ *  SkPicture::clone), so the op stream, the bounding box hierarchy and the
+ *  flattened data are shared between the threads rather than copied. Tiles
+ *  are handed out to the workers one at a time, so uneven tiles still keep
+ *  every thread busy.
+ */
+class SkPictureTileRasterizer : SkNoncopyable {
+public:
+    /**
+     *  The picture is ref'd, and must not be recorded into while this object
+     *  exists. If pool is NULL, the tiles are rasterized on the caller's
+     *  thread. Otherwise they are rasterized through pool->parallelFor(), on
+     *  the caller's thread and the pool's, so rasterize() may be called from
+     *  one of the pool's own threads.
+     */
+    SkPictureTileRasterizer(SkPicture*, SkWorkerPool*);
+    ~SkPictureTileRasterizer();
+
+    /**
+     *  Fill tiles with a grid of tileWidth x tileHeight rects covering the
+     *  picture's bounds, in row-major order. The tiles in the last row and
+     *  column are clipped to the picture.
+     */
+    static void ComputeTileGrid(int pictureWidth, int pictureHeight,
+                                int tileWidth, int tileHeight,
+                                SkTDArray<SkIRect>* tiles);
+
+    /**
+     *  Rasterize the picture into count N32 premul bitmaps, one per tile. Each
+     *  bitmap is the size of its tile, and holds the part of the picture that
+     *  falls inside that tile (in picture coordinates). Returns false if any
+     *  of the bitmaps could not be allocated.
+     */
+    bool rasterize(const SkIRect tiles[], int count, SkBitmap bitmaps[]);
+
+private:
+    class Worker;
+
+    SkPicture*      fPicture;
+    SkWorkerPool*   fPool;
+    // one per worker, created by the first call to rasterize()
+    SkPicture*      fClones;
+    int             fCloneCount;
+};
+
+#endif
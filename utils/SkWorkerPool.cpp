@@ -0,0 +1,200 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkWorkerPool.h"
+#include "SkRefCnt.h"
+#include "SkRunnable.h"
+#include "SkThread.h"
+#include "SkThreadUtils.h"
+
+#if defined(SK_BUILD_FOR_WIN32)
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+int SkWorkerPool::CoreCount() {
+#if defined(SK_BUILD_FOR_WIN32)
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    return SkMax32(1, sysinfo.dwNumberOfProcessors);
+#elif defined(_SC_NPROCESSORS_ONLN)
+    return SkMax32(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+#else
+    return 1;
+#endif
+}
+
+SkWorkerPool::SkWorkerPool(int count)
+    : fHead(0)
+    , fRunning(0)
+    , fDone(false) {
+    if (count < 0) {
+        count = CoreCount();
+    }
+    for (int i = 0; i < count; ++i) {
+        SkThread* thread = SkNEW_ARGS(SkThread, (&SkWorkerPool::Loop, this));
+        if (!thread->start()) {
+            SkDELETE(thread);
+            break;
+        }
+        *fThreads.append() = thread;
+    }
+}
+
+SkWorkerPool::~SkWorkerPool() {
+    this->wait();
+
+    fReady.lock();
+    fDone = true;
+    fReady.broadcast();
+    fReady.unlock();
+
+    for (int i = 0; i < fThreads.count(); ++i) {
+        fThreads[i]->join();
+        SkDELETE(fThreads[i]);
+    }
+}
+
+void SkWorkerPool::add(SkRunnable* r) {
+    SkASSERT(r);
+    if (0 == fThreads.count()) {
+        r->run();
+        return;
+    }
+
+    fReady.lock();
+    SkASSERT(!fDone);
+    *fQueue.append() = r;
+    fReady.signal();
+    fReady.unlock();
+}
+
+void SkWorkerPool::wait() {
+    fReady.lock();
+    while (fHead < fQueue.count() || fRunning > 0) {
+        fReady.wait();
+    }
+    fReady.unlock();
+}
+
+void SkWorkerPool::Loop(void* arg) {
+    SkWorkerPool* pool = static_cast<SkWorkerPool*>(arg);
+
+    pool->fReady.lock();
+    for (;;) {
+        while (pool->fHead == pool->fQueue.count() && !pool->fDone) {
+            pool->fReady.wait();
+        }
+        if (pool->fHead == pool->fQueue.count()) {
+            SkASSERT(pool->fDone);
+            break;
+        }
+
+        SkRunnable* r = pool->fQueue[pool->fHead++];
+        if (pool->fHead == pool->fQueue.count()) {
+            // the queue is drained, so recycle its storage
+            pool->fQueue.rewind();
+            pool->fHead = 0;
+        }
+        pool->fRunning += 1;
+        pool->fReady.unlock();
+
+        r->run();
+
+        pool->fReady.lock();
+        pool->fRunning -= 1;
+        // wake up anyone in wait()
+        pool->fReady.broadcast();
+    }
+    pool->fReady.unlock();
+}
+
+namespace {
+
+// Shared between the caller of parallelFor() and the helpers it queued.
+// Helpers may not get to run until after the call has returned, so each one
+// holds a ref.
+class ParallelForState : public SkRefCnt {
+public:
+    ParallelForState(int count, SkParallel::Proc proc, void* context)
+        : fProc(proc)
+        , fContext(context)
+        , fCount(count)
+        , fNext(0)
+        , fFinished(0) {}
+
+    // Claim and run indices until there are none left.
+    void drain() {
+        for (;;) {
+            int32_t index = sk_atomic_inc(&fNext);
+            if (index >= fCount) {
+                return;
+            }
+            fProc(fContext, index);
+            if (sk_atomic_inc(&fFinished) + 1 == fCount) {
+                fDone.lock();
+                fDone.broadcast();
+                fDone.unlock();
+            }
+        }
+    }
+
+    // Block until every index has finished running.
+    void wait() {
+        fDone.lock();
+        while (fFinished < fCount) {
+            fDone.wait();
+        }
+        fDone.unlock();
+    }
+
+private:
+    SkParallel::Proc    fProc;
+    void*               fContext;
+    int32_t             fCount;
+    int32_t             fNext;
+    int32_t             fFinished;
+    SkCondVar           fDone;
+
+    typedef SkRefCnt INHERITED;
+};
+
+class ParallelForRunnable : public SkRunnable {
+public:
+    explicit ParallelForRunnable(ParallelForState* state) : fState(SkRef(state)) {}
+
+    virtual void run() SK_OVERRIDE {
+        fState->drain();
+        SkDELETE(this);
+    }
+
+private:
+    SkAutoTUnref<ParallelForState> fState;
+};
+
+}  // namespace
+
+void SkWorkerPool::parallelFor(int count, SkParallel::Proc proc, void* context) {
+    if (count <= 0) {
+        return;
+    }
+    if (1 == count || 0 == fThreads.count()) {
+        for (int i = 0; i < count; ++i) {
+            proc(context, i);
+        }
+        return;
+    }
+
+    SkAutoTUnref<ParallelForState> state(SkNEW_ARGS(ParallelForState, (count, proc, context)));
+    int helpers = SkMin32(count - 1, fThreads.count());
+    for (int i = 0; i < helpers; ++i) {
+        this->add(SkNEW_ARGS(ParallelForRunnable, (state.get())));
+    }
+    state->drain();
+    state->wait();
+}
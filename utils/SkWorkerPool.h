@@ -0,0 +1,90 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkWorkerPool_DEFINED
+#define SkWorkerPool_DEFINED
+
+#include "SkCondVar.h"
+#include "SkParallel.h"
+#include "SkTDArray.h"
+#include "SkTypes.h"
+
+class SkRunnable;
+class SkThread;
+
+/**
+ *  A fixed set of SkThreads that run SkRunnables from a shared FIFO queue.
+ *
+ *  The pool does not take ownership of the runnables it is given. To find out
+ *  when a particular batch of work is done, either call wait(), which returns
+ *  once every runnable added so far has finished, or have the runnables
+ *  signal an SkCountdown.
+ *
+ *  A pool can also serve as the SkParallel executor, so that core and effects
+ *  code can spread work over its threads:
+ *
+ *      SkWorkerPool pool;
+ *      SkParallel::SetExecutor(&pool);
+ */
+class SkWorkerPool : public SkParallel::Executor, SkNoncopyable {
+public:
+    enum {
+        // Pass to the constructor to get one thread per online CPU core.
+        kThreadPerCore = -1
+    };
+
+    /**
+     *  Create a pool with the specified number of threads. If count is 0, no
+     *  threads are created, and add() runs each runnable immediately on the
+     *  caller's thread.
+     */
+    explicit SkWorkerPool(int count = kThreadPerCore);
+
+    /**
+     *  Waits for all of the queued work to finish, then joins the threads.
+     */
+    ~SkWorkerPool();
+
+    /**
+     *  Queue a runnable to be run on one of the pool's threads.
+     */
+    void add(SkRunnable*);
+
+    /**
+     *  Block until every runnable added so far has finished running.
+     */
+    void wait();
+
+    int threadCount() const { return fThreads.count(); }
+
+    /**
+     *  SkParallel::Executor. The calling thread runs indices too, and only
+     *  waits for the ones already started elsewhere, so this is safe to call
+     *  from one of the pool's own threads.
+     */
+    virtual void parallelFor(int count, SkParallel::Proc, void* context) SK_OVERRIDE;
+    virtual int concurrency() const SK_OVERRIDE { return fThreads.count() + 1; }
+
+    /**
+     *  Returns the number of CPU cores available to this process (at least 1).
+     */
+    static int CoreCount();
+
+private:
+    SkTDArray<SkThread*>    fThreads;
+    // Guards everything below; signaled when work is queued, when a runnable
+    // finishes, and at shutdown.
+    SkCondVar               fReady;
+    SkTDArray<SkRunnable*>  fQueue;
+    int                     fHead;      // index of the next runnable in fQueue
+    int                     fRunning;   // number of runnables being run
+    bool                    fDone;
+
+    static void Loop(void*);
+};
+
+#endif